@@ -0,0 +1,238 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include "syscfg/syscfg.h"
+#include "sysinit/sysinit.h"
+#include "sysflash/sysflash.h"
+#include <flash_map/flash_map.h>
+#include <hal/hal_flash.h>
+#include <hal/hal_bsp.h>
+#include <hal/hal_flash_int.h>
+#include "mcu/mcu_sim.h"
+#include "bootutil/image.h"
+#include "bootutil/bootutil.h"
+#include "mbedtls/sha256.h"
+
+/*
+ * Swaps images of increasing size through boot_go(), and prints how long
+ * each swap took.  Each size is run twice: once with two unrelated images,
+ * and once with images which differ only at the start, as they would after
+ * a small patch.
+ *
+ * Runs on the native target.  Besides wall clock time, prints the time the
+ * flash simulator charged for the swap and the number of sector erases;
+ * set MCU_NATIVE_FLASH_xxx to model a particular part.
+ */
+
+#define BENCH_HDR_SIZE          32
+#define BENCH_STEPS             8
+
+static uint8_t bench_buf[1024];
+
+static uint8_t
+bench_byte_at(uint8_t seed, uint32_t off)
+{
+    uint32_t x;
+
+    x = (off / 4) * 2654435761u + seed;
+    return x >> ((off % 4) * 8);
+}
+
+static void
+bench_write_image(int slot, uint32_t img_sz, uint8_t seed, uint32_t diff_sz)
+{
+    const struct flash_area *fap;
+    mbedtls_sha256_context ctx;
+    struct image_header hdr;
+    struct image_tlv tlv;
+    uint8_t hash[32];
+    uint32_t off;
+    uint32_t chunk_sz;
+    uint32_t i;
+    int rc;
+
+    rc = flash_area_open(flash_area_id_from_image_slot(slot), &fap);
+    assert(rc == 0);
+
+    memset(&hdr, 0, sizeof hdr);
+    hdr.ih_magic = IMAGE_MAGIC;
+    hdr.ih_tlv_size = sizeof tlv + sizeof hash;
+    hdr.ih_hdr_size = BENCH_HDR_SIZE;
+    hdr.ih_img_size = img_sz;
+    hdr.ih_flags = IMAGE_F_SHA256;
+    hdr.ih_ver.iv_major = slot;
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+
+    memset(bench_buf, 0xff, BENCH_HDR_SIZE);
+    memcpy(bench_buf, &hdr, sizeof hdr);
+    rc = flash_area_write(fap, 0, bench_buf, BENCH_HDR_SIZE);
+    assert(rc == 0);
+    mbedtls_sha256_update(&ctx, bench_buf, BENCH_HDR_SIZE);
+
+    for (off = 0; off < img_sz; off += chunk_sz) {
+        chunk_sz = img_sz - off;
+        if (chunk_sz > sizeof bench_buf) {
+            chunk_sz = sizeof bench_buf;
+        }
+        for (i = 0; i < chunk_sz; i++) {
+            if (off + i < diff_sz) {
+                bench_buf[i] = bench_byte_at(seed, off + i);
+            } else {
+                bench_buf[i] = bench_byte_at(0, off + i);
+            }
+        }
+        rc = flash_area_write(fap, BENCH_HDR_SIZE + off, bench_buf, chunk_sz);
+        assert(rc == 0);
+        mbedtls_sha256_update(&ctx, bench_buf, chunk_sz);
+    }
+    mbedtls_sha256_finish(&ctx, hash);
+
+    off = BENCH_HDR_SIZE + img_sz;
+    tlv.it_type = IMAGE_TLV_SHA256;
+    tlv._pad = 0;
+    tlv.it_len = sizeof hash;
+    rc = flash_area_write(fap, off, &tlv, sizeof tlv);
+    assert(rc == 0);
+    rc = flash_area_write(fap, off + sizeof tlv, hash, sizeof hash);
+    assert(rc == 0);
+
+    flash_area_close(fap);
+}
+
+static void
+bench_erase(int area_id)
+{
+    const struct flash_area *fap;
+    int rc;
+
+    rc = flash_area_open(area_id, &fap);
+    assert(rc == 0);
+    rc = flash_area_erase(fap, 0, fap->fa_size);
+    assert(rc == 0);
+    flash_area_close(fap);
+}
+
+struct bench_result {
+    uint32_t br_wall_us;
+    uint32_t br_flash_us;
+    uint32_t br_erases;
+};
+
+static uint32_t
+bench_usecs(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000 +
+           (end->tv_nsec - start->tv_nsec) / 1000;
+}
+
+static uint32_t
+bench_erases(void)
+{
+    const struct hal_flash *hf;
+    uint32_t cnt;
+    int i;
+
+    hf = hal_bsp_flash_dev(0);
+    cnt = 0;
+    for (i = 0; i < hf->hf_sector_cnt; i++) {
+        cnt += native_flash_erase_cnt(i);
+    }
+    return cnt;
+}
+
+/**
+ * Runs one swap, and reports what it cost.
+ */
+static void
+bench_swap(uint32_t img_sz, uint32_t diff_sz, struct bench_result *res)
+{
+    struct timespec start;
+    struct timespec end;
+    struct boot_rsp rsp;
+    uint64_t busy_ns;
+    uint32_t erases;
+    int rc;
+
+    bench_erase(FLASH_AREA_IMAGE_0);
+    bench_erase(FLASH_AREA_IMAGE_1);
+    bench_erase(FLASH_AREA_IMAGE_SCRATCH);
+
+    bench_write_image(0, img_sz, 1, diff_sz);
+    bench_write_image(1, img_sz, 2, diff_sz);
+
+    rc = boot_set_pending();
+    assert(rc == 0);
+
+    busy_ns = native_flash_busy_ns();
+    erases = bench_erases();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    rc = boot_go(&rsp);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    assert(rc == 0);
+    assert(rsp.br_hdr->ih_ver.iv_major == 1);
+
+    res->br_wall_us = bench_usecs(&start, &end);
+    res->br_flash_us = (native_flash_busy_ns() - busy_ns) / 1000;
+    res->br_erases = bench_erases() - erases;
+}
+
+int
+main(int argc, char **argv)
+{
+    const struct flash_area *fap;
+    struct bench_result full;
+    struct bench_result patch;
+    uint32_t max_sz;
+    uint32_t img_sz;
+    int rc;
+    int i;
+
+    sysinit();
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fap);
+    assert(rc == 0);
+
+    /* Leave room for the TLVs and the trailer. */
+    max_sz = fap->fa_size - BENCH_HDR_SIZE - 4096;
+    flash_area_close(fap);
+
+    printf("copy buf %d bytes\n", MYNEWT_VAL(BOOTUTIL_COPY_BUF_SIZE));
+    printf("%8s | %10s %10s %6s | %10s %10s %6s\n", "image",
+           "full (us)", "flash (us)", "erases",
+           "patch (us)", "flash (us)", "erases");
+    for (i = 1; i <= BENCH_STEPS; i++) {
+        img_sz = max_sz / BENCH_STEPS * i;
+        bench_swap(img_sz, img_sz, &full);
+        bench_swap(img_sz, sizeof bench_buf, &patch);
+        printf("%8" PRIu32 " | %10" PRIu32 " %10" PRIu32 " %6" PRIu32
+               " | %10" PRIu32 " %10" PRIu32 " %6" PRIu32 "\n", img_sz,
+               full.br_wall_us, full.br_flash_us, full.br_erases,
+               patch.br_wall_us, patch.br_flash_us, patch.br_erases);
+    }
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
+#include "cbmem/cbmem.h"
+
+/*
+ * BENCH_TASKS producer tasks, each at its own priority, append to one
+ * cbmem.  Each sleeps for a tick now and then, so that higher priority
+ * producers wake up in the middle of lower priority ones' appends.  The
+ * run is repeated with every append wrapped in a mutex, the way
+ * cbmem_append() used to serialize writers.  After each run, the contents
+ * are walked and checked.  Meant for the sim arch.
+ */
+
+#define BENCH_TASKS             4
+#define BENCH_APPENDS           20000
+#define BENCH_YIELD_EVERY       32
+#define BENCH_ENTRY_SIZE        32
+#define BENCH_BUF_SIZE          4096
+
+#define BENCH_CTRL_PRIO         1
+#define BENCH_PROD_PRIO         2
+#define BENCH_STACK_SIZE        OS_STACK_ALIGN(256)
+
+static struct cbmem bench_cbmem;
+static uint32_t bench_buf[BENCH_BUF_SIZE / 4];
+
+static struct os_mutex bench_mutex;
+static int bench_use_mutex;
+
+static struct os_sem bench_go[BENCH_TASKS];
+static struct os_sem bench_done;
+
+static struct os_task bench_prod_task[BENCH_TASKS];
+static os_stack_t bench_prod_stack[BENCH_TASKS][BENCH_STACK_SIZE];
+static struct os_task bench_ctrl_task;
+static os_stack_t bench_ctrl_stack[BENCH_STACK_SIZE];
+
+static int
+bench_append(void *data, uint16_t len)
+{
+    int rc;
+
+    if (!bench_use_mutex) {
+        return cbmem_append(&bench_cbmem, data, len);
+    }
+
+    os_mutex_pend(&bench_mutex, OS_WAIT_FOREVER);
+    rc = cbmem_append(&bench_cbmem, data, len);
+    os_mutex_release(&bench_mutex);
+
+    return rc;
+}
+
+static void
+bench_prod_handler(void *arg)
+{
+    uint8_t entry[BENCH_ENTRY_SIZE];
+    int id;
+    int i;
+
+    id = (intptr_t)arg;
+    while (1) {
+        os_sem_pend(&bench_go[id], OS_TIMEOUT_NEVER);
+
+        for (i = 0; i < BENCH_APPENDS; i++) {
+            memset(entry, id, sizeof(entry));
+            entry[1] = i;
+            bench_append(entry, sizeof(entry));
+            if (i % BENCH_YIELD_EVERY == id) {
+                os_time_delay(1);
+            }
+        }
+
+        os_sem_release(&bench_done);
+    }
+}
+
+static int
+bench_check_entry(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
+                  void *arg)
+{
+    uint8_t entry[BENCH_ENTRY_SIZE];
+    int rc;
+    int i;
+
+    assert(hdr->ceh_flags & CBMEM_ENTRY_F_READY);
+    rc = cbmem_read(cbmem, hdr, entry, 0, sizeof(entry));
+    assert(rc == sizeof(entry));
+    assert(entry[0] < BENCH_TASKS);
+    for (i = 2; i < sizeof(entry); i++) {
+        assert(entry[i] == entry[0]);
+    }
+    (*(int *)arg)++;
+
+    return 0;
+}
+
+static void
+bench_run(const char *name)
+{
+    uint32_t start;
+    uint32_t usecs;
+    int cnt;
+    int i;
+
+    cbmem_init(&bench_cbmem, bench_buf, sizeof(bench_buf));
+
+    start = os_cputime_get32();
+    for (i = 0; i < BENCH_TASKS; i++) {
+        os_sem_release(&bench_go[i]);
+    }
+    for (i = 0; i < BENCH_TASKS; i++) {
+        os_sem_pend(&bench_done, OS_TIMEOUT_NEVER);
+    }
+    usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+
+    cnt = 0;
+    cbmem_walk(&bench_cbmem, bench_check_entry, &cnt);
+    assert(cnt > 0);
+
+    printf("%8s %10lu %10.3f %8d %8lu\n", name, (unsigned long)usecs,
+           (double)usecs / (BENCH_TASKS * BENCH_APPENDS), cnt,
+           (unsigned long)cbmem_dropped(&bench_cbmem));
+}
+
+static void
+bench_ctrl_handler(void *arg)
+{
+    printf("%d tasks x %d appends of %d bytes, %d byte buffer\n",
+           BENCH_TASKS, BENCH_APPENDS, BENCH_ENTRY_SIZE, BENCH_BUF_SIZE);
+    printf("%8s %10s %10s %8s %8s\n",
+           "append", "us", "us/append", "entries", "dropped");
+
+    bench_use_mutex = 0;
+    bench_run("cbmem");
+
+    bench_use_mutex = 1;
+    bench_run("mutex");
+
+    while (1) {
+        os_time_delay(OS_TICKS_PER_SEC);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    int rc;
+    int i;
+
+    sysinit();
+
+    os_mutex_init(&bench_mutex);
+    os_sem_init(&bench_done, 0);
+
+    for (i = 0; i < BENCH_TASKS; i++) {
+        os_sem_init(&bench_go[i], 0);
+        rc = os_task_init(&bench_prod_task[i], "prod", bench_prod_handler,
+                          (void *)(intptr_t)i, BENCH_PROD_PRIO + i, OS_WAIT_FOREVER,
+                          bench_prod_stack[i], BENCH_STACK_SIZE);
+        assert(rc == 0);
+    }
+    rc = os_task_init(&bench_ctrl_task, "ctrl", bench_ctrl_handler, NULL,
+                      BENCH_CTRL_PRIO, OS_WAIT_FOREVER, bench_ctrl_stack,
+                      BENCH_STACK_SIZE);
+    assert(rc == 0);
+
+    os_start();
+
+    assert(0);
+
+    return rc;
+}
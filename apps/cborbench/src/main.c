@@ -0,0 +1,306 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include "sysinit/sysinit.h"
+#include "os/os.h"
+#include "tinycbor/cbor.h"
+#include "tinycbor/cbor_mbuf_reader.h"
+#include "tinycbor/cbor_mbuf_writer.h"
+
+/*
+ * Decodes a 2KB log read style message from an mbuf chain, with the mbuf
+ * reader and with a reader which copies every access out of the chain from
+ * its head, as the mbuf reader used to.  Prints the time per decode.
+ *
+ * Small mbufs are used, as a request received over BLE or serial is made
+ * up of many of them.
+ */
+
+#define BENCH_MBUF_SIZE         64
+#define BENCH_MBUF_CNT          128
+#define BENCH_MSG_SIZE          2048
+#define BENCH_ITERS             2000
+
+static os_membuf_t bench_mbuf_mem[
+    OS_MEMPOOL_SIZE(BENCH_MBUF_CNT, BENCH_MBUF_SIZE)
+];
+static struct os_mempool bench_mbuf_mempool;
+static struct os_mbuf_pool bench_mbuf_pool;
+
+/* Reader which walks the chain from its head on every access. */
+struct bench_chain_reader {
+    struct cbor_decoder_reader r;
+    struct os_mbuf *m;
+};
+
+static uint8_t
+bench_chain_get8(struct cbor_decoder_reader *d, int offset)
+{
+    struct bench_chain_reader *cr = (struct bench_chain_reader *)d;
+    uint8_t val;
+
+    os_mbuf_copydata(cr->m, offset, sizeof(val), &val);
+    return val;
+}
+
+static uint16_t
+bench_chain_get16(struct cbor_decoder_reader *d, int offset)
+{
+    struct bench_chain_reader *cr = (struct bench_chain_reader *)d;
+    uint16_t val;
+
+    os_mbuf_copydata(cr->m, offset, sizeof(val), &val);
+    return ntohs(val);
+}
+
+static uint32_t
+bench_chain_get32(struct cbor_decoder_reader *d, int offset)
+{
+    struct bench_chain_reader *cr = (struct bench_chain_reader *)d;
+    uint32_t val;
+
+    os_mbuf_copydata(cr->m, offset, sizeof(val), &val);
+    return ntohl(val);
+}
+
+static uint64_t
+bench_chain_get64(struct cbor_decoder_reader *d, int offset)
+{
+    struct bench_chain_reader *cr = (struct bench_chain_reader *)d;
+    uint32_t val[2];
+
+    os_mbuf_copydata(cr->m, offset, sizeof(val), val);
+    return ((uint64_t)ntohl(val[0]) << 32) | ntohl(val[1]);
+}
+
+static uintptr_t
+bench_chain_cmp(struct cbor_decoder_reader *d, char *buf, int offset,
+                size_t len)
+{
+    struct bench_chain_reader *cr = (struct bench_chain_reader *)d;
+
+    return os_mbuf_cmpf(cr->m, offset, buf, len);
+}
+
+static uintptr_t
+bench_chain_cpy(struct cbor_decoder_reader *d, char *dst, int offset,
+                size_t len)
+{
+    struct bench_chain_reader *cr = (struct bench_chain_reader *)d;
+
+    return os_mbuf_copydata(cr->m, offset, len, dst) == 0;
+}
+
+static const uint8_t *
+bench_chain_ptr(struct cbor_decoder_reader *d, int offset, size_t *len)
+{
+    struct bench_chain_reader *cr = (struct bench_chain_reader *)d;
+    struct os_mbuf *m;
+    uint16_t off;
+
+    m = os_mbuf_off(cr->m, offset, &off);
+    if (m == NULL || off >= m->om_len) {
+        *len = 0;
+        return NULL;
+    }
+    *len = m->om_len - off;
+    return m->om_data + off;
+}
+
+static void
+bench_chain_reader_init(struct bench_chain_reader *cr, struct os_mbuf *m)
+{
+    cr->r.get8 = bench_chain_get8;
+    cr->r.get16 = bench_chain_get16;
+    cr->r.get32 = bench_chain_get32;
+    cr->r.get64 = bench_chain_get64;
+    cr->r.cmp = bench_chain_cmp;
+    cr->r.cpy = bench_chain_cpy;
+    cr->r.ptr = bench_chain_ptr;
+    cr->r.message_size = OS_MBUF_PKTLEN(m);
+    cr->m = m;
+}
+
+/*
+ * Builds {"name": "log", "type": 1, "entries": [{"msg": ..., "ts": ...,
+ * "level": ..., "index": ..., "module": ...}, ...]} of about size bytes.
+ */
+static struct os_mbuf *
+bench_build(int size)
+{
+    struct CborMbufWriter writer;
+    CborEncoder enc;
+    CborEncoder map;
+    CborEncoder entries;
+    CborEncoder entry;
+    struct os_mbuf *m;
+    char msg[32];
+    int i;
+
+    m = os_mbuf_get_pkthdr(&bench_mbuf_pool, 0);
+    assert(m != NULL);
+
+    cbor_mbuf_writer_init(&writer, m);
+    cbor_encoder_init(&enc, &writer.enc, 0);
+    cbor_encoder_create_map(&enc, &map, CborIndefiniteLength);
+    cbor_encode_text_stringz(&map, "name");
+    cbor_encode_text_stringz(&map, "log");
+    cbor_encode_text_stringz(&map, "type");
+    cbor_encode_uint(&map, 1);
+    cbor_encode_text_stringz(&map, "entries");
+    cbor_encoder_create_array(&map, &entries, CborIndefiniteLength);
+    for (i = 0; OS_MBUF_PKTLEN(m) < size - 64; i++) {
+        snprintf(msg, sizeof(msg), "log entry number %d", i);
+        cbor_encoder_create_map(&entries, &entry, CborIndefiniteLength);
+        cbor_encode_text_stringz(&entry, "msg");
+        cbor_encode_text_stringz(&entry, msg);
+        cbor_encode_text_stringz(&entry, "ts");
+        cbor_encode_int(&entry, 1000000000LL + i * 1234567);
+        cbor_encode_text_stringz(&entry, "level");
+        cbor_encode_uint(&entry, i % 4);
+        cbor_encode_text_stringz(&entry, "index");
+        cbor_encode_uint(&entry, i);
+        cbor_encode_text_stringz(&entry, "module");
+        cbor_encode_uint(&entry, 64 + i % 8);
+        cbor_encoder_close_container(&entries, &entry);
+    }
+    cbor_encoder_close_container(&map, &entries);
+    cbor_encoder_close_container(&enc, &map);
+
+    return m;
+}
+
+/* Visits every item, and copies out strings and integers. */
+static int
+bench_walk(CborValue *it)
+{
+    CborValue inner;
+    char buf[64];
+    size_t len;
+    int64_t val;
+    int cnt;
+
+    cnt = 0;
+    while (!cbor_value_at_end(it)) {
+        cnt++;
+        switch (cbor_value_get_type(it)) {
+        case CborMapType:
+        case CborArrayType:
+            cbor_value_enter_container(it, &inner);
+            cnt += bench_walk(&inner);
+            cbor_value_leave_container(it, &inner);
+            continue;
+        case CborTextStringType:
+            len = sizeof(buf);
+            cbor_value_copy_text_string(it, buf, &len, NULL);
+            break;
+        case CborIntegerType:
+            cbor_value_get_int64(it, &val);
+            break;
+        default:
+            break;
+        }
+        cbor_value_advance(it);
+    }
+    return cnt;
+}
+
+static uint32_t
+bench_usecs(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000 +
+           (end->tv_nsec - start->tv_nsec) / 1000;
+}
+
+static uint32_t
+bench_run(struct os_mbuf *m, int cursor, int *out_items)
+{
+    struct bench_chain_reader chain_reader;
+    struct CborMbufReader mbuf_reader;
+    struct cbor_decoder_reader *r;
+    struct timespec start;
+    struct timespec end;
+    CborParser parser;
+    CborValue it;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_ITERS; i++) {
+        if (cursor) {
+            cbor_mbuf_reader_init(&mbuf_reader, m, 0);
+            r = &mbuf_reader.r;
+        } else {
+            bench_chain_reader_init(&chain_reader, m);
+            r = &chain_reader.r;
+        }
+        cbor_parser_init(r, 0, &parser, &it);
+        *out_items = bench_walk(&it);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return bench_usecs(&start, &end);
+}
+
+int
+main(int argc, char **argv)
+{
+    struct os_mbuf *m;
+    struct os_mbuf *om;
+    uint32_t chain_us;
+    uint32_t cursor_us;
+    int chain_items;
+    int cursor_items;
+    int mbufs;
+    int rc;
+
+    sysinit();
+
+    rc = os_mempool_init(&bench_mbuf_mempool, BENCH_MBUF_CNT,
+                         BENCH_MBUF_SIZE, bench_mbuf_mem, "cborbench");
+    assert(rc == 0);
+    rc = os_mbuf_pool_init(&bench_mbuf_pool, &bench_mbuf_mempool,
+                           BENCH_MBUF_SIZE, BENCH_MBUF_CNT);
+    assert(rc == 0);
+
+    m = bench_build(BENCH_MSG_SIZE);
+    mbufs = 0;
+    for (om = m; om; om = SLIST_NEXT(om, om_next)) {
+        mbufs++;
+    }
+
+    chain_us = bench_run(m, 0, &chain_items);
+    cursor_us = bench_run(m, 1, &cursor_items);
+    assert(chain_items == cursor_items);
+
+    printf("%d bytes, %d mbufs, %d items\n", OS_MBUF_PKTLEN(m), mbufs,
+           cursor_items);
+    printf("%8s %12s %10s\n", "reader", "us/decode", "KB/s");
+    printf("%8s %12.2f %10.0f\n", "chain", (double)chain_us / BENCH_ITERS,
+           (double)OS_MBUF_PKTLEN(m) * BENCH_ITERS / chain_us * 1000000 / 1024);
+    printf("%8s %12.2f %10.0f\n", "cursor", (double)cursor_us / BENCH_ITERS,
+           (double)OS_MBUF_PKTLEN(m) * BENCH_ITERS / cursor_us * 1000000 / 1024);
+
+    os_mbuf_free_chain(m);
+    return 0;
+}
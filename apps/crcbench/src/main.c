@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <time.h>
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "crc/crc8.h"
+#include "crc/crc16.h"
+
+/*
+ * Checks crc8_calc() and crc16_ccitt() against bit-at-a-time versions,
+ * including when fed in odd sized pieces, then prints their throughput
+ * over flash block sized buffers.  Build with different CRC8_SLICES and
+ * CRC16_SLICES settings to compare table variants.
+ */
+
+#define BENCH_BUF_SIZE          4096
+#define BENCH_ITERS             2000
+
+static uint8_t bench_buf[BENCH_BUF_SIZE];
+
+static uint8_t
+bench_crc8_bitwise(uint8_t val, const uint8_t *buf, int cnt)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < cnt; i++) {
+        val ^= buf[i];
+        for (j = 0; j < 8; j++) {
+            val = (val & 0x80) ? (val << 1) ^ 0x07 : val << 1;
+        }
+    }
+    return val;
+}
+
+static uint16_t
+bench_crc16_bitwise(uint16_t crc, const uint8_t *buf, int len)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < len; i++) {
+        crc ^= buf[i] << 8;
+        for (j = 0; j < 8; j++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void
+bench_check(void)
+{
+    uint16_t crc16;
+    uint8_t crc8;
+    int off;
+    int len;
+
+    for (len = 0; len < 64; len++) {
+        for (off = 0; off < 8; off++) {
+            assert(crc8_calc(crc8_init(), bench_buf + off, len) ==
+                   bench_crc8_bitwise(crc8_init(), bench_buf + off, len));
+            assert(crc16_ccitt(CRC16_INITIAL_CRC, bench_buf + off, len) ==
+                   bench_crc16_bitwise(CRC16_INITIAL_CRC, bench_buf + off,
+                                       len));
+        }
+    }
+
+    /* Streaming: same result in pieces. */
+    crc8 = crc8_init();
+    crc16 = CRC16_INITIAL_CRC;
+    for (off = 0; off < BENCH_BUF_SIZE; off += len) {
+        len = 1 + off % 37;
+        if (off + len > BENCH_BUF_SIZE) {
+            len = BENCH_BUF_SIZE - off;
+        }
+        crc8 = crc8_calc(crc8, bench_buf + off, len);
+        crc16 = crc16_ccitt(crc16, bench_buf + off, len);
+    }
+    assert(crc8 == bench_crc8_bitwise(crc8_init(), bench_buf,
+                                      BENCH_BUF_SIZE));
+    assert(crc16 == bench_crc16_bitwise(CRC16_INITIAL_CRC, bench_buf,
+                                        BENCH_BUF_SIZE));
+}
+
+static uint32_t
+bench_usecs(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000 +
+           (end->tv_nsec - start->tv_nsec) / 1000;
+}
+
+static void
+bench_print(const char *name, uint32_t usecs)
+{
+    printf("%8s %12.3f %10.1f\n", name, (double)usecs / BENCH_ITERS,
+           (double)BENCH_BUF_SIZE * BENCH_ITERS / usecs);
+}
+
+int
+main(int argc, char **argv)
+{
+    struct timespec start;
+    struct timespec end;
+    volatile uint16_t crc16;
+    volatile uint8_t crc8;
+    int i;
+
+    sysinit();
+
+    for (i = 0; i < BENCH_BUF_SIZE; i++) {
+        bench_buf[i] = i * 31 + (i >> 8);
+    }
+    bench_check();
+
+    printf("%d byte buffer, CRC8_SLICES %d, CRC16_SLICES %d\n",
+           BENCH_BUF_SIZE, MYNEWT_VAL(CRC8_SLICES),
+           MYNEWT_VAL(CRC16_SLICES));
+    printf("%8s %12s %10s\n", "crc", "us/buffer", "MB/s");
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_ITERS; i++) {
+        crc8 = crc8_calc(crc8_init(), bench_buf, BENCH_BUF_SIZE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    bench_print("crc8", bench_usecs(&start, &end));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_ITERS; i++) {
+        crc16 = crc16_ccitt(CRC16_INITIAL_CRC, bench_buf, BENCH_BUF_SIZE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    bench_print("crc16", bench_usecs(&start, &end));
+
+    (void)crc8;
+    (void)crc16;
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "json/json.h"
+
+/*
+ * Encodes a log dump shaped like the one newtmgr's log show returns, first
+ * to a write function which only counts, then into an mbuf chain, and
+ * prints time and number of write calls per dump.  Build with different
+ * JSON_ENCODE_BUF_SIZE settings to compare.
+ */
+
+#define BENCH_ENTRIES           32
+#define BENCH_ITERS             2000
+
+#define BENCH_MBUF_CNT          64
+#define BENCH_MBUF_SIZE         128
+
+static os_membuf_t bench_mbuf_mem[
+    OS_MEMPOOL_SIZE(BENCH_MBUF_CNT, BENCH_MBUF_SIZE + sizeof(struct os_mbuf))
+];
+static struct os_mempool bench_mempool;
+static struct os_mbuf_pool bench_mbuf_pool;
+
+static uint32_t bench_writes;
+static uint32_t bench_bytes;
+
+static int
+bench_null_write(void *buf, char *data, int len)
+{
+    bench_writes++;
+    bench_bytes += len;
+    return 0;
+}
+
+static int
+bench_mbuf_write(void *buf, char *data, int len)
+{
+    bench_writes++;
+    bench_bytes += len;
+    return json_mbuf_write(buf, data, len);
+}
+
+static void
+bench_encode(json_write_func_t write, void *arg)
+{
+    struct json_encoder encoder;
+    struct json_value jv;
+    char msg[48];
+    int len;
+    int i;
+
+    memset(&encoder, 0, sizeof(encoder));
+    encoder.je_write = write;
+    encoder.je_arg = arg;
+
+    json_encode_object_start(&encoder);
+    JSON_VALUE_STRING(&jv, "reboot_log");
+    json_encode_object_entry(&encoder, "name", &jv);
+    JSON_VALUE_INT(&jv, 1);
+    json_encode_object_entry(&encoder, "type", &jv);
+    json_encode_array_name(&encoder, "entries");
+    json_encode_array_start(&encoder);
+    for (i = 0; i < BENCH_ENTRIES; i++) {
+        len = snprintf(msg, sizeof(msg), "rsn:SOFT, cnt:%d, img:1.0.%d",
+                       i, i % 7);
+
+        json_encode_object_start(&encoder);
+        JSON_VALUE_STRINGN(&jv, msg, len);
+        json_encode_object_entry(&encoder, "msg", &jv);
+        JSON_VALUE_INT(&jv, 1480000000000000ULL + i * 1234567);
+        json_encode_object_entry(&encoder, "ts", &jv);
+        JSON_VALUE_UINT(&jv, i % 5);
+        json_encode_object_entry(&encoder, "level", &jv);
+        JSON_VALUE_UINT(&jv, 1000 + i);
+        json_encode_object_entry(&encoder, "index", &jv);
+        JSON_VALUE_UINT(&jv, 3);
+        json_encode_object_entry(&encoder, "module", &jv);
+        json_encode_object_finish(&encoder);
+    }
+    json_encode_array_finish(&encoder);
+    json_encode_object_finish(&encoder);
+    json_encode_flush(&encoder);
+}
+
+static uint32_t
+bench_usecs(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000 +
+           (end->tv_nsec - start->tv_nsec) / 1000;
+}
+
+static void
+bench_print(const char *name, uint32_t usecs)
+{
+    printf("%8s %10.2f %8lu %8lu %10.1f\n", name,
+           (double)usecs / BENCH_ITERS,
+           (unsigned long)(bench_bytes / BENCH_ITERS),
+           (unsigned long)(bench_writes / BENCH_ITERS),
+           (double)bench_bytes / usecs);
+}
+
+int
+main(int argc, char **argv)
+{
+    struct timespec start;
+    struct timespec end;
+    struct os_mbuf *om;
+    int rc;
+    int i;
+
+    sysinit();
+
+    rc = os_mempool_init(&bench_mempool, BENCH_MBUF_CNT,
+                         BENCH_MBUF_SIZE + sizeof(struct os_mbuf),
+                         bench_mbuf_mem, "jsonbench");
+    assert(rc == 0);
+    rc = os_mbuf_pool_init(&bench_mbuf_pool, &bench_mempool,
+                           BENCH_MBUF_SIZE + sizeof(struct os_mbuf),
+                           BENCH_MBUF_CNT);
+    assert(rc == 0);
+
+    printf("%d entry log dump, JSON_ENCODE_BUF_SIZE %d\n",
+           BENCH_ENTRIES, MYNEWT_VAL(JSON_ENCODE_BUF_SIZE));
+    printf("%8s %10s %8s %8s %10s\n",
+           "writer", "us/dump", "bytes", "writes", "MB/s");
+
+    bench_writes = 0;
+    bench_bytes = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_ITERS; i++) {
+        bench_encode(bench_null_write, NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    bench_print("null", bench_usecs(&start, &end));
+
+    bench_writes = 0;
+    bench_bytes = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_ITERS; i++) {
+        om = os_mbuf_get_pkthdr(&bench_mbuf_pool, 0);
+        assert(om != NULL);
+        bench_encode(bench_mbuf_write, om);
+        assert(OS_MBUF_PKTLEN(om) == bench_bytes / (i + 1));
+        os_mbuf_free_chain(om);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    bench_print("mbuf", bench_usecs(&start, &end));
+
+    return 0;
+}
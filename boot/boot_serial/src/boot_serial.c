@@ -22,6 +22,7 @@
 #include <ctype.h>
 #include <stdio.h>
 
+#include "syscfg/syscfg.h"
 #include "sysflash/sysflash.h"
 
 #include <bsp/bsp.h>
@@ -49,6 +50,7 @@
 #include "boot_serial_priv.h"
 
 #define BOOT_SERIAL_OUT_MAX	48
+#define BOOT_SERIAL_IN_CHUNK	32
 
 static uint32_t curr_off;
 static uint32_t img_size;
@@ -151,6 +153,62 @@ bs_list(char *buf, int len)
     boot_serial_output();
 }
 
+/*
+ * Writes a chunk of image to slot 0.  A chunk at offset 0 starts a new
+ * upload, and erases the slot.  Chunks at any other offset than where the
+ * previous one ended are ignored.
+ *
+ * @param img_len               Length of the whole image, if known; checked
+ *                                  when the upload starts.
+ * @param next_off (out)        Where the next chunk should start; may be
+ *                                  NULL.
+ *
+ * @return                      0 on success; MGMT_ERR_xxx on failure.
+ */
+int
+bs_upload_chunk(uint32_t off, const void *data, uint32_t len,
+  uint32_t img_len, uint32_t *next_off)
+{
+    const struct flash_area *fap;
+    int rc;
+
+    rc = flash_area_open(flash_area_id_from_image_slot(0), &fap);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    if (off == 0) {
+        curr_off = 0;
+        if (img_len > fap->fa_size) {
+            rc = MGMT_ERR_EINVAL;
+            goto out;
+        }
+        rc = flash_area_erase(fap, 0, fap->fa_size);
+        if (rc) {
+            rc = MGMT_ERR_EINVAL;
+            goto out;
+        }
+        img_size = img_len;
+    }
+    if (off != curr_off) {
+        rc = 0;
+        goto out;
+    }
+    rc = flash_area_write(fap, curr_off, data, len);
+    if (rc) {
+        rc = MGMT_ERR_EINVAL;
+        goto out;
+    }
+    curr_off += len;
+
+out:
+    if (next_off) {
+        *next_off = curr_off;
+    }
+    flash_area_close(fap);
+    return rc;
+}
+
 /*
  * Image upload request.
  */
@@ -185,7 +243,6 @@ bs_upload(char *buf, int len)
             .nodefault = true
         }
     };
-    const struct flash_area *fap = NULL;
     int rc;
 
     memset(img_data, 0, sizeof(img_data));
@@ -197,36 +254,7 @@ bs_upload(char *buf, int len)
         goto out;
     }
 
-
-    rc = flash_area_open(flash_area_id_from_image_slot(0), &fap);
-    if (rc) {
-        rc = MGMT_ERR_EINVAL;
-        goto out;
-    }
-
-    if (off == 0) {
-        curr_off = 0;
-        if (data_len > fap->fa_size) {
-            rc = MGMT_ERR_EINVAL;
-            goto out;
-        }
-        rc = flash_area_erase(fap, 0, fap->fa_size);
-        if (rc) {
-            rc = MGMT_ERR_EINVAL;
-            goto out;
-        }
-        img_size = data_len;
-    }
-    if (off != curr_off) {
-        rc = 0;
-        goto out;
-    }
-    rc = flash_area_write(fap, curr_off, img_data, img_blen);
-    if (rc) {
-        rc = MGMT_ERR_EINVAL;
-        goto out;
-    }
-    curr_off += img_blen;
+    rc = bs_upload_chunk(off, img_data, img_blen, data_len, NULL);
 
 out:
     cbor_encoder_create_map(&bs_root, &bs_rsp, CborIndefiniteLength);
@@ -239,7 +267,6 @@ out:
     cbor_encoder_close_container(&bs_root, &bs_rsp);
 
     boot_serial_output();
-    flash_area_close(fap);
 }
 
 /*
@@ -339,6 +366,13 @@ boot_serial_output(void)
     bs_hdr->nh_len = htons(len);
     bs_hdr->nh_group = htons(bs_hdr->nh_group);
 
+#if MYNEWT_VAL(BOOT_SERIAL_BIN)
+    if (boot_serial_bin_rsp) {
+        boot_serial_bin_output(bs_hdr, data, len);
+        return;
+    }
+#endif
+
     crc = crc16_ccitt(CRC16_INITIAL_CRC, bs_hdr, sizeof(*bs_hdr));
     crc = crc16_ccitt(crc, data, len);
     crc = htons(crc);
@@ -365,21 +399,11 @@ boot_serial_output(void)
  * Returns 1 if full packet has been received.
  */
 static int
-boot_serial_in_dec(char *in, int inlen, char *out, int *out_off, int maxout)
+boot_serial_in_dec(char *out, int *out_off)
 {
-    int rc;
     uint16_t crc;
     uint16_t len;
 
-    if (*out_off + base64_decode_len(in) >= maxout) {
-        return -1;
-    }
-    rc = base64_decode(in, &out[*out_off]);
-    if (rc < 0) {
-        return -1;
-    }
-    *out_off += rc;
-
     if (*out_off > sizeof(uint16_t)) {
         len = ntohs(*(uint16_t *)out);
 
@@ -400,46 +424,86 @@ boot_serial_in_dec(char *in, int inlen, char *out, int *out_off, int maxout)
 /*
  * Task which waits reading console, expecting to get image over
  * serial port.
+ *
+ * Lines are decoded as they are read, a chunk at a time, so only the
+ * decoded frame needs a max_input sized buffer.
  */
 void
 boot_serial_start(int max_input)
 {
-    int rc;
-    int off;
-    char *buf;
+    struct base64_decoder bd;
+    char buf[BOOT_SERIAL_IN_CHUNK];
+    char start[2];
+    char *ptr;
     char *dec;
     int dec_off;
+    int line_off;
+    int line_ok;
     int full_line;
+    int len;
+    int rc;
+
+#if MYNEWT_VAL(BOOT_SERIAL_BIN)
+    boot_serial_bin_start();
+#endif
 
     rc = console_init(NULL);
     assert(rc == 0);
     console_echo(0);
 
-    buf = os_malloc(max_input);
     dec = os_malloc(max_input);
-    assert(buf && dec);
+    assert(dec);
 
-    off = 0;
+    dec_off = 0;
+    line_off = 0;
+    line_ok = 0;
     while (1) {
-        rc = console_read(buf + off, max_input - off, &full_line);
+        rc = console_read(buf, sizeof(buf), &full_line);
         if (rc <= 0 && !full_line) {
             continue;
         }
-        off += rc;
+        ptr = buf;
+        len = max(rc, 0);
+
+        /* The first two characters say whether the line is a frame. */
+        while (line_off < 2 && len > 0) {
+            start[line_off++] = *ptr++;
+            len--;
+            if (line_off < 2) {
+                continue;
+            }
+            line_ok = 1;
+            if (start[0] == SHELL_NLIP_PKT_START1 &&
+              start[1] == SHELL_NLIP_PKT_START2) {
+                dec_off = 0;
+            } else if (start[0] != SHELL_NLIP_DATA_START1 ||
+              start[1] != SHELL_NLIP_DATA_START2) {
+                line_ok = 0;
+            }
+            base64_decoder_init(&bd);
+        }
+
+        if (line_ok && len > 0) {
+            if (dec_off + BASE64_DECODE_MAX_LEN(len) >= max_input) {
+                line_ok = 0;
+            } else {
+                rc = base64_decoder_data(&bd, ptr, len, &dec[dec_off]);
+                if (rc < 0) {
+                    line_ok = 0;
+                } else {
+                    dec_off += rc;
+                }
+            }
+        }
+
         if (!full_line) {
             continue;
         }
-        if (buf[0] == SHELL_NLIP_PKT_START1 &&
-          buf[1] == SHELL_NLIP_PKT_START2) {
-            dec_off = 0;
-            rc = boot_serial_in_dec(&buf[2], off - 2, dec, &dec_off, max_input);
-        } else if (buf[0] == SHELL_NLIP_DATA_START1 &&
-          buf[1] == SHELL_NLIP_DATA_START2) {
-            rc = boot_serial_in_dec(&buf[2], off - 2, dec, &dec_off, max_input);
-        }
-        if (rc == 1) {
+        if (line_off == 2 && line_ok && !base64_decoder_finish(&bd) &&
+          boot_serial_in_dec(dec, &dec_off) == 1) {
             boot_serial_input(&dec[2], dec_off - 2);
         }
-        off = 0;
+        line_off = 0;
+        line_ok = 0;
     }
 }
@@ -0,0 +1,314 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BOOT_SERIAL_BIN)
+
+#include <assert.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <hal/hal_uart.h>
+#include <os/endian.h>
+#include <crc/crc16.h>
+
+#include "boot_serial/boot_serial.h"
+#include "boot_serial_priv.h"
+
+/*
+ * Binary framing, for uploading images faster than with base64 lines.
+ *
+ * Every frame is:
+ *     sync        0xb5 0x53
+ *     type        BS_BIN_xxx
+ *     length      of payload; 2 bytes, big endian
+ *     payload
+ *     crc         CRC16-CCITT over type, length and payload; big endian
+ *
+ * BS_BIN_NMGR frames carry a newtmgr request, or its response, without
+ * base64 encoding.  BS_BIN_DATA frames carry a 4 byte big endian image
+ * offset followed by image data; offset 0 starts a new upload.  Each data
+ * frame is answered with a BS_BIN_ACK carrying the offset expected next
+ * (4 bytes, big endian) and a status byte (MGMT_ERR_xxx).
+ *
+ * The host may send several data frames without waiting for acks.  The UART
+ * receive interrupt checks the CRC as bytes arrive, and keeps filling a
+ * free buffer while an earlier frame is written to flash.  Frames that are
+ * damaged, arrive with no buffer free, or are not at the expected offset
+ * are dropped; the host resends from the offset in the latest ack.
+ */
+
+#define BS_BIN_ST_SYNC1         0
+#define BS_BIN_ST_SYNC2         1
+#define BS_BIN_ST_HDR           2
+#define BS_BIN_ST_PAYLOAD       3
+#define BS_BIN_ST_CRC           4
+
+#define BS_BIN_BUFS             MYNEWT_VAL(BOOT_SERIAL_BIN_BUFS)
+#define BS_BIN_TX_SIZE          MYNEWT_VAL(BOOT_SERIAL_BIN_TX_SIZE)
+
+struct bs_bin_frame {
+    uint8_t bbf_type;
+    uint16_t bbf_len;
+    uint8_t bbf_data[MYNEWT_VAL(BOOT_SERIAL_BIN_FRAME_SIZE)];
+};
+
+static struct {
+    struct bs_bin_frame bufs[BS_BIN_BUFS];
+    volatile uint8_t head;      /* Frames received */
+    volatile uint8_t tail;      /* Frames processed */
+
+    /* Receive state */
+    struct bs_bin_frame *rx;    /* NULL if frame is being dropped */
+    uint8_t state;
+    uint8_t hdr[BS_BIN_HDR_SZ - 2];
+    uint16_t cnt;
+    uint16_t len;
+    uint16_t crc;
+
+    uint8_t tx[BS_BIN_TX_SIZE];
+    volatile uint16_t tx_head;
+    volatile uint16_t tx_tail;
+} bs_bin;
+
+/*
+ * Set while handling a newtmgr request which came in a binary frame, so
+ * that the response goes out the same way.
+ */
+int boot_serial_bin_rsp;
+
+static void
+bs_bin_start_tx(void)
+{
+    hal_uart_start_tx(MYNEWT_VAL(BOOT_SERIAL_BIN_UART));
+}
+
+/*
+ * Starts the UART transmitter.  Unit tests point this at a routine which
+ * empties the transmit ring itself.
+ */
+void (*boot_serial_bin_start_tx)(void) = bs_bin_start_tx;
+
+/*
+ * UART receive callback.
+ */
+int
+boot_serial_bin_rx(void *arg, uint8_t byte)
+{
+    switch (bs_bin.state) {
+    case BS_BIN_ST_SYNC1:
+        if (byte == BS_BIN_SYNC1) {
+            bs_bin.state = BS_BIN_ST_SYNC2;
+        }
+        break;
+    case BS_BIN_ST_SYNC2:
+        if (byte == BS_BIN_SYNC2) {
+            bs_bin.state = BS_BIN_ST_HDR;
+            bs_bin.cnt = 0;
+            bs_bin.crc = CRC16_INITIAL_CRC;
+        } else if (byte != BS_BIN_SYNC1) {
+            bs_bin.state = BS_BIN_ST_SYNC1;
+        }
+        break;
+    case BS_BIN_ST_HDR:
+        bs_bin.crc = crc16_ccitt(bs_bin.crc, &byte, 1);
+        bs_bin.hdr[bs_bin.cnt++] = byte;
+        if (bs_bin.cnt < sizeof(bs_bin.hdr)) {
+            break;
+        }
+        bs_bin.len = (bs_bin.hdr[1] << 8) | bs_bin.hdr[2];
+        if (bs_bin.len > sizeof(bs_bin.bufs[0].bbf_data)) {
+            bs_bin.state = BS_BIN_ST_SYNC1;
+            break;
+        }
+        if ((uint8_t)(bs_bin.head - bs_bin.tail) < BS_BIN_BUFS) {
+            bs_bin.rx = &bs_bin.bufs[bs_bin.head % BS_BIN_BUFS];
+            bs_bin.rx->bbf_type = bs_bin.hdr[0];
+            bs_bin.rx->bbf_len = bs_bin.len;
+        } else {
+            bs_bin.rx = NULL;
+        }
+        bs_bin.cnt = 0;
+        bs_bin.state = bs_bin.len ? BS_BIN_ST_PAYLOAD : BS_BIN_ST_CRC;
+        break;
+    case BS_BIN_ST_PAYLOAD:
+        bs_bin.crc = crc16_ccitt(bs_bin.crc, &byte, 1);
+        if (bs_bin.rx) {
+            bs_bin.rx->bbf_data[bs_bin.cnt] = byte;
+        }
+        if (++bs_bin.cnt == bs_bin.len) {
+            bs_bin.cnt = 0;
+            bs_bin.state = BS_BIN_ST_CRC;
+        }
+        break;
+    case BS_BIN_ST_CRC:
+        bs_bin.crc = crc16_ccitt(bs_bin.crc, &byte, 1);
+        if (++bs_bin.cnt < BS_BIN_CRC_SZ) {
+            break;
+        }
+        if (bs_bin.crc == 0 && bs_bin.rx) {
+            bs_bin.head++;
+        }
+        bs_bin.state = BS_BIN_ST_SYNC1;
+        break;
+    }
+    return 0;
+}
+
+/*
+ * UART transmit callback.
+ */
+int
+boot_serial_bin_tx_char(void *arg)
+{
+    uint8_t byte;
+
+    if (bs_bin.tx_tail == bs_bin.tx_head) {
+        return -1;
+    }
+    byte = bs_bin.tx[bs_bin.tx_tail % BS_BIN_TX_SIZE];
+    bs_bin.tx_tail++;
+    return byte;
+}
+
+static void
+bs_bin_write(const void *data, int len, uint16_t *crc)
+{
+    const uint8_t *u8p;
+
+    if (crc) {
+        *crc = crc16_ccitt(*crc, data, len);
+    }
+    for (u8p = data; len > 0; u8p++, len--) {
+        while ((uint16_t)(bs_bin.tx_head - bs_bin.tx_tail) >= BS_BIN_TX_SIZE) {
+            /*
+             * Ring is full.  Frames can be larger than the ring, so the
+             * UART must be draining it while we wait for room.
+             */
+            boot_serial_bin_start_tx();
+        }
+        bs_bin.tx[bs_bin.tx_head % BS_BIN_TX_SIZE] = *u8p;
+        bs_bin.tx_head++;
+    }
+}
+
+static void
+bs_bin_send(uint8_t type, const void *data1, int len1, const void *data2,
+  int len2)
+{
+    uint8_t hdr[BS_BIN_HDR_SZ];
+    uint16_t len;
+    uint16_t crc;
+
+    len = len1 + len2;
+    hdr[0] = BS_BIN_SYNC1;
+    hdr[1] = BS_BIN_SYNC2;
+    hdr[2] = type;
+    hdr[3] = len >> 8;
+    hdr[4] = len;
+
+    crc = CRC16_INITIAL_CRC;
+    bs_bin_write(hdr, 2, NULL);
+    bs_bin_write(hdr + 2, sizeof(hdr) - 2, &crc);
+    bs_bin_write(data1, len1, &crc);
+    bs_bin_write(data2, len2, &crc);
+    crc = htons(crc);
+    bs_bin_write(&crc, sizeof(crc), NULL);
+
+    boot_serial_bin_start_tx();
+}
+
+void
+boot_serial_bin_output(struct nmgr_hdr *hdr, const char *data, int len)
+{
+    bs_bin_send(BS_BIN_NMGR, hdr, sizeof(*hdr), data, len);
+}
+
+static void
+bs_bin_data(struct bs_bin_frame *frame)
+{
+    uint8_t ack[5];
+    uint32_t off;
+    int rc;
+
+    if (frame->bbf_len < sizeof(off)) {
+        return;
+    }
+    memcpy(&off, frame->bbf_data, sizeof(off));
+    off = ntohl(off);
+
+    rc = bs_upload_chunk(off, frame->bbf_data + sizeof(off),
+                         frame->bbf_len - sizeof(off), 0, &off);
+
+    off = htonl(off);
+    memcpy(ack, &off, sizeof(off));
+    ack[4] = rc;
+    bs_bin_send(BS_BIN_ACK, ack, sizeof(ack), NULL, 0);
+}
+
+/*
+ * Handles frames received so far.
+ */
+void
+boot_serial_bin_poll(void)
+{
+    struct bs_bin_frame *frame;
+
+    while (bs_bin.tail != bs_bin.head) {
+        frame = &bs_bin.bufs[bs_bin.tail % BS_BIN_BUFS];
+        switch (frame->bbf_type) {
+        case BS_BIN_NMGR:
+            boot_serial_bin_rsp = 1;
+            boot_serial_input((char *)frame->bbf_data, frame->bbf_len);
+            boot_serial_bin_rsp = 0;
+            break;
+        case BS_BIN_DATA:
+            bs_bin_data(frame);
+            break;
+        default:
+            break;
+        }
+        bs_bin.tail++;
+    }
+}
+
+/*
+ * Takes over the UART, and processes frames forever.
+ */
+void
+boot_serial_bin_start(void)
+{
+    int port;
+    int rc;
+
+    port = MYNEWT_VAL(BOOT_SERIAL_BIN_UART);
+    rc = hal_uart_init_cbs(port, boot_serial_bin_tx_char, NULL,
+                           boot_serial_bin_rx, NULL);
+    assert(rc == 0);
+    rc = hal_uart_config(port, MYNEWT_VAL(BOOT_SERIAL_BIN_BAUD), 8, 1,
+                         HAL_UART_PARITY_NONE, HAL_UART_FLOW_CTL_NONE);
+    assert(rc == 0);
+
+    while (1) {
+        boot_serial_bin_poll();
+    }
+}
+
+#endif /* MYNEWT_VAL(BOOT_SERIAL_BIN) */
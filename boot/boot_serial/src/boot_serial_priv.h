@@ -66,6 +66,30 @@ struct nmgr_hdr {
 
 
 void boot_serial_input(char *buf, int len);
+int bs_upload_chunk(uint32_t off, const void *data, uint32_t len,
+  uint32_t img_len, uint32_t *next_off);
+
+/*
+ * Binary framing; see boot_serial_bin.c.
+ */
+#define BS_BIN_SYNC1            0xb5
+#define BS_BIN_SYNC2            0x53
+
+#define BS_BIN_NMGR             1   /* newtmgr request/response */
+#define BS_BIN_DATA             2   /* Image data */
+#define BS_BIN_ACK              3   /* Image data ack */
+
+#define BS_BIN_HDR_SZ           5   /* Sync, type, length */
+#define BS_BIN_CRC_SZ           2
+
+extern int boot_serial_bin_rsp;
+extern void (*boot_serial_bin_start_tx)(void);
+
+void boot_serial_bin_start(void);
+int boot_serial_bin_rx(void *arg, uint8_t byte);
+int boot_serial_bin_tx_char(void *arg);
+void boot_serial_bin_poll(void);
+void boot_serial_bin_output(struct nmgr_hdr *hdr, const char *data, int len);
 
 #ifdef __cplusplus
 }
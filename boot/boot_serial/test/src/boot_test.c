@@ -32,12 +32,15 @@
 #include "flash_map/flash_map.h"
 
 #include "boot_serial_priv.h"
+#include "boot_test.h"
 
 TEST_CASE_DECL(boot_serial_setup)
 TEST_CASE_DECL(boot_serial_empty_msg)
 TEST_CASE_DECL(boot_serial_empty_img_msg)
 TEST_CASE_DECL(boot_serial_img_msg)
 TEST_CASE_DECL(boot_serial_upload_bigger_image)
+TEST_CASE_DECL(boot_serial_bin_upload)
+TEST_CASE_DECL(boot_serial_bin_small_tx)
 
 void
 tx_msg(void *src, int len)
@@ -45,6 +48,121 @@ tx_msg(void *src, int len)
     boot_serial_input(src, len);
 }
 
+uint32_t bs_bin_test_wire;
+uint32_t bs_bin_test_acked;
+uint8_t bs_bin_test_rsp_op;
+
+static void
+bs_bin_test_rx(const void *data, int len)
+{
+    const uint8_t *u8p;
+
+    for (u8p = data; len > 0; u8p++, len--) {
+        boot_serial_bin_rx(NULL, *u8p);
+        bs_bin_test_wire++;
+    }
+}
+
+/*
+ * Sends a frame to the device, as the host would.
+ */
+void
+bs_bin_test_send(uint8_t type, const void *data1, int len1,
+                 const void *data2, int len2, int corrupt)
+{
+    uint8_t hdr[BS_BIN_HDR_SZ];
+    uint8_t bad;
+    uint16_t crc;
+
+    hdr[0] = BS_BIN_SYNC1;
+    hdr[1] = BS_BIN_SYNC2;
+    hdr[2] = type;
+    hdr[3] = (len1 + len2) >> 8;
+    hdr[4] = len1 + len2;
+
+    crc = crc16_ccitt(CRC16_INITIAL_CRC, hdr + 2, sizeof(hdr) - 2);
+    crc = crc16_ccitt(crc, data1, len1);
+    crc = crc16_ccitt(crc, data2, len2);
+    crc = htons(crc);
+
+    bs_bin_test_rx(hdr, sizeof(hdr));
+    bs_bin_test_rx(data1, len1);
+    if (corrupt) {
+        bad = ((uint8_t *)data2)[0] ^ 0x10;
+        bs_bin_test_rx(&bad, 1);
+        bs_bin_test_rx((uint8_t *)data2 + 1, len2 - 1);
+    } else {
+        bs_bin_test_rx(data2, len2);
+    }
+    bs_bin_test_rx(&crc, sizeof(crc));
+}
+
+/*
+ * What the UART has sent so far.  Like the native UART before the OS is
+ * running, each start of the transmitter sends one byte.
+ */
+static uint8_t bs_bin_test_tx[1024];
+static int bs_bin_test_tx_cnt;
+int bs_bin_test_tx_starts;
+
+static void
+bs_bin_test_start_tx(void)
+{
+    int rc;
+
+    bs_bin_test_tx_starts++;
+    rc = boot_serial_bin_tx_char(NULL);
+    if (rc >= 0) {
+        TEST_ASSERT_FATAL(bs_bin_test_tx_cnt < sizeof(bs_bin_test_tx));
+        bs_bin_test_tx[bs_bin_test_tx_cnt++] = rc;
+    }
+}
+
+/*
+ * Reads what the device has sent, and picks up acks and responses.
+ */
+void
+bs_bin_test_drain(void)
+{
+    uint8_t *buf;
+    uint32_t off;
+    int len;
+    int cnt;
+    int i;
+
+    do {
+        cnt = bs_bin_test_tx_cnt;
+        bs_bin_test_start_tx();
+    } while (bs_bin_test_tx_cnt != cnt);
+    buf = bs_bin_test_tx;
+    cnt = bs_bin_test_tx_cnt;
+    bs_bin_test_tx_cnt = 0;
+
+    for (i = 0; i < cnt; i += BS_BIN_HDR_SZ + len + BS_BIN_CRC_SZ) {
+        TEST_ASSERT_FATAL(cnt - i >= BS_BIN_HDR_SZ + BS_BIN_CRC_SZ);
+        TEST_ASSERT_FATAL(buf[i] == BS_BIN_SYNC1 && buf[i + 1] == BS_BIN_SYNC2);
+        len = (buf[i + 3] << 8) | buf[i + 4];
+        TEST_ASSERT_FATAL(i + BS_BIN_HDR_SZ + len + BS_BIN_CRC_SZ <= cnt);
+        TEST_ASSERT(crc16_ccitt(CRC16_INITIAL_CRC, buf + i + 2,
+                                BS_BIN_HDR_SZ - 2 + len + BS_BIN_CRC_SZ) == 0);
+
+        switch (buf[i + 2]) {
+        case BS_BIN_ACK:
+            TEST_ASSERT_FATAL(len == 5);
+            TEST_ASSERT(buf[i + BS_BIN_HDR_SZ + 4] == 0);
+            memcpy(&off, buf + i + BS_BIN_HDR_SZ, sizeof(off));
+            bs_bin_test_acked = ntohl(off);
+            break;
+        case BS_BIN_NMGR:
+            TEST_ASSERT_FATAL(len >= sizeof(struct nmgr_hdr));
+            bs_bin_test_rsp_op = buf[i + BS_BIN_HDR_SZ];
+            break;
+        default:
+            TEST_ASSERT_FATAL(0, "unexpected frame type %d", buf[i + 2]);
+        }
+    }
+}
+
 TEST_SUITE(boot_serial_suite)
 {
     boot_serial_setup();
@@ -52,11 +170,14 @@ TEST_SUITE(boot_serial_suite)
     boot_serial_empty_img_msg();
     boot_serial_img_msg();
     boot_serial_upload_bigger_image();
+    boot_serial_bin_upload();
+    boot_serial_bin_small_tx();
 }
 
 int
 boot_serial_test(void)
 {
+    boot_serial_bin_start_tx = bs_bin_test_start_tx;
     boot_serial_suite();
     return tu_any_failed;
 }
@@ -42,6 +42,15 @@
 
 void tx_msg(void *src, int len);
 
+extern uint32_t bs_bin_test_wire;
+extern uint32_t bs_bin_test_acked;
+extern uint8_t bs_bin_test_rsp_op;
+extern int bs_bin_test_tx_starts;
+
+void bs_bin_test_send(uint8_t type, const void *data1, int len1,
+                      const void *data2, int len2, int corrupt);
+void bs_bin_test_drain(void);
+
 #ifdef __cplusplus
 }
 #endif
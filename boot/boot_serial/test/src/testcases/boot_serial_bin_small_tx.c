@@ -0,0 +1,46 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "boot_test.h"
+
+TEST_CASE(boot_serial_bin_small_tx)
+{
+    struct nmgr_hdr hdr;
+    int starts;
+
+    /*
+     * Response does not fit in the transmit ring; it goes out as the UART
+     * makes room.
+     */
+    TEST_ASSERT_FATAL(MYNEWT_VAL(BOOT_SERIAL_BIN_TX_SIZE) <
+                      BS_BIN_HDR_SZ + sizeof(hdr) + BS_BIN_CRC_SZ);
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.nh_op = NMGR_OP_WRITE;
+    hdr.nh_group = htons(MGMT_GROUP_ID_DEFAULT);
+    hdr.nh_id = NMGR_ID_CONS_ECHO_CTRL;
+
+    bs_bin_test_rsp_op = 0;
+    starts = bs_bin_test_tx_starts;
+    bs_bin_test_send(BS_BIN_NMGR, &hdr, sizeof(hdr), NULL, 0, 0);
+    boot_serial_bin_poll();
+    TEST_ASSERT(bs_bin_test_tx_starts - starts > 1);
+
+    bs_bin_test_drain();
+    TEST_ASSERT(bs_bin_test_rsp_op == NMGR_OP_WRITE + 1);
+}
@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os/os.h"
+
+#include "boot_test.h"
+
+#define BS_BIN_TEST_IMG_SZ      16000
+#define BS_BIN_TEST_CHUNK       (MYNEWT_VAL(BOOT_SERIAL_BIN_FRAME_SIZE) - 4)
+#define BS_BIN_TEST_WIN         4
+
+static uint8_t bs_bin_test_img[BS_BIN_TEST_IMG_SZ];
+
+static void
+bs_bin_test_data(uint32_t off, int corrupt)
+{
+    uint32_t noff;
+    int len;
+
+    len = min(BS_BIN_TEST_CHUNK, BS_BIN_TEST_IMG_SZ - off);
+    noff = htonl(off);
+    bs_bin_test_send(BS_BIN_DATA, &noff, sizeof(noff),
+                     bs_bin_test_img + off, len, corrupt);
+}
+
+TEST_CASE(boot_serial_bin_upload)
+{
+    const struct flash_area *fap;
+    struct nmgr_hdr hdr;
+    uint8_t buf[64];
+    uint32_t prev;
+    uint32_t off;
+    int frame;
+    int i;
+
+    /*
+     * newtmgr requests work in binary frames too.
+     */
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.nh_op = NMGR_OP_WRITE;
+    hdr.nh_group = htons(MGMT_GROUP_ID_DEFAULT);
+    hdr.nh_id = NMGR_ID_CONS_ECHO_CTRL;
+    bs_bin_test_send(BS_BIN_NMGR, &hdr, sizeof(hdr), NULL, 0, 0);
+    boot_serial_bin_poll();
+    bs_bin_test_drain();
+    TEST_ASSERT(bs_bin_test_rsp_op == NMGR_OP_WRITE + 1);
+
+    for (i = 0; i < sizeof(bs_bin_test_img); i++) {
+        bs_bin_test_img[i] = i * 7 + (i >> 8);
+    }
+
+    /*
+     * Upload with several frames in flight.  Device is too busy to pick up
+     * frames 3 to 6, so some of them get dropped, and frame 9 is damaged.
+     */
+    bs_bin_test_wire = 0;
+    bs_bin_test_acked = 0;
+    off = 0;
+    frame = 0;
+    while (bs_bin_test_acked < BS_BIN_TEST_IMG_SZ) {
+        TEST_ASSERT_FATAL(frame < 200);
+        while (off < BS_BIN_TEST_IMG_SZ &&
+               off - bs_bin_test_acked < BS_BIN_TEST_WIN * BS_BIN_TEST_CHUNK) {
+            bs_bin_test_data(off, frame == 9);
+            off += min(BS_BIN_TEST_CHUNK, BS_BIN_TEST_IMG_SZ - off);
+            if (frame < 3 || frame > 6) {
+                boot_serial_bin_poll();
+            }
+            frame++;
+        }
+        boot_serial_bin_poll();
+        prev = bs_bin_test_acked;
+        bs_bin_test_drain();
+        if (bs_bin_test_acked == prev) {
+            /* No progress; go back to what device expects. */
+            off = bs_bin_test_acked;
+        }
+    }
+
+    /*
+     * Framing overhead and resends stay small compared to base64.
+     */
+    TEST_ASSERT(bs_bin_test_wire < BS_BIN_TEST_IMG_SZ * 5 / 4,
+                "%d bytes on the wire", (int)bs_bin_test_wire);
+
+    TEST_ASSERT_FATAL(flash_area_open(FLASH_AREA_IMAGE_0, &fap) == 0);
+    for (off = 0; off < BS_BIN_TEST_IMG_SZ; off += sizeof(buf)) {
+        i = min(sizeof(buf), BS_BIN_TEST_IMG_SZ - off);
+        TEST_ASSERT_FATAL(flash_area_read(fap, off, buf, i) == 0);
+        TEST_ASSERT_FATAL(memcmp(buf, bs_bin_test_img + off, i) == 0,
+                          "mismatch at %d", (int)off);
+    }
+}
@@ -45,6 +45,7 @@ struct flash_area;
 struct boot_status {
     uint32_t idx;       /* Which area we're operating on */
     uint8_t state;      /* Which part of the swapping process are we at */
+    uint8_t skip;       /* Area is identical in both slots; not swapped */
 };
 
 #define BOOT_MAGIC_GOOD  1
@@ -80,6 +81,9 @@ struct boot_swap_state {
 #define BOOT_STATUS_STATE_COUNT 3
 #define BOOT_STATUS_MAX_ENTRIES 128
 
+/* Status entry value for the states of an area which did not need swapping. */
+#define BOOT_STATUS_SKIP        0x80
+
 #define BOOT_STATUS_SOURCE_NONE    0
 #define BOOT_STATUS_SOURCE_SCRATCH 1
 #define BOOT_STATUS_SOURCE_SLOT0   2
@@ -95,6 +99,7 @@ int boot_read_swap_state_img(int slot, struct boot_swap_state *state);
 int boot_read_swap_state_scratch(struct boot_swap_state *state);
 int boot_write_magic(const struct flash_area *fap);
 int boot_write_status(struct boot_status *bs);
+int boot_write_status_skip(struct boot_status *bs);
 int boot_schedule_test_swap(void);
 int boot_write_copy_done(const struct flash_area *fap);
 int boot_write_image_ok(const struct flash_area *fap);
@@ -44,6 +44,7 @@ bootutil_img_hash(struct image_header *hdr, const struct flash_area *fap,
                   uint8_t *hash_result, uint8_t *seed, int seed_len)
 {
     mbedtls_sha256_context sha256_ctx;
+    const void *ptr;
     uint32_t blk_sz;
     uint32_t size;
     uint32_t off;
@@ -65,6 +66,12 @@ bootutil_img_hash(struct image_header *hdr, const struct flash_area *fap,
      * included ATM.
      */
     size = hdr->ih_img_size + hdr->ih_hdr_size;
+    ptr = flash_area_get_ptr(fap, 0, size);
+    if (ptr) {
+        /* Memory-mapped flash; hash in place. */
+        mbedtls_sha256_update(&sha256_ctx, ptr, size);
+        size = 0;
+    }
     for (off = 0; off < size; off += blk_sz) {
         blk_sz = size - off;
         if (blk_sz > tmp_buf_sz) {
@@ -27,6 +27,7 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
+#include "syscfg/syscfg.h"
 #include "sysflash/sysflash.h"
 #include "flash_map/flash_map.h"
 #include <hal/hal_flash.h>
@@ -37,6 +38,12 @@
 
 #define BOOT_MAX_IMG_SECTORS        120
 
+#define BOOT_COPY_BUF_SZ            MYNEWT_VAL(BOOTUTIL_COPY_BUF_SIZE)
+
+/* The buffer is kept as words, and compares split it in two halves. */
+_Static_assert(BOOT_COPY_BUF_SZ % 4 == 0 && BOOT_COPY_BUF_SZ >= 8,
+               "BOOTUTIL_COPY_BUF_SIZE must be a multiple of 4, at least 8");
+
 /** Number of image slots in flash; currently limited to two. */
 #define BOOT_NUM_SLOTS              2
 
@@ -49,6 +56,9 @@ static struct {
     int num_img_sectors;
     struct flash_area scratch_sector;
 
+    /* Buffer for moving and comparing flash contents during a swap. */
+    uint8_t *copy_buf;
+
     uint8_t write_sz;
 } boot_data;
 
@@ -354,6 +364,7 @@ boot_read_status_bytes(const struct flash_area *fap, struct boot_status *bs)
 {
     uint32_t off;
     uint8_t status;
+    uint8_t last;
     int found;
     int rc;
     int i;
@@ -361,6 +372,7 @@ boot_read_status_bytes(const struct flash_area *fap, struct boot_status *bs)
     off = boot_status_off(fap);
 
     found = 0;
+    last = 0xff;
     for (i = 0; i < BOOT_STATUS_MAX_ENTRIES; i++) {
         rc = flash_area_read(fap, off + i * boot_data.write_sz, &status, 1);
         if (rc != 0) {
@@ -374,12 +386,17 @@ boot_read_status_bytes(const struct flash_area *fap, struct boot_status *bs)
         } else if (!found) {
             found = 1;
         }
+        last = status;
     }
 
     if (found) {
         i--;
         bs->idx = i / BOOT_STATUS_STATE_COUNT;
         bs->state = i % BOOT_STATUS_STATE_COUNT;
+        if (bs->state != 0 && last == BOOT_STATUS_SKIP) {
+            /* Interrupted while recording that this area was skipped. */
+            bs->skip = 1;
+        }
     }
 
     return 0;
@@ -432,16 +449,8 @@ boot_read_status(struct boot_status *bs)
     return 0;
 }
 
-/**
- * Writes the supplied boot status to the flash file system.  The boot status
- * contains the current state of an in-progress image copy operation.
- *
- * @param bs                    The boot status to write.
- *
- * @return                      0 on success; nonzero on failure.
- */
-int
-boot_write_status(struct boot_status *bs)
+static int
+boot_write_status_val(struct boot_status *bs, uint8_t val)
 {
     const struct flash_area *fap;
     uint32_t off;
@@ -465,7 +474,7 @@ boot_write_status(struct boot_status *bs)
     off = boot_status_off(fap) +
           boot_status_internal_off(bs->idx, bs->state, boot_data.write_sz);
 
-    rc = flash_area_write(fap, off, &bs->state, 1);
+    rc = flash_area_write(fap, off, &val, 1);
     if (rc != 0) {
         rc = BOOT_EFLASH;
         goto done;
@@ -478,6 +487,35 @@ done:
     return rc;
 }
 
+/**
+ * Writes the supplied boot status to the flash file system.  The boot status
+ * contains the current state of an in-progress image copy operation.
+ *
+ * @param bs                    The boot status to write.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+boot_write_status(struct boot_status *bs)
+{
+    return boot_write_status_val(bs, bs->state);
+}
+
+/**
+ * Records that the current state of an area was skipped rather than
+ * performed.  Status entries must be contiguous, so every state of a skipped
+ * area still gets an entry.
+ *
+ * @param bs                    The boot status to write.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+boot_write_status_skip(struct boot_status *bs)
+{
+    return boot_write_status_val(bs, BOOT_STATUS_SKIP);
+}
+
 /*
  * Validate image hash/signature in a slot.
  */
@@ -691,8 +729,6 @@ boot_copy_area(int flash_area_id_src, int flash_area_id_dst,
     int chunk_sz;
     int rc;
 
-    static uint8_t buf[1024];
-
     fap_src = NULL;
     fap_dst = NULL;
 
@@ -710,19 +746,21 @@ boot_copy_area(int flash_area_id_src, int flash_area_id_dst,
 
     bytes_copied = 0;
     while (bytes_copied < sz) {
-        if (sz - bytes_copied > sizeof buf) {
-            chunk_sz = sizeof buf;
+        if (sz - bytes_copied > BOOT_COPY_BUF_SZ) {
+            chunk_sz = BOOT_COPY_BUF_SZ;
         } else {
             chunk_sz = sz - bytes_copied;
         }
 
-        rc = flash_area_read(fap_src, off_src + bytes_copied, buf, chunk_sz);
+        rc = flash_area_read(fap_src, off_src + bytes_copied,
+                             boot_data.copy_buf, chunk_sz);
         if (rc != 0) {
             rc = BOOT_EFLASH;
             goto done;
         }
 
-        rc = flash_area_write(fap_dst, off_dst + bytes_copied, buf, chunk_sz);
+        rc = flash_area_write(fap_dst, off_dst + bytes_copied,
+                              boot_data.copy_buf, chunk_sz);
         if (rc != 0) {
             rc = BOOT_EFLASH;
             goto done;
@@ -739,9 +777,84 @@ done:
     return rc;
 }
 
+/**
+ * Compares a region of the two image slots.
+ *
+ * @param off                   The offset within the slots of the region.
+ * @param sz                    The number of bytes to compare.
+ *
+ * @return                      1 if the region has the same contents in
+ *                                  both slots (including both erased);
+ *                                  0 if not, or if either can't be read.
+ */
+static int
+boot_areas_equal(uint32_t off, uint32_t sz)
+{
+    const struct flash_area *fap0;
+    const struct flash_area *fap1;
+    uint32_t bytes_cmp;
+    uint8_t *buf0;
+    uint8_t *buf1;
+    int chunk_sz;
+    int equal;
+    int rc;
+
+    /* Each slot gets half of the copy buffer. */
+    buf0 = boot_data.copy_buf;
+    buf1 = buf0 + BOOT_COPY_BUF_SZ / 2;
+
+    fap0 = NULL;
+    fap1 = NULL;
+    equal = 0;
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fap0);
+    if (rc != 0) {
+        goto done;
+    }
+    rc = flash_area_open(FLASH_AREA_IMAGE_1, &fap1);
+    if (rc != 0) {
+        goto done;
+    }
+
+    bytes_cmp = 0;
+    while (bytes_cmp < sz) {
+        if (sz - bytes_cmp > BOOT_COPY_BUF_SZ / 2) {
+            chunk_sz = BOOT_COPY_BUF_SZ / 2;
+        } else {
+            chunk_sz = sz - bytes_cmp;
+        }
+
+        if (flash_area_read(fap0, off + bytes_cmp, buf0, chunk_sz) != 0 ||
+            flash_area_read(fap1, off + bytes_cmp, buf1, chunk_sz) != 0) {
+            goto done;
+        }
+        if (memcmp(buf0, buf1, chunk_sz) != 0) {
+            goto done;
+        }
+
+        bytes_cmp += chunk_sz;
+    }
+
+    equal = 1;
+
+done:
+    flash_area_close(fap0);
+    flash_area_close(fap1);
+    return equal;
+}
+
 /**
  * Swaps the contents of two flash regions within the two image slots.
  *
+ * Regions which hold the same data in both slots (typically the erased ends
+ * of both images, or code which did not change) are left alone.  The status
+ * entries for such a region are still written, with the value
+ * BOOT_STATUS_SKIP, so that a swap interrupted while recording them is
+ * resumed without touching the region.  The decision is only made before any
+ * state of the region has been performed, while both slots still hold their
+ * original contents, so it comes out the same if it is repeated after a
+ * reset.
+ *
  * @param idx                   The index of the first sector in the range of
  *                                  sectors being swapped.
  * @param sz                    The number of bytes to swap.
@@ -755,12 +868,33 @@ boot_swap_areas(int idx, uint32_t sz, struct boot_status *bs)
 {
     uint32_t copy_sz;
     uint32_t img_off;
+    int last_area;
     int rc;
 
     /* Calculate offset from start of image area. */
     img_off = boot_data.imgs[0].sectors[idx].fa_off -
               boot_data.imgs[0].sectors[0].fa_off;
 
+    /* The last region holds the image trailers, which always differ. */
+    last_area = boot_data.imgs[0].sectors[idx].fa_off + sz >=
+                boot_data.imgs[1].sectors[0].fa_off;
+
+    if (bs->state == 0 && !last_area && boot_areas_equal(img_off, sz)) {
+        bs->skip = 1;
+    }
+    if (bs->skip) {
+        while (bs->state < BOOT_STATUS_STATE_COUNT - 1) {
+            bs->state++;
+            (void)boot_write_status_skip(bs);
+        }
+
+        bs->idx++;
+        bs->state = 0;
+        bs->skip = 0;
+        (void)boot_write_status(bs);
+        return 0;
+    }
+
     if (bs->state == 0) {
         rc = boot_erase_area(FLASH_AREA_IMAGE_SCRATCH, 0, sz);
         if (rc != 0) {
@@ -783,9 +917,7 @@ boot_swap_areas(int idx, uint32_t sz, struct boot_status *bs)
         }
 
         copy_sz = sz;
-        if (boot_data.imgs[0].sectors[idx].fa_off + sz >=
-            boot_data.imgs[1].sectors[0].fa_off) {
-
+        if (last_area) {
             /* This is the end of the area.  Don't copy the image state into
              * slot 1.
              */
@@ -950,6 +1082,13 @@ boot_go(struct boot_rsp *rsp)
     boot_data.imgs[0].sectors = slot0_sectors;
     boot_data.imgs[1].sectors = slot1_sectors;
 
+    /* Kept as words so that it is aligned for flash drivers that DMA out of
+     * it.
+     */
+    static uint32_t copy_buf[(BOOT_COPY_BUF_SZ + sizeof(uint32_t) - 1) /
+                             sizeof(uint32_t)];
+    boot_data.copy_buf = (uint8_t *)copy_buf;
+
     /* Determine the sector layout of the image slots and scratch area. */
     rc = boot_read_sectors();
     if (rc != 0) {
@@ -994,13 +1133,22 @@ boot_go(struct boot_rsp *rsp)
         break;
 
     case BOOT_SWAP_TYPE_TEST:
-        slot = 1;
-        boot_finalize_test_swap();
-        break;
-
     case BOOT_SWAP_TYPE_REVERT:
-        slot = 1;
-        boot_finalize_revert_swap();
+        /* The headers were read before the swap, possibly from slots left
+         * half swapped by a reset.  Read the header of the image which is
+         * in slot 0 now.
+         */
+        rc = boot_read_image_header(0, &boot_data.imgs[0].hdr);
+        if (rc != 0) {
+            return rc;
+        }
+        slot = 0;
+
+        if (swap_type == BOOT_SWAP_TYPE_TEST) {
+            boot_finalize_test_swap();
+        } else {
+            boot_finalize_revert_swap();
+        }
         break;
 
     case BOOT_SWAP_TYPE_FAIL:
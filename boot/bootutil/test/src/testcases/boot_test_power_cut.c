@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "boot_test.h"
+#ifdef ARCH_sim
+#include "mcu/mcu_sim.h"
+#endif
+
+/*
+ * Cuts power at every write/erase of a swap in turn, and checks that the
+ * swap completes after the next boot.
+ */
+TEST_CASE(boot_test_power_cut)
+{
+#ifdef ARCH_sim
+    struct image_header hdr0 = {
+        .ih_magic = IMAGE_MAGIC,
+        .ih_tlv_size = 4 + 32,
+        .ih_hdr_size = BOOT_TEST_HEADER_SIZE,
+        .ih_img_size = 5 * 1024,
+        .ih_flags = IMAGE_F_SHA256,
+        .ih_ver = { 0, 5, 21, 432 },
+    };
+
+    struct image_header hdr1 = {
+        .ih_magic = IMAGE_MAGIC,
+        .ih_tlv_size = 4 + 32,
+        .ih_hdr_size = BOOT_TEST_HEADER_SIZE,
+        .ih_img_size = 32 * 1024,
+        .ih_flags = IMAGE_F_SHA256,
+        .ih_ver = { 1, 2, 3, 432 },
+    };
+    struct boot_rsp rsp;
+    uint32_t ops;
+    int rc;
+
+    for (ops = 1; ; ops++) {
+        native_flash_power_restore();
+        boot_test_util_init_flash();
+        boot_test_util_write_image(&hdr0, 0);
+        boot_test_util_write_hash(&hdr0, 0);
+        boot_test_util_write_image(&hdr1, 1);
+        boot_test_util_write_hash(&hdr1, 1);
+
+        rc = boot_set_pending();
+        TEST_ASSERT_FATAL(rc == 0);
+
+        native_flash_power_cut(ops);
+        rc = boot_go(&rsp);
+        TEST_ASSERT_FATAL(rc == 0);
+        if (!native_flash_power_is_cut()) {
+            /* Swap finished before the cut. */
+            break;
+        }
+
+        native_flash_power_restore();
+        rc = boot_go(&rsp);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(memcmp(rsp.br_hdr, &hdr1, sizeof hdr1) == 0,
+                          "wrong image after cut at op %d", (int)ops);
+
+        boot_test_util_verify_flash(&hdr1, 1, &hdr0, 0);
+    }
+    native_flash_power_cut(0);
+    TEST_ASSERT(ops > 1);
+#endif
+}
@@ -26,13 +26,32 @@
 extern "C" {
 #endif
 
+struct os_mbuf;
+
+/* State of a streaming decode; see base64_decoder_data(). */
+struct base64_decoder {
+    uint32_t bd_acc;            /* sextets of the current group */
+    uint8_t bd_cnt;             /* characters in the current group */
+    uint8_t bd_pad;             /* padding characters in it */
+};
+
 int base64_encode(const void *, int, char *, uint8_t);
 int base64_decode(const char *, void *buf);
 int base64_pad(char *, int);
 int base64_decode_len(const char *str);
 
+void base64_decoder_init(struct base64_decoder *bd);
+int base64_decoder_data(struct base64_decoder *bd, const char *src, int len,
+                        void *dst);
+int base64_decoder_mbuf(struct base64_decoder *bd, const char *src, int len,
+                        struct os_mbuf *om);
+int base64_decoder_finish(struct base64_decoder *bd);
+
 #define BASE64_ENCODE_SIZE(__size) (((((__size) - 1) / 3) * 4) + 4)
 
+/* Most bytes base64_decoder_data() can produce from __len characters. */
+#define BASE64_DECODE_MAX_LEN(__len) ((((__len) + 3) / 4) * 3)
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,67 +38,72 @@
  * SUCH DAMAGE.
  */
 
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <stdio.h>
 
+#include <os/os_mbuf.h>
 #include <base64/base64.h>
 
 static const char base64_chars[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-static int
-pos(char c)
-{
-    const char *p;
-    for (p = base64_chars; *p; p++)
-        if (*p == c)
-            return p - base64_chars;
-    return -1;
-}
+/* Character classes in base64_dec_tab, besides the sextet values. */
+#define XX      0x80            /* not base64 */
+#define PD      0x81            /* padding */
+#define WS      0x82            /* whitespace; skipped */
+
+static const uint8_t base64_dec_tab[128] = {
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, WS, WS, XX, XX, WS, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    WS, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, 62, XX, XX, XX, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, XX, XX, XX, PD, XX, XX,
+    XX,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, XX, XX, XX, XX, XX,
+    XX, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, XX, XX, XX, XX, XX,
+};
 
 int
 base64_encode(const void *data, int size, char *s, uint8_t should_pad)
 {
     char *p;
     int i;
-    int c;
+    uint32_t c;
     const unsigned char *q;
-    char *last;
     int diff;
 
     p = s;
-
     q = (const unsigned char *) data;
-    last = NULL;
-    i = 0;
-    while (i < size) {
-        c = q[i++];
-        c *= 256;
-        if (i < size)
-            c += q[i];
-        i++;
-        c *= 256;
-        if (i < size)
-            c += q[i];
-        i++;
-        p[0] = base64_chars[(c & 0x00fc0000) >> 18];
-        p[1] = base64_chars[(c & 0x0003f000) >> 12];
-        p[2] = base64_chars[(c & 0x00000fc0) >> 6];
-        p[3] = base64_chars[(c & 0x0000003f) >> 0];
-        last = p;
+
+    /* Whole groups. */
+    for (i = 0; i + 3 <= size; i += 3) {
+        c = (q[i] << 16) | (q[i + 1] << 8) | q[i + 2];
+        p[0] = base64_chars[c >> 18];
+        p[1] = base64_chars[(c >> 12) & 0x3f];
+        p[2] = base64_chars[(c >> 6) & 0x3f];
+        p[3] = base64_chars[c & 0x3f];
         p += 4;
     }
 
-    if (last) {
-        diff = i - size;
-        if (diff > 0) {
-            if (should_pad) {
-                memset(last + (4 - diff), '=', diff);
-            } else {
-                p = last + (4 - diff);
-            }
+    /* The last, partial group. */
+    diff = size - i;
+    if (diff > 0) {
+        c = q[i] << 16;
+        if (diff > 1) {
+            c |= q[i + 1] << 8;
+        }
+        p[0] = base64_chars[c >> 18];
+        p[1] = base64_chars[(c >> 12) & 0x3f];
+        p[2] = base64_chars[(c >> 6) & 0x3f];
+        if (should_pad) {
+            p[2] = diff > 1 ? p[2] : '=';
+            p[3] = '=';
+            p += 4;
+        } else {
+            p += diff + 1;
         }
     }
 
@@ -122,49 +127,169 @@ base64_pad(char *buf, int len)
     return (4 - remainder);
 }
 
-#define DECODE_ERROR -1
+void
+base64_decoder_init(struct base64_decoder *bd)
+{
+    bd->bd_acc = 0;
+    bd->bd_cnt = 0;
+    bd->bd_pad = 0;
+}
 
-static unsigned int
-token_decode(const char *token)
+/**
+ * Decodes the next chunk of base64 text.  The text may be split anywhere;
+ * a partial group is carried over to the next call.  Whitespace is
+ * skipped.
+ *
+ * Decoding in place (dst == src) only works when no partial group is
+ * carried over, e.g. for a single call right after base64_decoder_init().
+ * Otherwise completing the carried group can write past the input read
+ * so far.
+ *
+ * @param bd                    The decoder.
+ * @param src                   Text to decode.
+ * @param len                   Number of characters in src.
+ * @param dst                   Where to write the decoded data; must have
+ *                                  room for BASE64_DECODE_MAX_LEN(len)
+ *                                  bytes.
+ *
+ * @return                      Number of bytes written; -1 if the text
+ *                                  is malformed.
+ */
+int
+base64_decoder_data(struct base64_decoder *bd, const char *src, int len,
+                    void *dst)
 {
-    int i;
-    unsigned int val = 0;
-    int marker = 0;
-    if (strlen(token) < 4)
-        return DECODE_ERROR;
-    for (i = 0; i < 4; i++) {
-        val *= 64;
-        if (token[i] == '=')
-            marker++;
-        else if (marker > 0)
-            return DECODE_ERROR;
-        else
-            val += pos(token[i]);
+    const uint8_t *s;
+    const uint8_t *end;
+    uint8_t *q;
+    uint8_t a;
+    uint8_t b;
+    uint8_t c;
+    uint8_t d;
+    uint8_t v;
+
+    assert(dst != src || bd->bd_cnt == 0);
+
+    s = (const uint8_t *)src;
+    end = s + len;
+    q = dst;
+
+    while (s < end) {
+        /* Whole groups, when not in the middle of one. */
+        while (bd->bd_cnt == 0 && end - s >= 4 &&
+               ((s[0] | s[1] | s[2] | s[3]) & 0x80) == 0) {
+            a = base64_dec_tab[s[0]];
+            b = base64_dec_tab[s[1]];
+            c = base64_dec_tab[s[2]];
+            d = base64_dec_tab[s[3]];
+            if ((a | b | c | d) & 0x80) {
+                break;
+            }
+            q[0] = (a << 2) | (b >> 4);
+            q[1] = (b << 4) | (c >> 2);
+            q[2] = (c << 6) | d;
+            q += 3;
+            s += 4;
+        }
+        if (s == end) {
+            break;
+        }
+
+        /* Padding, whitespace, or a group split across calls. */
+        v = *s & 0x80 ? XX : base64_dec_tab[*s];
+        s++;
+        if (v == WS) {
+            continue;
+        } else if (v == PD) {
+            if (bd->bd_cnt < 2) {
+                return -1;
+            }
+            bd->bd_pad++;
+            v = 0;
+        } else if (v == XX || bd->bd_pad) {
+            return -1;
+        }
+        bd->bd_acc = (bd->bd_acc << 6) | v;
+        if (++bd->bd_cnt == 4) {
+            *q++ = bd->bd_acc >> 16;
+            if (bd->bd_pad < 2) {
+                *q++ = bd->bd_acc >> 8;
+            }
+            if (bd->bd_pad < 1) {
+                *q++ = bd->bd_acc;
+            }
+            base64_decoder_init(bd);
+        }
     }
-    if (marker > 2)
-        return DECODE_ERROR;
-    return (marker << 24) | val;
+    return q - (uint8_t *)dst;
 }
 
+/**
+ * Decodes the next chunk of base64 text, appending the result to an mbuf
+ * chain.  See base64_decoder_data().
+ *
+ * @return                      Number of bytes appended; -1 if the text
+ *                                  is malformed or mbufs ran out.
+ */
 int
-base64_decode(const char *str, void *data)
+base64_decoder_mbuf(struct base64_decoder *bd, const char *src, int len,
+                    struct os_mbuf *om)
 {
-    const char *p;
-    unsigned char *q;
-
-    q = data;
-    for (p = str; *p && (*p == '=' || strchr(base64_chars, *p)); p += 4) {
-        unsigned int val = token_decode(p);
-        unsigned int marker = (val >> 24) & 0xff;
-        if (val == DECODE_ERROR)
+    uint8_t buf[48];
+    int chunk;
+    int total;
+    int rc;
+
+    total = 0;
+    while (len > 0) {
+        chunk = len;
+        if (chunk > sizeof(buf) / 3 * 4) {
+            chunk = sizeof(buf) / 3 * 4;
+        }
+        rc = base64_decoder_data(bd, src, chunk, buf);
+        if (rc < 0 || os_mbuf_append(om, buf, rc)) {
             return -1;
-        *q++ = (val >> 16) & 0xff;
-        if (marker < 2)
-            *q++ = (val >> 8) & 0xff;
-        if (marker < 1)
-            *q++ = val & 0xff;
+        }
+        total += rc;
+        src += chunk;
+        len -= chunk;
+    }
+    return total;
+}
+
+/**
+ * Checks that the text decoded so far did not end in the middle of a
+ * group.
+ *
+ * @return                      0 if so; -1 otherwise.
+ */
+int
+base64_decoder_finish(struct base64_decoder *bd)
+{
+    return bd->bd_cnt ? -1 : 0;
+}
+
+int
+base64_decode(const char *str, void *data)
+{
+    struct base64_decoder bd;
+    int len;
+    int rc;
+
+    /* Decodes up to the first character which isn't base64. */
+    for (len = 0; str[len]; len++) {
+        if (str[len] & 0x80 || base64_dec_tab[(uint8_t)str[len]] == XX ||
+            base64_dec_tab[(uint8_t)str[len]] == WS) {
+            break;
+        }
+    }
+
+    base64_decoder_init(&bd);
+    rc = base64_decoder_data(&bd, str, len, data);
+    if (rc < 0 || base64_decoder_finish(&bd)) {
+        return -1;
     }
-    return q - (unsigned char *) data;
+    return rc;
 }
 
 
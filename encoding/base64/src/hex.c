@@ -41,20 +41,66 @@ hex_format(void *src_v, int src_len, char *dst, int dst_len)
     int i;
     uint8_t *src = (uint8_t *)src_v;
     char *tgt = dst;
+    uint32_t x;
+    uint32_t ge10;
 
     if (dst_len <= src_len * 2) {
         return NULL;
     }
-    for (i = 0; i < src_len; i++) {
+    for (i = 0; i + 2 <= src_len; i += 2) {
+        /*
+         * Four nibbles at a time, one per byte; the ones over 9 get
+         * 'a' - '0' - 10 added.
+         */
+        x = (src[i] >> 4) | ((src[i] & 0xf) << 8) |
+            ((src[i + 1] >> 4) << 16) | ((uint32_t)(src[i + 1] & 0xf) << 24);
+        ge10 = ((x + 0x76767676) >> 7) & 0x01010101;
+        x += 0x30303030 + ge10 * 39;
+        tgt[0] = x;
+        tgt[1] = x >> 8;
+        tgt[2] = x >> 16;
+        tgt[3] = x >> 24;
+        tgt += 4;
+    }
+    if (i < src_len) {
         tgt[0] = hex_bytes[(src[i] >> 4) & 0xf];
         tgt[1] = hex_bytes[src[i] & 0xf];
         tgt += 2;
-        dst_len -= 2;
     }
     *tgt = '\0';
     return dst;
 }
 
+/*
+ * Converts four hex characters, one per byte of x, to their values.
+ *
+ * @return		0 on success; -1 if any isn't a hex digit
+ */
+static int
+hex_parse_word(uint32_t x, uint32_t *out)
+{
+    uint32_t lc;
+    uint32_t digit;
+    uint32_t alpha;
+
+    if (x & 0x80808080) {
+        return -1;
+    }
+    /*
+     * For bytes under 128, adding 128 - k sets the top bit iff the byte
+     * is at least k.  Setting 0x20 folds 'A'-'F' onto 'a'-'f', and leaves
+     * digits as they are.
+     */
+    lc = x | 0x20202020;
+    digit = (x + 0x50505050) & ~(x + 0x46464646) & 0x80808080;
+    alpha = (lc + 0x1f1f1f1f) & ~(lc + 0x19191919) & 0x80808080;
+    if ((digit | alpha) != 0x80808080) {
+        return -1;
+    }
+    *out = (lc & 0x0f0f0f0f) + (alpha >> 7) * 9;
+    return 0;
+}
+
 /*
  * Turn string of hex decimals into a byte array. I.e. "01" -> "\x01
  *
@@ -70,6 +116,7 @@ hex_parse(char *src, int src_len, void *dst_v, int dst_len)
 {
     int i;
     uint8_t *dst = (uint8_t *)dst_v;
+    uint32_t x;
     char c;
 
     if (src_len & 0x1) {
@@ -78,7 +125,17 @@ hex_parse(char *src, int src_len, void *dst_v, int dst_len)
     if (dst_len * 2 < src_len) {
         return -1;
     }
-    for (i = 0; i < src_len; i++, src++) {
+    for (i = 0; i + 4 <= src_len; i += 4, src += 4) {
+        x = (uint8_t)src[0] | ((uint8_t)src[1] << 8) |
+            ((uint8_t)src[2] << 16) | ((uint32_t)(uint8_t)src[3] << 24);
+        if (hex_parse_word(x, &x)) {
+            return -1;
+        }
+        dst[0] = (x << 4) | ((x >> 8) & 0xf);
+        dst[1] = ((x >> 12) & 0xf0) | (x >> 24);
+        dst += 2;
+    }
+    for (; i < src_len; i++, src++) {
         c = *src;
         if (isdigit((int) c)) {
             c -= '0';
@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "encoding_test_priv.h"
+
+TEST_CASE(base64_codec)
+{
+    char enc[64];
+    uint8_t dec[64];
+    uint8_t all[48];
+    int i;
+    int rc;
+
+    struct {
+        char *in;
+        char *out;
+    } test_data[] = {
+        /* RFC 4648 test vectors. */
+        { "", "" },
+        { "f", "Zg==" },
+        { "fo", "Zm8=" },
+        { "foo", "Zm9v" },
+        { "foob", "Zm9vYg==" },
+        { "fooba", "Zm9vYmE=" },
+        { "foobar", "Zm9vYmFy" },
+    };
+
+    for (i = 0; i < sizeof(test_data) / sizeof(test_data[0]); i++) {
+        rc = base64_encode(test_data[i].in, strlen(test_data[i].in), enc, 1);
+        TEST_ASSERT(rc == strlen(test_data[i].out));
+        TEST_ASSERT(!strcmp(enc, test_data[i].out));
+
+        rc = base64_decode(test_data[i].out, dec);
+        TEST_ASSERT(rc == strlen(test_data[i].in));
+        TEST_ASSERT(!memcmp(dec, test_data[i].in, rc));
+    }
+
+    /* Every character of the alphabet. */
+    for (i = 0; i < sizeof(all); i++) {
+        all[i] = i * 5 + 3;
+    }
+    rc = base64_encode(all, sizeof(all), enc, 1);
+    TEST_ASSERT(rc == 64);
+    rc = base64_decode(enc, dec);
+    TEST_ASSERT(rc == sizeof(all));
+    TEST_ASSERT(!memcmp(dec, all, sizeof(all)));
+
+    /* Unpadded. */
+    rc = base64_encode("fooba", 5, enc, 0);
+    TEST_ASSERT(rc == 7);
+    TEST_ASSERT(!strcmp(enc, "Zm9vYmE"));
+
+    /* Decoding stops at the first non-base64 character. */
+    rc = base64_decode("Zm9v\nZm9v", dec);
+    TEST_ASSERT(rc == 3);
+
+    /*
+     * Test invalid input
+     */
+    rc = base64_decode("Zm9", dec);
+    TEST_ASSERT(rc < 0);
+
+    rc = base64_decode("Z===", dec);
+    TEST_ASSERT(rc < 0);
+
+    rc = base64_decode("Zm=v", dec);
+    TEST_ASSERT(rc < 0);
+}
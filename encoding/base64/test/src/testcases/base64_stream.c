@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "os/os.h"
+#include "encoding_test_priv.h"
+
+#define BASE64_TEST_MBUF_CNT    8
+#define BASE64_TEST_MBUF_SIZE   32
+
+static os_membuf_t base64_test_mbuf_mem[
+    OS_MEMPOOL_SIZE(BASE64_TEST_MBUF_CNT,
+                    BASE64_TEST_MBUF_SIZE + sizeof(struct os_mbuf))
+];
+
+TEST_CASE(base64_stream)
+{
+    struct os_mbuf_pool mbuf_pool;
+    struct os_mempool mempool;
+    struct base64_decoder bd;
+    struct os_mbuf *om;
+    char enc[BASE64_ENCODE_SIZE(100) + 1];
+    uint8_t data[100];
+    uint8_t dec[100];
+    int enc_len;
+    int chunk;
+    int off;
+    int len;
+    int i;
+    int rc;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = i * 7 + 1;
+    }
+    enc_len = base64_encode(data, sizeof(data), enc, 1);
+
+    /* Any split decodes the same. */
+    for (chunk = 1; chunk <= 9; chunk++) {
+        base64_decoder_init(&bd);
+        len = 0;
+        for (off = 0; off < enc_len; off += chunk) {
+            i = enc_len - off < chunk ? enc_len - off : chunk;
+            rc = base64_decoder_data(&bd, enc + off, i, dec + len);
+            TEST_ASSERT(rc >= 0);
+            TEST_ASSERT(rc <= BASE64_DECODE_MAX_LEN(i));
+            len += rc;
+        }
+        TEST_ASSERT(base64_decoder_finish(&bd) == 0);
+        TEST_ASSERT(len == sizeof(data));
+        TEST_ASSERT(!memcmp(dec, data, sizeof(data)));
+    }
+
+    /* Whitespace is skipped, and padded groups can follow each other. */
+    base64_decoder_init(&bd);
+    rc = base64_decoder_data(&bd, "Zm 9v\r\nZg==Zg=", 14, dec);
+    TEST_ASSERT(rc == 4);
+    TEST_ASSERT(base64_decoder_finish(&bd) == -1);
+    rc = base64_decoder_data(&bd, "=", 1, dec + 4);
+    TEST_ASSERT(rc == 1);
+    TEST_ASSERT(base64_decoder_finish(&bd) == 0);
+    TEST_ASSERT(!memcmp(dec, "fooff", 5));
+
+    /* Into an mbuf chain. */
+    rc = os_mempool_init(&mempool, BASE64_TEST_MBUF_CNT,
+                         BASE64_TEST_MBUF_SIZE + sizeof(struct os_mbuf),
+                         base64_test_mbuf_mem, "base64_test");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&mbuf_pool, &mempool,
+                           BASE64_TEST_MBUF_SIZE + sizeof(struct os_mbuf),
+                           BASE64_TEST_MBUF_CNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    om = os_mbuf_get_pkthdr(&mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    base64_decoder_init(&bd);
+    rc = base64_decoder_mbuf(&bd, enc, 50, om);
+    TEST_ASSERT(rc == 36);
+    rc = base64_decoder_mbuf(&bd, enc + 50, enc_len - 50, om);
+    TEST_ASSERT(rc == sizeof(data) - 36);
+    TEST_ASSERT(base64_decoder_finish(&bd) == 0);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == sizeof(data));
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, data, sizeof(data)) == 0);
+    os_mbuf_free_chain(om);
+
+    /* In place. */
+    base64_decoder_init(&bd);
+    rc = base64_decoder_data(&bd, enc, enc_len, enc);
+    TEST_ASSERT(rc == sizeof(data));
+    TEST_ASSERT(!memcmp(enc, data, sizeof(data)));
+
+    /*
+     * Test invalid input
+     */
+    base64_decoder_init(&bd);
+    rc = base64_decoder_data(&bd, "Zm9v!", 5, dec);
+    TEST_ASSERT(rc < 0);
+
+    base64_decoder_init(&bd);
+    rc = base64_decoder_data(&bd, "Zg==", 2, dec);
+    TEST_ASSERT(rc == 0);
+    rc = base64_decoder_data(&bd, "=A", 2, dec);
+    TEST_ASSERT(rc < 0);
+}
@@ -51,10 +51,22 @@ typedef enum CborAttrType {
     CborAttrDoubleType,
     CborAttrArrayType,
     CborAttrNullType,
+    CborAttrByteStringRefType,
 } CborAttrType;
 
 struct cbor_attr_t;
 
+/*
+ * A byte string left in place in the decoder's input, filled in for
+ * CborAttrByteStringRefType attributes.  Only valid while the input is.
+ * Read it with cbor_bytes_ref_ptr() or cbor_bytes_ref_copy().
+ */
+struct cbor_bytes_ref {
+    struct cbor_decoder_reader *reader;
+    int off;                    /* offset of the contents in the input */
+    size_t len;
+};
+
 struct cbor_enum_t {
     char *name;
     long long int value;
@@ -104,6 +116,7 @@ struct cbor_attr_t {
             uint8_t *data;
             size_t *len;
         } bytestring;
+        struct cbor_bytes_ref *bytesref;
         struct cbor_array_t array;
         size_t offset;
     } addr;
@@ -118,8 +131,33 @@ struct cbor_attr_t {
     bool nodefault;
 };
 
+/*
+ * Lookup index over an attribute table; see cbor_attr_index_init().
+ * Entries are sorted by name length and hash.
+ */
+struct cbor_attr_index_entry {
+    uint32_t cie_hash;
+    uint8_t cie_len;
+    uint8_t cie_idx;
+};
+
+struct cbor_attr_index {
+    const struct cbor_attr_index_entry *ci_entries;
+    int ci_cnt;
+};
+
 int cbor_read_object(struct CborValue *, const struct cbor_attr_t *);
 int cbor_read_array(struct CborParser *, const struct cbor_array_t *);
+int cbor_attr_index_init(struct cbor_attr_index *ci,
+                         struct cbor_attr_index_entry *entries,
+                         int max_entries, const struct cbor_attr_t *attrs);
+int cbor_read_object_indexed(struct CborValue *,
+                             const struct cbor_attr_t *,
+                             const struct cbor_attr_index *);
+const uint8_t *cbor_bytes_ref_ptr(const struct cbor_bytes_ref *ref,
+                                  size_t off, size_t *len);
+int cbor_bytes_ref_copy(const struct cbor_bytes_ref *ref, size_t off,
+                        void *dst, size_t len);
 
 
 #ifdef __cplusplus
@@ -33,6 +33,7 @@ valid_attr_type(CborType ct, CborAttrType at) {
             }
             break;
         case CborAttrByteStringType:
+        case CborAttrByteStringRefType:
             if (ct == CborByteStringType) {
                 return 1;
             }
@@ -104,6 +105,9 @@ cbor_target_address(const struct cbor_attr_t *cursor,
         case CborAttrByteStringType:
             targetaddr = (char *) cursor->addr.bytestring.data;
             break;
+        case CborAttrByteStringRefType:
+            targetaddr = (char *) cursor->addr.bytesref;
+            break;
         case CborAttrTextStringType:
             targetaddr = cursor->addr.string;
             break;
@@ -123,15 +127,179 @@ cbor_target_address(const struct cbor_attr_t *cursor,
     return targetaddr;
 }
 
+/*
+ * Returns the offset of the contents of the definite-length string at
+ * "value", i.e. skips its header.
+ */
+static int
+cbor_string_data_offset(const CborValue *value)
+{
+    struct cbor_decoder_reader *d;
+    int off;
+
+    d = value->parser->d;
+    off = value->offset + 1;
+    switch (d->get8(d, value->offset) & 0x1f) {
+    case 24:
+        off += 1;
+        break;
+    case 25:
+        off += 2;
+        break;
+    case 26:
+        off += 4;
+        break;
+    case 27:
+        off += 8;
+        break;
+    default:
+        break;
+    }
+    return off;
+}
+
+/* FNV-1a, over the attribute name. */
+#define CBOR_ATTR_HASH_INIT     2166136261u
+
+static uint32_t
+cbor_attr_hash(uint32_t hash, uint8_t c)
+{
+    return (hash ^ c) * 16777619u;
+}
+
+static int
+cbor_attr_index_cmp(const struct cbor_attr_index_entry *a,
+                    const struct cbor_attr_index_entry *b)
+{
+    if (a->cie_len != b->cie_len) {
+        return a->cie_len < b->cie_len ? -1 : 1;
+    }
+    if (a->cie_hash != b->cie_hash) {
+        return a->cie_hash < b->cie_hash ? -1 : 1;
+    }
+    return (int)a->cie_idx - (int)b->cie_idx;
+}
+
+/**
+ * Builds a lookup index for an attribute table.  The index only depends on
+ * the attribute names, so it can be built once and used with any table
+ * listing the same attributes in the same order, e.g. one on the stack
+ * pointing at local variables.
+ *
+ * @param ci                    The index to fill in.
+ * @param entries               Storage for the index; one entry per
+ *                                  attribute.
+ * @param max_entries           Number of elements in entries.
+ * @param attrs                 The attribute table.
+ *
+ * @return                      0 on success; CborErrorDataTooLarge if the
+ *                                  table has too many attributes.
+ */
+int
+cbor_attr_index_init(struct cbor_attr_index *ci,
+                     struct cbor_attr_index_entry *entries, int max_entries,
+                     const struct cbor_attr_t *attrs)
+{
+    struct cbor_attr_index_entry ent;
+    const char *c;
+    int cnt;
+    int i;
+
+    for (cnt = 0; attrs[cnt].attribute != NULL; cnt++) {
+        if (cnt >= max_entries || cnt > UINT8_MAX ||
+            strlen(attrs[cnt].attribute) > CBOR_ATTR_MAX) {
+            return CborErrorDataTooLarge;
+        }
+        ent.cie_hash = CBOR_ATTR_HASH_INIT;
+        for (c = attrs[cnt].attribute; *c != '\0'; c++) {
+            ent.cie_hash = cbor_attr_hash(ent.cie_hash, *c);
+        }
+        ent.cie_len = c - attrs[cnt].attribute;
+        ent.cie_idx = cnt;
+
+        /* Insertion sort; tables are small. */
+        for (i = cnt; i > 0 && cbor_attr_index_cmp(&entries[i - 1], &ent) > 0;
+             i--) {
+            entries[i] = entries[i - 1];
+        }
+        entries[i] = ent;
+    }
+
+    ci->ci_entries = entries;
+    ci->ci_cnt = cnt;
+    return 0;
+}
+
+/*
+ * Finds the first attribute matching the key at "key" and the value type.
+ * The key must be a text string of known length; it is hashed and compared
+ * where it sits in the reader, without copying it out.
+ */
+static const struct cbor_attr_t *
+cbor_attr_index_find(const struct cbor_attr_index *ci,
+                     const struct cbor_attr_t *attrs, const CborValue *key,
+                     CborType type)
+{
+    const struct cbor_attr_index_entry *ent;
+    struct cbor_decoder_reader *d;
+    uint32_t hash;
+    size_t len;
+    int off;
+    int lo;
+    int hi;
+    int mid;
+    int i;
+
+    if (cbor_value_get_string_length(key, &len) != CborNoError ||
+        len > CBOR_ATTR_MAX) {
+        return NULL;
+    }
+
+    d = key->parser->d;
+    off = cbor_string_data_offset(key);
+
+    hash = CBOR_ATTR_HASH_INIT;
+    for (i = 0; i < len; i++) {
+        hash = cbor_attr_hash(hash, d->get8(d, off + i));
+    }
+
+    lo = 0;
+    hi = ci->ci_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        ent = &ci->ci_entries[mid];
+        if (ent->cie_len < len ||
+            (ent->cie_len == len && ent->cie_hash < hash)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < ci->ci_cnt; lo++) {
+        ent = &ci->ci_entries[lo];
+        if (ent->cie_len != len || ent->cie_hash != hash) {
+            break;
+        }
+        if (valid_attr_type(type, attrs[ent->cie_idx].type) &&
+            d->cmp(d, attrs[ent->cie_idx].attribute, off, len) == 0) {
+            return &attrs[ent->cie_idx];
+        }
+    }
+    return NULL;
+}
+
 static int
 cbor_internal_read_object(CborValue *root_value,
                           const struct cbor_attr_t *attrs,
+                          const struct cbor_attr_index *ci,
                           const struct cbor_array_t *parent,
                           int offset) {
     const struct cbor_attr_t *cursor;
     char attrbuf[CBOR_ATTR_MAX + 1];
     char *lptr;
     CborValue cur_value;
+    CborValue key;
+    bool indexed;
     CborError g_err = 0;
     size_t len;
     CborType type = CborInvalidType;
@@ -151,6 +319,9 @@ cbor_internal_read_object(CborValue *root_value,
                     case CborAttrBooleanType:
                         memcpy(lptr, &cursor->dflt.boolean, sizeof(bool));
                         break;
+                    case CborAttrByteStringRefType:
+                        memset(lptr, 0, sizeof(struct cbor_bytes_ref));
+                        break;
 #if FLOAT_SUPPORT
                     case CborAttrFloatType:
                         memcpy(lptr, &cursor->dflt.fval, sizeof(float));
@@ -177,12 +348,18 @@ cbor_internal_read_object(CborValue *root_value,
     while (cbor_value_is_valid(&cur_value)) {
         /* get the attribute */
         if (cbor_value_is_text_string(&cur_value)) {
+            /* Indexed lookups compare the key in place. */
+            key = cur_value;
+            indexed = ci != NULL && cbor_value_is_length_known(&cur_value);
             if (cbor_value_calculate_string_length(&cur_value, &len) == 0) {
                 if (len > CBOR_ATTR_MAX) {
                     g_err |= CborErrorDataTooLarge;
                     goto g_err_return;
                 }
-                g_err |= cbor_value_copy_text_string(&cur_value, attrbuf, &len, NULL);
+                if (!indexed) {
+                    g_err |= cbor_value_copy_text_string(&cur_value, attrbuf,
+                                                         &len, NULL);
+                }
             }
         } else {
             g_err |= CborErrorIllegalType;
@@ -200,15 +377,23 @@ cbor_internal_read_object(CborValue *root_value,
         }
 
         /* find this attribute in our list */
-        for (cursor = attrs; cursor->attribute != NULL; cursor++) {
-            if ( valid_attr_type(type, cursor->type) &&
-                (memcmp(cursor->attribute, attrbuf, len) == 0 )) {
-                break;
+        if (indexed) {
+            cursor = cbor_attr_index_find(ci, attrs, &key, type);
+        } else {
+            for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+                if (valid_attr_type(type, cursor->type) &&
+                    strncmp(cursor->attribute, attrbuf, len) == 0 &&
+                    cursor->attribute[len] == '\0') {
+                    break;
+                }
+            }
+            if (cursor->attribute == NULL) {
+                cursor = NULL;
             }
         }
 
         /* we found a match */
-        if ( cursor->attribute != NULL ) {
+        if (cursor != NULL) {
            lptr = cbor_target_address(cursor, parent, offset);
             switch (cursor->type) {
                 case CborAttrNullType:
@@ -238,6 +423,23 @@ cbor_internal_read_object(CborValue *root_value,
                     *cursor->addr.bytestring.len = len;
                     break;
                 }
+                case CborAttrByteStringRefType:
+                {
+                    struct cbor_bytes_ref *ref = (struct cbor_bytes_ref *) lptr;
+                    size_t len;
+
+                    /* Chunked strings aren't contiguous in the input. */
+                    if (cur_value.parser->d->ptr == NULL ||
+                        cbor_value_get_string_length(&cur_value, &len) !=
+                          CborNoError) {
+                        g_err |= CborErrorUnsupportedType;
+                        break;
+                    }
+                    ref->reader = cur_value.parser->d;
+                    ref->off = cbor_string_data_offset(&cur_value);
+                    ref->len = len;
+                    break;
+                }
                 case CborAttrTextStringType:
                 {
                     size_t len = cursor->len;
@@ -251,10 +453,13 @@ cbor_internal_read_object(CborValue *root_value,
         }
         cbor_value_advance(&cur_value);
     }
-g_err_return:
     /* that should be it for this container */
     g_err |= cbor_value_leave_container(root_value, &cur_value);
     return g_err;
+
+g_err_return:
+    /* Stopped inside the container; it can't be left from here. */
+    return g_err;
 }
 
 int
@@ -262,6 +467,82 @@ cbor_read_object(struct CborValue *value, const struct cbor_attr_t *attrs)
 {
     int st;
 
-    st = cbor_internal_read_object(value, attrs, NULL, 0);
+    st = cbor_internal_read_object(value, attrs, NULL, NULL, 0);
     return st;
 }
+
+/**
+ * Same as cbor_read_object(), but looks attributes up in an index built
+ * with cbor_attr_index_init(), comparing keys in place rather than copying
+ * each one out and scanning the table for it.  Worth it for tables with
+ * many attributes.
+ */
+int
+cbor_read_object_indexed(struct CborValue *value,
+                         const struct cbor_attr_t *attrs,
+                         const struct cbor_attr_index *ci)
+{
+    return cbor_internal_read_object(value, attrs, ci, NULL, 0);
+}
+
+/**
+ * Returns a pointer into the decoder's input for a byte string decoded as
+ * CborAttrByteStringRefType.  The input need not be contiguous (e.g. an
+ * mbuf chain), so only part of the string may be available at the pointer.
+ *
+ * @param ref                   The byte string.
+ * @param off                   Offset within the string.
+ * @param len                   On success, the number of contiguous bytes
+ *                                  available, at most ref->len - off.
+ *
+ * @return                      Pointer to the data; NULL if off is past the
+ *                                  end of the string.
+ */
+const uint8_t *
+cbor_bytes_ref_ptr(const struct cbor_bytes_ref *ref, size_t off, size_t *len)
+{
+    const uint8_t *ptr;
+
+    if (off >= ref->len) {
+        *len = 0;
+        return NULL;
+    }
+    ptr = ref->reader->ptr(ref->reader, ref->off + off, len);
+    if (ptr == NULL) {
+        *len = 0;
+        return NULL;
+    }
+    if (*len > ref->len - off) {
+        *len = ref->len - off;
+    }
+    return ptr;
+}
+
+/**
+ * Copies part of a byte string decoded as CborAttrByteStringRefType.
+ *
+ * @return                      0 on success; CborErrorIO if the string is
+ *                                  shorter than off + len.
+ */
+int
+cbor_bytes_ref_copy(const struct cbor_bytes_ref *ref, size_t off, void *dst,
+                    size_t len)
+{
+    const uint8_t *ptr;
+    size_t cnt;
+
+    while (len > 0) {
+        ptr = cbor_bytes_ref_ptr(ref, off, &cnt);
+        if (ptr == NULL) {
+            return CborErrorIO;
+        }
+        if (cnt > len) {
+            cnt = len;
+        }
+        memcpy(dst, ptr, cnt);
+        dst = (uint8_t *)dst + cnt;
+        off += cnt;
+        len -= cnt;
+    }
+    return 0;
+}
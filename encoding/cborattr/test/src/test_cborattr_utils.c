@@ -0,0 +1,40 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_cborattr.h"
+#include "tinycbor/cbor_buf_reader.h"
+
+/*
+ * Decodes the CBOR map in data; through the index if ci is not NULL.
+ */
+int
+test_cborattr_read(const char *data, int len,
+                   const struct cbor_attr_t *attrs,
+                   const struct cbor_attr_index *ci)
+{
+    struct cbor_buf_reader reader;
+    struct CborParser parser;
+    struct CborValue value;
+
+    cbor_buf_reader_init(&reader, (const uint8_t *)data, len);
+    cbor_parser_init(&reader.r, 0, &parser, &value);
+    if (ci) {
+        return cbor_read_object_indexed(&value, attrs, ci);
+    }
+    return cbor_read_object(&value, attrs);
+}
@@ -0,0 +1,128 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_cborattr.h"
+
+/*
+ * {"KeyUint": 77, "Key": "k", "KeyAny": 5, "KeyBool": true, "KeyInt": -3}
+ */
+static const char test_cborattr_map[] =
+    "\xa5"
+    "\x67" "KeyUint" "\x18\x4d"
+    "\x63" "Key" "\x61" "k"
+    "\x66" "KeyAny" "\x05"
+    "\x67" "KeyBool" "\xf5"
+    "\x66" "KeyInt" "\x22";
+
+/* {"KeyAny": "any"}, with the key as an indefinite length string. */
+static const char test_cborattr_chunked[] =
+    "\xa1"
+    "\x7f" "\x63" "Key" "\x63" "Any" "\xff"
+    "\x63" "any";
+
+/* Decoding through an attribute index gives the same result as a scan. */
+TEST_CASE(test_cborattr_indexed_decode)
+{
+    struct cbor_attr_index_entry entries[8];
+    struct cbor_attr_index ci;
+    long long unsigned int uint_val;
+    long long int int_val;
+    long long int int_val2;
+    bool bool_val;
+    char str[16];
+    char str2[16];
+    int rc;
+    int i;
+
+    const struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "KeyBool",
+            .type = CborAttrBooleanType,
+            .addr.boolean = &bool_val,
+            .nodefault = true
+        },
+        [1] = {
+            .attribute = "KeyInt",
+            .type = CborAttrIntegerType,
+            .addr.integer = &int_val,
+            .nodefault = true
+        },
+        [2] = {
+            .attribute = "KeyUint",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &uint_val,
+            .nodefault = true
+        },
+        /* Same name, different type; the first one matching is used. */
+        [3] = {
+            .attribute = "KeyAny",
+            .type = CborAttrTextStringType,
+            .addr.string = str,
+            .len = sizeof(str)
+        },
+        [4] = {
+            .attribute = "KeyAny",
+            .type = CborAttrIntegerType,
+            .addr.integer = &int_val2,
+        },
+        [5] = {
+            .attribute = "Key",
+            .type = CborAttrTextStringType,
+            .addr.string = str2,
+            .len = sizeof(str2)
+        },
+        [6] = {
+            .attribute = NULL
+        }
+    };
+
+    rc = cbor_attr_index_init(&ci, entries, 3, attrs);
+    TEST_ASSERT(rc == CborErrorDataTooLarge);
+
+    rc = cbor_attr_index_init(&ci, entries, 8, attrs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ci.ci_cnt == 6);
+
+    /* Scan first, then the index. */
+    for (i = 0; i < 2; i++) {
+        memset(str, 0, sizeof(str));
+        memset(str2, 0, sizeof(str2));
+        uint_val = 0;
+        int_val = 0;
+        bool_val = false;
+
+        rc = test_cborattr_read(test_cborattr_map,
+                                sizeof(test_cborattr_map) - 1, attrs,
+                                i ? &ci : NULL);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(uint_val == 77);
+        TEST_ASSERT(int_val == -3);
+        TEST_ASSERT(bool_val == true);
+        TEST_ASSERT(int_val2 == 5);
+        TEST_ASSERT(str[0] == '\0');
+        TEST_ASSERT(!strcmp(str2, "k"));
+
+        /* Chunked keys can't be compared in place; they are scanned. */
+        rc = test_cborattr_read(test_cborattr_chunked,
+                                sizeof(test_cborattr_chunked) - 1, attrs,
+                                i ? &ci : NULL);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(str, "any"));
+        TEST_ASSERT(int_val2 == 0);
+    }
+}
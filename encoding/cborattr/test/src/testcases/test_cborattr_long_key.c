@@ -0,0 +1,67 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_cborattr.h"
+#include "tinycbor/cbor_buf_writer.h"
+
+/* Keys longer than CBOR_ATTR_MAX are rejected, with or without an index. */
+TEST_CASE(test_cborattr_long_key)
+{
+    struct cbor_attr_index_entry entries[2];
+    struct cbor_attr_index ci;
+    struct CborBufWriter writer;
+    CborEncoder enc;
+    CborEncoder map;
+    long long int int_val;
+    char key[CBOR_ATTR_MAX + 2];
+    char buf[CBOR_ATTR_MAX + 16];
+    int len;
+    int rc;
+    int i;
+
+    const struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "Key",
+            .type = CborAttrIntegerType,
+            .addr.integer = &int_val,
+        },
+        [1] = {
+            .attribute = NULL
+        }
+    };
+
+    rc = cbor_attr_index_init(&ci, entries, 2, attrs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    memset(key, 'k', sizeof(key) - 1);
+    key[sizeof(key) - 1] = '\0';
+
+    cbor_buf_writer_init(&writer, (uint8_t *)buf, sizeof(buf));
+    cbor_encoder_init(&enc, &writer.enc, 0);
+    rc = cbor_encoder_create_map(&enc, &map, 1);
+    rc |= cbor_encode_text_stringz(&map, key);
+    rc |= cbor_encode_int(&map, 1);
+    rc |= cbor_encoder_close_container(&enc, &map);
+    TEST_ASSERT_FATAL(rc == 0);
+    len = cbor_buf_writer_buffer_size(&writer, (uint8_t *)buf);
+
+    for (i = 0; i < 2; i++) {
+        rc = test_cborattr_read(buf, len, attrs, i ? &ci : NULL);
+        TEST_ASSERT(rc == CborErrorDataTooLarge, "rc %d", rc);
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_cborattr.h"
+
+/* {"Key": 1} */
+static const char test_cborattr_short[] = "\xa1" "\x63" "Key" "\x01";
+
+/* {"KeyIntX": 2} */
+static const char test_cborattr_long[] = "\xa1" "\x67" "KeyIntX" "\x02";
+
+/* Keys which are a prefix of an attribute name, or extend one, don't match. */
+TEST_CASE(test_cborattr_prefix)
+{
+    struct cbor_attr_index_entry entries[2];
+    struct cbor_attr_index ci;
+    long long int int_val;
+    int rc;
+    int i;
+
+    const struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "KeyInt",
+            .type = CborAttrIntegerType,
+            .addr.integer = &int_val,
+            .nodefault = true
+        },
+        [1] = {
+            .attribute = NULL
+        }
+    };
+
+    rc = cbor_attr_index_init(&ci, entries, 2, attrs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < 2; i++) {
+        int_val = -1;
+        rc = test_cborattr_read(test_cborattr_short,
+                                sizeof(test_cborattr_short) - 1, attrs,
+                                i ? &ci : NULL);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(int_val == -1);
+
+        rc = test_cborattr_read(test_cborattr_long,
+                                sizeof(test_cborattr_long) - 1, attrs,
+                                i ? &ci : NULL);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(int_val == -1);
+    }
+}
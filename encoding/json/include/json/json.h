@@ -25,6 +25,7 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <sys/types.h>
+#include "syscfg/syscfg.h"
 
 
 #ifdef __cplusplus
@@ -87,7 +88,11 @@ struct json_encoder {
     json_write_func_t je_write;
     void *je_arg;
     int je_wr_commas:1;
-    char je_encode_buf[64];
+    /* Objects and arrays currently open. */
+    uint8_t je_depth;
+    /* Bytes in je_encode_buf not yet passed to je_write. */
+    uint16_t je_buf_off;
+    char je_encode_buf[MYNEWT_VAL(JSON_ENCODE_BUF_SIZE)];
 };
 
 
@@ -103,6 +108,12 @@ int json_encode_array_name(struct json_encoder *encoder, char *name);
 int json_encode_array_start(struct json_encoder *encoder);
 int json_encode_array_value(struct json_encoder *encoder, struct json_value *val);
 int json_encode_array_finish(struct json_encoder *encoder);
+int json_encode_flush(struct json_encoder *encoder);
+
+int json_mbuf_write(void *buf, char *data, int len);
+#if MYNEWT_VAL(JSON_ENCODE_CONSOLE)
+int json_console_write(void *buf, char *data, int len);
+#endif
 
 /* Json parser definitions */
 typedef enum {
@@ -200,8 +211,29 @@ struct json_buffer {
 #define JSON_ATTR_MAX        31        /* max chars in JSON attribute name */
 #define JSON_VAL_MAX        512        /* max chars in JSON value part */
 
+/*
+ * Lookup index over an attribute table; see json_attr_index_init().
+ * Entries are sorted by name length and hash.
+ */
+struct json_attr_index_entry {
+    uint32_t jie_hash;
+    uint8_t jie_len;
+    uint8_t jie_idx;
+};
+
+struct json_attr_index {
+    const struct json_attr_index_entry *ji_entries;
+    int ji_cnt;
+};
+
 int json_read_object(struct json_buffer *, const struct json_attr_t *);
 int json_read_array(struct json_buffer *, const struct json_array_t *);
+int json_attr_index_init(struct json_attr_index *ji,
+                         struct json_attr_index_entry *entries,
+                         int max_entries, const struct json_attr_t *attrs);
+int json_read_object_indexed(struct json_buffer *,
+                             const struct json_attr_t *,
+                             const struct json_attr_index *);
 
 #define JSON_ERR_OBSTART     1   /* non-WS when expecting object start */
 #define JSON_ERR_ATTRSTART   2   /* non-WS when expecting attrib start */
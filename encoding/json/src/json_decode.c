@@ -144,9 +144,121 @@ json_target_address(const struct json_attr_t *cursor,
     return targetaddr;
 }
 
+/* FNV-1a, over the attribute name. */
+#define JSON_ATTR_HASH_INIT     2166136261u
+
+static uint32_t
+json_attr_hash(uint32_t hash, char c)
+{
+    return (hash ^ (unsigned char)c) * 16777619u;
+}
+
+static int
+json_attr_index_cmp(const struct json_attr_index_entry *a,
+                    const struct json_attr_index_entry *b)
+{
+    if (a->jie_len != b->jie_len) {
+        return a->jie_len < b->jie_len ? -1 : 1;
+    }
+    if (a->jie_hash != b->jie_hash) {
+        return a->jie_hash < b->jie_hash ? -1 : 1;
+    }
+    return (int)a->jie_idx - (int)b->jie_idx;
+}
+
+/**
+ * Builds a lookup index for an attribute table.  The index only depends on
+ * the attribute names, so it can be built once and used with any table
+ * listing the same attributes in the same order, e.g. one on the stack
+ * pointing at local variables.
+ *
+ * @param ji                    The index to fill in.
+ * @param entries               Storage for the index; one entry per
+ *                                  attribute.
+ * @param max_entries           Number of elements in entries.
+ * @param attrs                 The attribute table.
+ *
+ * @return                      0 on success; JSON_ERR_SUBTOOLONG if the
+ *                                  table has too many attributes.
+ */
+int
+json_attr_index_init(struct json_attr_index *ji,
+                     struct json_attr_index_entry *entries, int max_entries,
+                     const struct json_attr_t *attrs)
+{
+    struct json_attr_index_entry ent;
+    const char *c;
+    int cnt;
+    int i;
+
+    for (cnt = 0; attrs[cnt].attribute != NULL; cnt++) {
+        if (cnt >= max_entries || cnt > UINT8_MAX ||
+            strlen(attrs[cnt].attribute) > JSON_ATTR_MAX) {
+            return JSON_ERR_SUBTOOLONG;
+        }
+        ent.jie_hash = JSON_ATTR_HASH_INIT;
+        for (c = attrs[cnt].attribute; *c != '\0'; c++) {
+            ent.jie_hash = json_attr_hash(ent.jie_hash, *c);
+        }
+        ent.jie_len = c - attrs[cnt].attribute;
+        ent.jie_idx = cnt;
+
+        /* Insertion sort; tables are small. */
+        for (i = cnt; i > 0 && json_attr_index_cmp(&entries[i - 1], &ent) > 0;
+             i--) {
+            entries[i] = entries[i - 1];
+        }
+        entries[i] = ent;
+    }
+
+    ji->ji_entries = entries;
+    ji->ji_cnt = cnt;
+    return 0;
+}
+
+/*
+ * Returns the first attribute in the table called name, or NULL.  Same
+ * result as a linear scan, as entries with the same name are ordered by
+ * their position in the table.
+ */
+static const struct json_attr_t *
+json_attr_index_find(const struct json_attr_index *ji,
+                     const struct json_attr_t *attrs, const char *name,
+                     int len, uint32_t hash)
+{
+    const struct json_attr_index_entry *ent;
+    int lo;
+    int hi;
+    int mid;
+
+    lo = 0;
+    hi = ji->ji_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        ent = &ji->ji_entries[mid];
+        if (ent->jie_len < len ||
+            (ent->jie_len == len && ent->jie_hash < hash)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < ji->ji_cnt; lo++) {
+        ent = &ji->ji_entries[lo];
+        if (ent->jie_len != len || ent->jie_hash != hash) {
+            break;
+        }
+        if (strcmp(attrs[ent->jie_idx].attribute, name) == 0) {
+            return &attrs[ent->jie_idx];
+        }
+    }
+    return NULL;
+}
+
 static int
 json_internal_read_object(struct json_buffer *jb,
                           const struct json_attr_t *attrs,
+                          const struct json_attr_index *ji,
                           const struct json_array_t *parent,
                           int offset)
 {
@@ -156,6 +268,7 @@ json_internal_read_object(struct json_buffer *jb,
         in_escape, in_val_token, post_val, post_array
     } state = 0;
     char attrbuf[JSON_ATTR_MAX + 1], *pattr = NULL;
+    uint32_t attrhash = 0;
     char valbuf[JSON_VAL_MAX + 1], *pval = NULL;
     bool value_quoted = false;
     char uescape[5];    /* enough space for 4 hex digits and '\0' */
@@ -230,6 +343,7 @@ json_internal_read_object(struct json_buffer *jb,
             } else if (c == '"') {
                 state = in_attr;
                 pattr = attrbuf;
+                attrhash = JSON_ATTR_HASH_INIT;
             } else if (c == '}') {
                 break;
             } else {
@@ -243,12 +357,19 @@ json_internal_read_object(struct json_buffer *jb,
             }
             if (c == '"') {
                 *pattr++ = '\0';
-                for (cursor = attrs; cursor->attribute != NULL; cursor++) {
-                    if (strcmp(cursor->attribute, attrbuf) == 0) {
-                        break;
+                if (ji != NULL) {
+                    cursor = json_attr_index_find(ji, attrs, attrbuf,
+                                                  pattr - attrbuf - 1,
+                                                  attrhash);
+                } else {
+                    for (cursor = attrs; cursor->attribute != NULL;
+                         cursor++) {
+                        if (strcmp(cursor->attribute, attrbuf) == 0) {
+                            break;
+                        }
                     }
                 }
-                if (cursor->attribute == NULL) {
+                if (cursor == NULL || cursor->attribute == NULL) {
                     /* don't update end here, leave at attribute start */
                     return JSON_ERR_BADATTR;
                 }
@@ -270,6 +391,7 @@ json_internal_read_object(struct json_buffer *jb,
                 return JSON_ERR_ATTRLEN;
             } else {
                 *pattr++ = c;
+                attrhash = json_attr_hash(attrhash, c);
             }
             break;
         case await_value:
@@ -564,7 +686,7 @@ json_read_array(struct json_buffer *jb, const struct json_array_t *arr)
         case t_object:
         case t_structobject:
             substatus =
-                json_internal_read_object(jb, arr->arr.objects.subtype, arr,
+                json_internal_read_object(jb, arr->arr.objects.subtype, NULL, arr,
                                           offset);
             if (substatus != 0) {
                 return substatus;
@@ -664,7 +786,20 @@ json_read_object(struct json_buffer *jb, const struct json_attr_t *attrs)
 {
     int st;
 
-    st = json_internal_read_object(jb, attrs, NULL, 0);
+    st = json_internal_read_object(jb, attrs, NULL, NULL, 0);
     return st;
 }
 
+/**
+ * Same as json_read_object(), but looks attributes up in an index built
+ * with json_attr_index_init(), rather than scanning the table for each
+ * key.  Worth it for tables with many attributes.
+ */
+int
+json_read_object_indexed(struct json_buffer *jb,
+                         const struct json_attr_t *attrs,
+                         const struct json_attr_index *ji)
+{
+    return json_internal_read_object(jb, attrs, ji, NULL, 0);
+}
+
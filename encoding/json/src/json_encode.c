@@ -17,32 +17,222 @@
  * under the License.
  */
 
-#include <stdio.h>
 #include <string.h>
 
+#include "os/os_mbuf.h"
 #include <json/json.h>
 
-#define JSON_ENCODE_OBJECT_START(__e) \
-    (__e)->je_write((__e)->je_arg, "{", sizeof("{")-1);
+/*
+ * Output is gathered in je_encode_buf and handed to je_write when the
+ * buffer fills up, or when the outermost object or array is finished.
+ */
+
+static const char json_digit_pairs[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * Passes buffered output to the encoder's write function.  Call this before
+ * writing to the underlying stream directly, and after encoding anything
+ * other than a complete object or array.
+ *
+ * @param encoder               The encoder to flush.
+ *
+ * @return                      0 if nothing was buffered; otherwise what
+ *                                  the write function returned.
+ */
+int
+json_encode_flush(struct json_encoder *encoder)
+{
+    int off;
 
-#define JSON_ENCODE_OBJECT_END(__e) \
-    (__e)->je_write((__e)->je_arg, "}", sizeof("}")-1);
+    off = encoder->je_buf_off;
+    if (off == 0) {
+        return (0);
+    }
+    encoder->je_buf_off = 0;
 
-#define JSON_ENCODE_ARRAY_START(__e) \
-    (__e)->je_write((__e)->je_arg, "[", sizeof("[")-1);
+    return encoder->je_write(encoder->je_arg, encoder->je_encode_buf, off);
+}
 
-#define JSON_ENCODE_ARRAY_END(__e) \
-    (__e)->je_write((__e)->je_arg, "]", sizeof("]")-1);
+static void
+json_encode_write(struct json_encoder *encoder, const char *data, int len)
+{
+    int chunk;
+
+    while (len > 0) {
+        chunk = sizeof(encoder->je_encode_buf) - encoder->je_buf_off;
+        if (encoder->je_buf_off == 0 && len >= chunk) {
+            /* Too big to buffer; pass it straight through. */
+            encoder->je_write(encoder->je_arg, (char *) data, len);
+            return;
+        }
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(encoder->je_encode_buf + encoder->je_buf_off, data, chunk);
+        encoder->je_buf_off += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (encoder->je_buf_off == sizeof(encoder->je_encode_buf)) {
+            json_encode_flush(encoder);
+        }
+    }
+}
 
+static void
+json_encode_char(struct json_encoder *encoder, char c)
+{
+    encoder->je_encode_buf[encoder->je_buf_off++] = c;
+    if (encoder->je_buf_off == sizeof(encoder->je_encode_buf)) {
+        json_encode_flush(encoder);
+    }
+}
 
-int
-json_encode_object_start(struct json_encoder *encoder)
+static void
+json_encode_comma(struct json_encoder *encoder)
 {
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+        json_encode_char(encoder, ',');
         encoder->je_wr_commas = 0;
     }
-    JSON_ENCODE_OBJECT_START(encoder);
+}
+
+static void
+json_encode_nest(struct json_encoder *encoder, char c)
+{
+    json_encode_char(encoder, c);
+    encoder->je_depth++;
+}
+
+static void
+json_encode_unnest(struct json_encoder *encoder, char c)
+{
+    json_encode_char(encoder, c);
+    if (encoder->je_depth > 0) {
+        encoder->je_depth--;
+    }
+    if (encoder->je_depth == 0) {
+        json_encode_flush(encoder);
+    }
+}
+
+/*
+ * Formats val in decimal, ending just before end.  Returns the first
+ * character.
+ */
+static char *
+json_encode_u32(char *end, uint32_t val)
+{
+    const char *pair;
+
+    while (val >= 100) {
+        pair = &json_digit_pairs[(val % 100) * 2];
+        val /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+    if (val >= 10) {
+        pair = &json_digit_pairs[val * 2];
+        *--end = pair[1];
+        *--end = pair[0];
+    } else {
+        *--end = '0' + val;
+    }
+    return end;
+}
+
+static void
+json_encode_u64(struct json_encoder *encoder, uint64_t val, int neg)
+{
+    char buf[21];
+    char *start;
+    char *p;
+
+    /*
+     * 64-bit division is a library call on most of our targets; split off
+     * 9 digits at a time so that the rest is done with 32-bit arithmetic.
+     */
+    p = buf + sizeof(buf);
+    while (val > UINT32_MAX) {
+        start = json_encode_u32(p, val % 1000000000);
+        val /= 1000000000;
+        while (start > p - 9) {
+            *--start = '0';
+        }
+        p = start;
+    }
+    p = json_encode_u32(p, val);
+    if (neg) {
+        *--p = '-';
+    }
+
+    json_encode_write(encoder, p, buf + sizeof(buf) - p);
+}
+
+static const char *
+json_encode_escape(char c)
+{
+    switch (c) {
+    case '"':
+        return "\\\"";
+    case '/':
+        return "\\/";
+    case '\\':
+        return "\\\\";
+    case '\t':
+        return "\\t";
+    case '\r':
+        return "\\r";
+    case '\n':
+        return "\\n";
+    case '\f':
+        return "\\f";
+    case '\b':
+        return "\\b";
+    default:
+        return NULL;
+    }
+}
+
+static void
+json_encode_str(struct json_encoder *encoder, const char *str, int len)
+{
+    const char *esc;
+    int start;
+    int i;
+
+    json_encode_char(encoder, '"');
+
+    /* Write runs of characters which need no escaping in one go. */
+    start = 0;
+    for (i = 0; i < len; i++) {
+        esc = json_encode_escape(str[i]);
+        if (esc != NULL) {
+            json_encode_write(encoder, str + start, i - start);
+            json_encode_write(encoder, esc, 2);
+            start = i + 1;
+        }
+    }
+    json_encode_write(encoder, str + start, len - start);
+
+    json_encode_char(encoder, '"');
+}
+
+int
+json_encode_object_start(struct json_encoder *encoder)
+{
+    json_encode_comma(encoder);
+    json_encode_nest(encoder, '{');
     encoder->je_wr_commas = 0;
 
     return (0);
@@ -53,81 +243,43 @@ json_encode_value(struct json_encoder *encoder, struct json_value *jv)
 {
     int rc;
     int i;
-    int len;
 
     switch (jv->jv_type) {
         case JSON_VALUE_TYPE_BOOL:
-            len = sprintf(encoder->je_encode_buf, "%s",
-                    jv->jv_val.u > 0 ? "true" : "false");
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            if (jv->jv_val.u > 0) {
+                json_encode_write(encoder, "true", sizeof("true")-1);
+            } else {
+                json_encode_write(encoder, "false", sizeof("false")-1);
+            }
             break;
         case JSON_VALUE_TYPE_UINT64:
-            len = sprintf(encoder->je_encode_buf, "%llu",
-                    jv->jv_val.u);
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            json_encode_u64(encoder, jv->jv_val.u, 0);
             break;
         case JSON_VALUE_TYPE_INT64:
-            len = sprintf(encoder->je_encode_buf, "%lld",
-                    jv->jv_val.u);
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            if ((int64_t) jv->jv_val.u < 0) {
+                json_encode_u64(encoder, 0 - jv->jv_val.u, 1);
+            } else {
+                json_encode_u64(encoder, jv->jv_val.u, 0);
+            }
             break;
         case JSON_VALUE_TYPE_STRING:
-            encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-            for (i = 0; i < jv->jv_len; i++) {
-                switch (jv->jv_val.str[i]) {
-                    case '"':
-                    case '/':
-                    case '\\':
-                        encoder->je_write(encoder->je_arg, "\\",
-                                sizeof("\\")-1);
-                        encoder->je_write(encoder->je_arg,
-                                (char *) &jv->jv_val.str[i], 1);
-
-                        break;
-                    case '\t':
-                        encoder->je_write(encoder->je_arg, "\\t",
-                                sizeof("\\t")-1);
-                        break;
-                    case '\r':
-                        encoder->je_write(encoder->je_arg, "\\r",
-                                sizeof("\\r")-1);
-                        break;
-                    case '\n':
-                        encoder->je_write(encoder->je_arg, "\\n",
-                                sizeof("\\n")-1);
-                        break;
-                    case '\f':
-                        encoder->je_write(encoder->je_arg, "\\f",
-                                sizeof("\\f")-1);
-                        break;
-                    case '\b':
-                        encoder->je_write(encoder->je_arg, "\\b",
-                                sizeof("\\b")-1);
-                        break;
-                   default:
-                        encoder->je_write(encoder->je_arg,
-                                (char *) &jv->jv_val.str[i], 1);
-                        break;
-                }
-
-            }
-            encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
+            json_encode_str(encoder, jv->jv_val.str, jv->jv_len);
             break;
         case JSON_VALUE_TYPE_ARRAY:
-            JSON_ENCODE_ARRAY_START(encoder);
+            json_encode_char(encoder, '[');
             for (i = 0; i < jv->jv_len; i++) {
                 rc = json_encode_value(encoder, jv->jv_val.composite.values[i]);
                 if (rc != 0) {
                     goto err;
                 }
                 if (i != jv->jv_len - 1) {
-                    encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+                    json_encode_char(encoder, ',');
                 }
             }
-            JSON_ENCODE_ARRAY_END(encoder);
+            json_encode_char(encoder, ']');
             break;
         case JSON_VALUE_TYPE_OBJECT:
-            JSON_ENCODE_OBJECT_START(encoder);
+            json_encode_char(encoder, '{');
             for (i = 0; i < jv->jv_len; i++) {
                 rc = json_encode_object_entry(encoder,
                         jv->jv_val.composite.keys[i],
@@ -136,7 +288,7 @@ json_encode_value(struct json_encoder *encoder, struct json_value *jv)
                     goto err;
                 }
             }
-            JSON_ENCODE_OBJECT_END(encoder);
+            json_encode_char(encoder, '}');
             break;
         default:
             rc = -1;
@@ -152,15 +304,12 @@ err:
 int
 json_encode_object_key(struct json_encoder *encoder, char *key)
 {
-    if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
-        encoder->je_wr_commas = 0;
-    }
+    json_encode_comma(encoder);
 
     /* Write the key entry */
-    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
-    encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    json_encode_char(encoder, '"');
+    json_encode_write(encoder, key, strlen(key));
+    json_encode_write(encoder, "\": ", sizeof("\": ")-1);
 
     return (0);
 }
@@ -171,14 +320,7 @@ json_encode_object_entry(struct json_encoder *encoder, char *key,
 {
     int rc;
 
-    if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
-        encoder->je_wr_commas = 0;
-    }
-    /* Write the key entry */
-    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
-    encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    json_encode_object_key(encoder, key);
 
     rc = json_encode_value(encoder, val);
     if (rc != 0) {
@@ -194,10 +336,11 @@ err:
 int
 json_encode_object_finish(struct json_encoder *encoder)
 {
-    JSON_ENCODE_OBJECT_END(encoder);
     /* Useful in case of nested objects. */
     encoder->je_wr_commas = 1;
 
+    json_encode_unnest(encoder, '}');
+
     return (0);
 }
 
@@ -210,7 +353,7 @@ json_encode_array_name(struct json_encoder *encoder, char *name)
 int
 json_encode_array_start(struct json_encoder *encoder)
 {
-    JSON_ENCODE_ARRAY_START(encoder);
+    json_encode_nest(encoder, '[');
     encoder->je_wr_commas = 0;
 
     return (0);
@@ -221,10 +364,7 @@ json_encode_array_value(struct json_encoder *encoder, struct json_value *jv)
 {
     int rc;
 
-    if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
-        encoder->je_wr_commas = 0;
-    }
+    json_encode_comma(encoder);
 
     rc = json_encode_value(encoder, jv);
     if (rc != 0) {
@@ -242,7 +382,18 @@ int
 json_encode_array_finish(struct json_encoder *encoder)
 {
     encoder->je_wr_commas = 1;
-    JSON_ENCODE_ARRAY_END(encoder);
+
+    json_encode_unnest(encoder, ']');
 
     return (0);
 }
+
+/**
+ * Write function which appends encoder output to an mbuf chain.  Set
+ * je_arg to the chain.
+ */
+int
+json_mbuf_write(void *buf, char *data, int len)
+{
+    return os_mbuf_append(buf, data, len);
+}
@@ -23,10 +23,14 @@
 
 TEST_CASE_DECL(test_json_simple_encode);
 TEST_CASE_DECL(test_json_simple_decode);
+TEST_CASE_DECL(test_json_indexed_decode);
+TEST_CASE_DECL(test_json_buffered_encode);
 
 TEST_SUITE(test_json_suite) {
     test_json_simple_encode();
     test_json_simple_decode();
+    test_json_indexed_decode();
+    test_json_buffered_encode();
 }
 
 #if MYNEWT_VAL(SELFTEST)
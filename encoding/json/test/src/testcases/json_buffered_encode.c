@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os/os.h"
+#include "test_json.h"
+
+#define JSON_TEST_MBUF_CNT      16
+#define JSON_TEST_MBUF_SIZE     32
+
+static os_membuf_t json_test_mbuf_mem[
+    OS_MEMPOOL_SIZE(JSON_TEST_MBUF_CNT,
+                    JSON_TEST_MBUF_SIZE + sizeof(struct os_mbuf))
+];
+
+static int json_test_write_cnt;
+
+static int
+json_test_count_write(void *buf, char *data, int len)
+{
+    json_test_write_cnt++;
+    return test_write(buf, data, len);
+}
+
+TEST_CASE(test_json_buffered_encode)
+{
+    struct os_mbuf_pool mbuf_pool;
+    struct os_mempool mempool;
+    struct json_encoder encoder;
+    struct json_value value;
+    struct os_mbuf *om;
+    char longstr[150];
+    char *expected;
+    int rc;
+    int i;
+
+    /* Numbers at their limits, escapes and a string longer than the
+     * encoder's buffer.
+     */
+    for (i = 0; i < sizeof(longstr); i++) {
+        longstr[i] = 'a' + i % 26;
+    }
+
+    buf_index = 0;
+    json_test_write_cnt = 0;
+    memset(&encoder, 0, sizeof(encoder));
+    encoder.je_write = json_test_count_write;
+
+    rc = json_encode_object_start(&encoder);
+    TEST_ASSERT(rc == 0);
+
+    JSON_VALUE_UINT(&value, UINT64_MAX);
+    rc = json_encode_object_entry(&encoder, "u", &value);
+    TEST_ASSERT(rc == 0);
+
+    JSON_VALUE_INT(&value, INT64_MIN);
+    rc = json_encode_object_entry(&encoder, "i", &value);
+    TEST_ASSERT(rc == 0);
+
+    JSON_VALUE_UINT(&value, 4000000000ULL);
+    rc = json_encode_object_entry(&encoder, "u32", &value);
+    TEST_ASSERT(rc == 0);
+
+    JSON_VALUE_UINT(&value, 10000000000000000000ULL);
+    rc = json_encode_object_entry(&encoder, "z", &value);
+    TEST_ASSERT(rc == 0);
+
+    JSON_VALUE_INT(&value, 0);
+    rc = json_encode_object_entry(&encoder, "0", &value);
+    TEST_ASSERT(rc == 0);
+
+    JSON_VALUE_BOOL(&value, 0);
+    rc = json_encode_object_entry(&encoder, "b", &value);
+    TEST_ASSERT(rc == 0);
+
+    JSON_VALUE_STRING(&value, "a\"b/c\\d\te\rf\ng\fh\bi");
+    rc = json_encode_object_entry(&encoder, "esc", &value);
+    TEST_ASSERT(rc == 0);
+
+    /* Until the outermost object is finished, only full buffers are
+     * written.
+     */
+    TEST_ASSERT(buf_index ==
+                json_test_write_cnt * sizeof(encoder.je_encode_buf));
+
+    JSON_VALUE_STRINGN(&value, longstr, sizeof(longstr));
+    rc = json_encode_object_entry(&encoder, "long", &value);
+    TEST_ASSERT(rc == 0);
+
+    rc = json_encode_object_finish(&encoder);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(encoder.je_buf_off == 0);
+
+    expected = "{\"u\": 18446744073709551615,\"i\": -9223372036854775808,"
+               "\"u32\": 4000000000,\"z\": 10000000000000000000,"
+               "\"0\": 0,\"b\": false,"
+               "\"esc\": \"a\\\"b\\/c\\\\d\\te\\rf\\ng\\fh\\bi\",\"long\": \"";
+    TEST_ASSERT(buf_index == strlen(expected) + sizeof(longstr) + 2);
+    TEST_ASSERT(memcmp(bigbuf, expected, strlen(expected)) == 0);
+    TEST_ASSERT(memcmp(bigbuf + strlen(expected), longstr,
+                       sizeof(longstr)) == 0);
+    TEST_ASSERT(memcmp(bigbuf + buf_index - 2, "\"}", 2) == 0);
+
+    /* Far fewer writes than tokens. */
+    TEST_ASSERT(json_test_write_cnt <= buf_index /
+                                       sizeof(encoder.je_encode_buf) + 3);
+
+    /* Into an mbuf chain.  Finishing the nested array doesn't flush. */
+    rc = os_mempool_init(&mempool, JSON_TEST_MBUF_CNT,
+                         JSON_TEST_MBUF_SIZE + sizeof(struct os_mbuf),
+                         json_test_mbuf_mem, "json_test");
+    TEST_ASSERT(rc == 0);
+    rc = os_mbuf_pool_init(&mbuf_pool, &mempool,
+                           JSON_TEST_MBUF_SIZE + sizeof(struct os_mbuf),
+                           JSON_TEST_MBUF_CNT);
+    TEST_ASSERT(rc == 0);
+
+    om = os_mbuf_get_pkthdr(&mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    memset(&encoder, 0, sizeof(encoder));
+    encoder.je_write = json_mbuf_write;
+    encoder.je_arg = om;
+
+    json_encode_object_start(&encoder);
+    json_encode_array_name(&encoder, "arr");
+    json_encode_array_start(&encoder);
+    for (i = 0; i < 3; i++) {
+        JSON_VALUE_INT(&value, i - 1);
+        json_encode_array_value(&encoder, &value);
+    }
+    json_encode_array_finish(&encoder);
+    TEST_ASSERT(encoder.je_buf_off != 0);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) + encoder.je_buf_off == 16);
+    json_encode_object_finish(&encoder);
+
+    expected = "{\"arr\": [-1,0,1]}";
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == strlen(expected));
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, expected, strlen(expected)) == 0);
+
+    /* A lone entry needs an explicit flush. */
+    JSON_VALUE_UINT(&value, 7);
+    json_encode_object_entry(&encoder, "x", &value);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) + encoder.je_buf_off ==
+                strlen(expected) + 7);
+    rc = json_encode_flush(&encoder);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(os_mbuf_cmpf(om, strlen(expected), ",\"x\": 7", 7) == 0);
+
+    os_mbuf_free_chain(om);
+}
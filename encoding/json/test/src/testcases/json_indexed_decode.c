@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_json.h"
+
+/* Decoding through an attribute index gives the same result as a scan. */
+TEST_CASE(test_json_indexed_decode)
+{
+    struct json_attr_index_entry entries[8];
+    struct json_attr_index ji;
+    struct test_jbuf tjb;
+    long long unsigned int uint_val;
+    long long int int_val;
+    long long int int_val2;
+    bool bool_val;
+    char str[16];
+    char str2[16];
+    int rc;
+
+    const struct json_attr_t attrs[] = {
+        [0] = {
+            .attribute = "KeyBool",
+            .type = t_boolean,
+            .addr.boolean = &bool_val,
+            .nodefault = true
+        },
+        [1] = {
+            .attribute = "KeyInt",
+            .type = t_integer,
+            .addr.integer = &int_val,
+            .nodefault = true
+        },
+        [2] = {
+            .attribute = "KeyUint",
+            .type = t_uinteger,
+            .addr.uinteger = &uint_val,
+            .nodefault = true
+        },
+        /* Same name, different type; the first one matching is used. */
+        [3] = {
+            .attribute = "KeyAny",
+            .type = t_string,
+            .addr.string = str,
+            .len = sizeof(str)
+        },
+        [4] = {
+            .attribute = "KeyAny",
+            .type = t_integer,
+            .addr.integer = &int_val2,
+        },
+        [5] = {
+            .attribute = "Key",
+            .type = t_string,
+            .addr.string = str2,
+            .len = sizeof(str2)
+        },
+        [6] = {
+            .attribute = NULL
+        }
+    };
+
+    rc = json_attr_index_init(&ji, entries, 3, attrs);
+    TEST_ASSERT(rc == JSON_ERR_SUBTOOLONG);
+
+    rc = json_attr_index_init(&ji, entries, 8, attrs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ji.ji_cnt == 6);
+
+    test_buf_init(&tjb, "{\"KeyUint\": 77, \"Key\": \"k\", \"KeyAny\": 5, "
+                  "\"KeyBool\": true, \"KeyInt\": -3}");
+    rc = json_read_object_indexed(&tjb.json_buf, attrs, &ji);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(uint_val == 77);
+    TEST_ASSERT(int_val == -3);
+    TEST_ASSERT(bool_val == true);
+    TEST_ASSERT(int_val2 == 5);
+    TEST_ASSERT(str[0] == '\0');
+    TEST_ASSERT(!strcmp(str2, "k"));
+
+    test_buf_init(&tjb, "{\"KeyAny\": \"any\"}");
+    rc = json_read_object_indexed(&tjb.json_buf, attrs, &ji);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(str, "any"));
+    TEST_ASSERT(int_val2 == 0);
+
+    /* Prefixes of known names are not matched. */
+    test_buf_init(&tjb, "{\"KeyB\": true}");
+    rc = json_read_object_indexed(&tjb.json_buf, attrs, &ji);
+    TEST_ASSERT(rc == JSON_ERR_BADATTR);
+}
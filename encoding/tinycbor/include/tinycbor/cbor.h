@@ -230,6 +230,9 @@ typedef uint32_t (cbor_reader_get32)(struct cbor_decoder_reader *d, int offset);
 typedef uint64_t (cbor_reader_get64)(struct cbor_decoder_reader *d, int offset);
 typedef uintptr_t (cbor_memcmp)(struct cbor_decoder_reader *d, char *buf, int offset, size_t len);
 typedef uintptr_t (cbor_memcpy)(struct cbor_decoder_reader *d, char *buf, int offset, size_t len);
+/* Returns a pointer to the data at offset; *len is set to the number of
+ * contiguous bytes there. */
+typedef const uint8_t *(cbor_memptr)(struct cbor_decoder_reader *d, int offset, size_t *len);
 
 struct cbor_decoder_reader {
     cbor_reader_get8  *get8;
@@ -238,6 +241,7 @@ struct cbor_decoder_reader {
     cbor_reader_get64 *get64;
     cbor_memcmp       *cmp;
     cbor_memcpy       *cpy;
+    cbor_memptr       *ptr;
     size_t             message_size;
 };
 
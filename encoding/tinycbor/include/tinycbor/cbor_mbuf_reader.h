@@ -31,6 +31,8 @@ struct CborMbufReader {
     struct cbor_decoder_reader r;
     int init_off;                     /* initial offset into the data */
     struct os_mbuf *m;
+    struct os_mbuf *cur;              /* mbuf of the last access */
+    int cur_off;                      /* offset of cur into the chain */
 };
 
 void
@@ -33,6 +33,9 @@ struct CborMbufWriter {
 void
 cbor_mbuf_writer_init(struct CborMbufWriter *cb, struct os_mbuf *m);
 
+int
+cbor_mbuf_writer(struct cbor_encoder_writer *arg, const char *data, int len);
+
 #ifdef __cplusplus
 }
 #endif
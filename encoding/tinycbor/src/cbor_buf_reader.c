@@ -58,6 +58,17 @@ cbor_buf_reader_cpy(struct cbor_decoder_reader *d, char *dst, int src_offset, si
     return (uintptr_t) memcpy(dst, cb->buffer + src_offset, len);
 }
 
+static const uint8_t *
+cbor_buf_reader_ptr(struct cbor_decoder_reader *d, int offset, size_t *len) {
+    struct cbor_buf_reader *cb = (struct cbor_buf_reader *) d;
+    if (offset < 0 || (size_t)offset >= cb->r.message_size) {
+        *len = 0;
+        return NULL;
+    }
+    *len = cb->r.message_size - offset;
+    return cb->buffer + offset;
+}
+
 void
 cbor_buf_reader_init(struct cbor_buf_reader *cb, const uint8_t *buffer, size_t data)
 {
@@ -68,5 +79,6 @@ cbor_buf_reader_init(struct cbor_buf_reader *cb, const uint8_t *buffer, size_t d
     cb->r.get64 = &cbuf_buf_reader_get64;
     cb->r.cmp = &cbor_buf_reader_cmp;
     cb->r.cpy = &cbor_buf_reader_cpy;
+    cb->r.ptr = &cbor_buf_reader_ptr;
     cb->r.message_size = data;
 }
\ No newline at end of file
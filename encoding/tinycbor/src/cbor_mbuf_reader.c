@@ -20,20 +20,76 @@
 #include <tinycbor/cbor_mbuf_reader.h>
 #include <tinycbor/compilersupport_p.h>
 #include <os/os_mbuf.h>
+#include <string.h>
+
+/*
+ * Finds the mbuf holding byte "offset" of the CBOR data.  The parser mostly
+ * moves forward, so the search starts from the mbuf found last time, rather
+ * than from the head of the chain.
+ */
+static struct os_mbuf *
+cbor_mbuf_reader_seek(struct CborMbufReader *cb, int offset, int *out_off)
+{
+    struct os_mbuf *m;
+    struct os_mbuf *next;
+
+    offset += cb->init_off;
+    if (offset < cb->cur_off) {
+        cb->cur = cb->m;
+        cb->cur_off = 0;
+    }
+
+    m = cb->cur;
+    while (offset - cb->cur_off >= m->om_len) {
+        next = SLIST_NEXT(m, om_next);
+        if (!next) {
+            break;
+        }
+        cb->cur_off += m->om_len;
+        m = next;
+    }
+    cb->cur = m;
+
+    *out_off = offset - cb->cur_off;
+    return m;
+}
+
+static int
+cbor_mbuf_reader_read(struct CborMbufReader *cb, int offset, void *dst,
+                      int len)
+{
+    struct os_mbuf *m;
+    int off;
+
+    m = cbor_mbuf_reader_seek(cb, offset, &off);
+    if (off + len <= m->om_len) {
+        memcpy(dst, m->om_data + off, len);
+        return 0;
+    }
+
+    /* Spans mbufs. */
+    return os_mbuf_copydata(m, off, len, dst);
+}
 
 static uint8_t
 cbuf_mbuf_reader_get8(struct cbor_decoder_reader *d, int offset) {
-    uint8_t val;
     struct CborMbufReader *cb = (struct CborMbufReader *) d;
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
-    return val;
+    struct os_mbuf *m;
+    int off;
+
+    m = cbor_mbuf_reader_seek(cb, offset, &off);
+    if (off >= m->om_len) {
+        /* Past the end of the data. */
+        return 0;
+    }
+    return m->om_data[off];
 }
 
 static uint16_t
 cbuf_mbuf_reader_get16(struct cbor_decoder_reader *d, int offset) {
     uint16_t val;
     struct CborMbufReader *cb = (struct CborMbufReader *) d;
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_read(cb, offset, &val, sizeof(val));
     return cbor_ntohs(val);
 }
 
@@ -41,7 +97,7 @@ static uint32_t
 cbuf_mbuf_reader_get32(struct cbor_decoder_reader *d, int offset) {
     uint32_t val;
     struct CborMbufReader *cb = (struct CborMbufReader *) d;
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_read(cb, offset, &val, sizeof(val));
     return cbor_ntohl(val);
 }
 
@@ -49,21 +105,28 @@ static uint64_t
 cbuf_mbuf_reader_get64(struct cbor_decoder_reader *d, int offset) {
     uint64_t val;
     struct CborMbufReader *cb = (struct CborMbufReader *) d;
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_read(cb, offset, &val, sizeof(val));
     return cbor_ntohll(val);
 }
 
 static uintptr_t
 cbor_mbuf_reader_cmp(struct cbor_decoder_reader *d, char *buf, int offset, size_t len) {
     struct CborMbufReader *cb = (struct CborMbufReader *) d;
-    return os_mbuf_cmpf(cb->m, offset + cb->init_off, buf, len);
+    struct os_mbuf *m;
+    int off;
+
+    m = cbor_mbuf_reader_seek(cb, offset, &off);
+    if (off + len <= m->om_len) {
+        return memcmp(m->om_data + off, buf, len);
+    }
+    return os_mbuf_cmpf(m, off, buf, len);
 }
 
 static uintptr_t
 cbor_mbuf_reader_cpy(struct cbor_decoder_reader *d, char *dst, int offset, size_t len) {
     int rc;
     struct CborMbufReader *cb = (struct CborMbufReader *) d;
-    rc = os_mbuf_copydata(cb->m, offset + cb->init_off, len, dst);
+    rc = cbor_mbuf_reader_read(cb, offset, dst, len);
 
     if(rc == 0) {
         return true;
@@ -71,6 +134,21 @@ cbor_mbuf_reader_cpy(struct cbor_decoder_reader *d, char *dst, int offset, size_
     return false;
 }
 
+static const uint8_t *
+cbor_mbuf_reader_ptr(struct cbor_decoder_reader *d, int offset, size_t *len) {
+    struct CborMbufReader *cb = (struct CborMbufReader *) d;
+    struct os_mbuf *m;
+    int off;
+
+    m = cbor_mbuf_reader_seek(cb, offset, &off);
+    if (off >= m->om_len) {
+        *len = 0;
+        return NULL;
+    }
+    *len = m->om_len - off;
+    return m->om_data + off;
+}
+
 void
 cbor_mbuf_reader_init(struct CborMbufReader *cb, struct os_mbuf *m,
                         int initial_offset)
@@ -82,10 +160,13 @@ cbor_mbuf_reader_init(struct CborMbufReader *cb, struct os_mbuf *m,
     cb->r.get64 = &cbuf_mbuf_reader_get64;
     cb->r.cmp = &cbor_mbuf_reader_cmp;
     cb->r.cpy = &cbor_mbuf_reader_cpy;
+    cb->r.ptr = &cbor_mbuf_reader_ptr;
 
     assert (OS_MBUF_IS_PKTHDR(m));
     hdr = OS_MBUF_PKTHDR(m);
     cb->m = m;
     cb->init_off = initial_offset;
+    cb->cur = m;
+    cb->cur_off = 0;
     cb->r.message_size = hdr->omp_len - initial_offset;
 }
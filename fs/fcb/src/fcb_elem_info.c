@@ -30,6 +30,7 @@ int
 fcb_elem_crc8(struct fcb *fcb, struct fcb_entry *loc, uint8_t *c8p)
 {
     uint8_t tmp_str[FCB_TMP_BUF_SZ];
+    const void *ptr;
     int cnt;
     int blk_sz;
     uint8_t crc8;
@@ -58,6 +59,11 @@ fcb_elem_crc8(struct fcb *fcb, struct fcb_entry *loc, uint8_t *c8p)
 
     off = loc->fe_data_off;
     end = loc->fe_data_off + len;
+    ptr = flash_area_get_ptr(loc->fe_area, off, len);
+    if (ptr) {
+        crc8 = crc8_calc(crc8, ptr, len);
+        off = end;
+    }
     for (; off < end; off += blk_sz) {
         blk_sz = end - off;
         if (blk_sz > sizeof(tmp_str)) {
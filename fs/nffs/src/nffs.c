@@ -106,6 +106,9 @@ static const struct fs_ops nffs_ops = {
 };
 
 STATS_SECT_DECL(nffs_stats) nffs_stats;
+#if MYNEWT_VAL(NFFS_WRITE_TIME_STATS)
+STATS_SECT_DECL(nffs_write_time) nffs_write_time;
+#endif
 STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_hashcnt_ins)
     STATS_NAME(nffs_stats, nffs_hashcnt_rm)
@@ -155,6 +158,16 @@ nffs_stats_init(void)
                     STATS_SIZE_INIT_PARMS(nffs_stats, STATS_SIZE_32),
                     STATS_NAME_INIT_PARMS(nffs_stats),
                     "nffs_stats");
+#if MYNEWT_VAL(NFFS_WRITE_TIME_STATS)
+    if (rc == 0) {
+        rc = stats_hist_init(STATS_HDR(nffs_write_time),
+                             STATS_HIST_CNT(nffs_write_time));
+        if (rc == 0) {
+            rc = stats_register("nffs_write_time",
+                                STATS_HDR(nffs_write_time));
+        }
+    }
+#endif
     if (rc) {
         if (rc < 0) {
             /* multiple initializations are okay */
@@ -64,6 +64,34 @@ nffs_flash_read(uint8_t area_idx, uint32_t area_offset, void *data,
     return 0;
 }
 
+/**
+ * Gets a pointer through which a chunk of flash can be read in place.
+ *
+ * @param area_idx              The index of the area to read from.
+ * @param area_offset           The offset within the area to read from.
+ * @param len                   The number of bytes to read.
+ *
+ * @return                      Pointer to the flash contents; NULL if the
+ *                                  flash is not memory-mapped or the range is
+ *                                  invalid.  Use nffs_flash_read() then.
+ */
+const void *
+nffs_flash_ptr(uint8_t area_idx, uint32_t area_offset, uint32_t len)
+{
+    const struct nffs_area *area;
+
+    assert(area_idx < nffs_num_areas);
+
+    area = nffs_areas + area_idx;
+
+    if (area_offset + len > area->na_length) {
+        return NULL;
+    }
+
+    return hal_flash_ptr(area->na_flash_id, area->na_offset + area_offset,
+                         len);
+}
+
 /**
  * Writes a chunk of data to flash.
  *
@@ -733,6 +733,42 @@ nffs_inode_read_filename_chunk(const struct nffs_inode *inode,
     return 0;
 }
 
+/**
+ * Gets part of an inode's filename for comparison.  If the flash is
+ * memory-mapped, the filename is compared in place, and all *len bytes are
+ * available.  Otherwise, up to NFFS_INODE_FILENAME_BUF_SZ bytes are read into
+ * buf, and *len is reduced accordingly.
+ */
+static int
+nffs_inode_filename_chunk(const struct nffs_inode *inode,
+                          uint8_t filename_offset, uint8_t *buf, int *len,
+                          const char **out_chunk)
+{
+    uint32_t area_offset;
+    uint8_t area_idx;
+    int rc;
+
+    nffs_flash_loc_expand(inode->ni_inode_entry->nie_hash_entry.nhe_flash_loc,
+                          &area_idx, &area_offset);
+    area_offset += sizeof (struct nffs_disk_inode) + filename_offset;
+
+    *out_chunk = nffs_flash_ptr(area_idx, area_offset, *len);
+    if (*out_chunk != NULL) {
+        return 0;
+    }
+
+    if (*len > NFFS_INODE_FILENAME_BUF_SZ) {
+        *len = NFFS_INODE_FILENAME_BUF_SZ;
+    }
+    rc = nffs_inode_read_filename_chunk(inode, filename_offset, buf, *len);
+    if (rc != 0) {
+        return rc;
+    }
+    *out_chunk = (char *)buf;
+
+    return 0;
+}
+
 /**
  * Retrieves the filename of the specified inode.  The retrieved
  * filename is always null-terminated.  To ensure enough space to hold the full
@@ -847,9 +883,9 @@ nffs_inode_filename_cmp_ram(const struct nffs_inode *inode,
                             const char *name, int name_len,
                             int *result)
 {
+    const char *chunk;
     int short_len;
     int chunk_len;
-    int rem_len;
     int off;
     int rc;
 
@@ -868,22 +904,14 @@ nffs_inode_filename_cmp_ram(const struct nffs_inode *inode,
 
     off = chunk_len;
     while (*result == 0 && off < short_len) {
-        rem_len = short_len - off;
-        if (rem_len > NFFS_INODE_FILENAME_BUF_SZ) {
-            chunk_len = NFFS_INODE_FILENAME_BUF_SZ;
-        } else {
-            chunk_len = rem_len;
-        }
-
-        rc = nffs_inode_read_filename_chunk(inode, off,
-                                            nffs_inode_filename_buf0,
-                                            chunk_len);
+        chunk_len = short_len - off;
+        rc = nffs_inode_filename_chunk(inode, off, nffs_inode_filename_buf0,
+                                       &chunk_len, &chunk);
         if (rc != 0) {
             return rc;
         }
 
-        *result = strncmp((char *)nffs_inode_filename_buf0, name + off,
-                          chunk_len);
+        *result = strncmp(chunk, name + off, chunk_len);
         off += chunk_len;
     }
 
@@ -902,9 +930,10 @@ nffs_inode_filename_cmp_flash(const struct nffs_inode *inode1,
                               const struct nffs_inode *inode2,
                               int *result)
 {
+    const char *chunk1;
+    const char *chunk2;
     int short_len;
     int chunk_len;
-    int rem_len;
     int off;
     int rc;
 
@@ -925,30 +954,21 @@ nffs_inode_filename_cmp_flash(const struct nffs_inode *inode1,
 
     off = chunk_len;
     while (*result == 0 && off < short_len) {
-        rem_len = short_len - off;
-        if (rem_len > NFFS_INODE_FILENAME_BUF_SZ) {
-            chunk_len = NFFS_INODE_FILENAME_BUF_SZ;
-        } else {
-            chunk_len = rem_len;
-        }
-
-        rc = nffs_inode_read_filename_chunk(inode1, off,
-                                            nffs_inode_filename_buf0,
-                                            chunk_len);
+        chunk_len = short_len - off;
+        rc = nffs_inode_filename_chunk(inode1, off, nffs_inode_filename_buf0,
+                                       &chunk_len, &chunk1);
         if (rc != 0) {
             return rc;
         }
 
-        rc = nffs_inode_read_filename_chunk(inode2, off,
-                                            nffs_inode_filename_buf1,
-                                            chunk_len);
+        /* May shorten chunk_len; chunk1 is still good for the rest. */
+        rc = nffs_inode_filename_chunk(inode2, off, nffs_inode_filename_buf1,
+                                       &chunk_len, &chunk2);
         if (rc != 0) {
             return rc;
         }
 
-        *result = strncmp((char *)nffs_inode_filename_buf0,
-                          (char *)nffs_inode_filename_buf1,
-                          chunk_len);
+        *result = strncmp(chunk1, chunk2, chunk_len);
         off += chunk_len;
     }
 
@@ -269,6 +269,12 @@ STATS_SECT_START(nffs_stats)
 STATS_SECT_END
 extern STATS_SECT_DECL(nffs_stats) nffs_stats;
 
+#if MYNEWT_VAL(NFFS_WRITE_TIME_STATS)
+/* Duration of nffs_write_to_file() calls, in cputime ticks. */
+STATS_HIST_SECT(nffs_write_time, 24)
+extern STATS_SECT_DECL(nffs_write_time) nffs_write_time;
+#endif
+
 extern void *nffs_file_mem;
 extern void *nffs_block_entry_mem;
 extern void *nffs_inode_mem;
@@ -394,6 +400,7 @@ int nffs_flash_read(uint8_t area_idx, uint32_t offset,
                     void *data, uint32_t len);
 int nffs_flash_write(uint8_t area_idx, uint32_t offset,
                      const void *data, uint32_t len);
+const void *nffs_flash_ptr(uint8_t area_idx, uint32_t offset, uint32_t len);
 int nffs_flash_copy(uint8_t area_id_from, uint32_t offset_from,
                     uint8_t area_id_to, uint32_t offset_to,
                     uint32_t len);
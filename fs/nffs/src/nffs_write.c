@@ -18,6 +18,11 @@
  */
 
 #include <assert.h>
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#if MYNEWT_VAL(NFFS_WRITE_TIME_STATS)
+#include "os/os_cputime.h"
+#endif
 #include "testutil/testutil.h"
 #include "nffs/nffs.h"
 #include "nffs_priv.h"
@@ -386,8 +391,15 @@ nffs_write_to_file(struct nffs_file *file, const void *data, int len)
     struct nffs_cache_inode *cache_inode;
     const uint8_t *data_ptr;
     uint16_t chunk_size;
+#if MYNEWT_VAL(NFFS_WRITE_TIME_STATS)
+    uint32_t start;
+#endif
     int rc;
 
+#if MYNEWT_VAL(NFFS_WRITE_TIME_STATS)
+    start = os_cputime_get32();
+#endif
+
     if (!(file->nf_access_flags & FS_ACCESS_WRITE)) {
         return FS_EACCESS;
     }
@@ -428,5 +440,9 @@ nffs_write_to_file(struct nffs_file *file, const void *data, int len)
         file->nf_offset += chunk_size;
     }
 
+#if MYNEWT_VAL(NFFS_WRITE_TIME_STATS)
+    STATS_HIST_ADD(nffs_write_time, os_cputime_get32() - start);
+#endif
+
     return 0;
 }
@@ -66,6 +66,33 @@ typedef void (*uart_tx_done)(void *arg);
  */
 typedef int (*uart_rx_char)(void *arg, uint8_t byte);
 
+/*
+ * Function prototype for UART driver to ask for a block of data to send,
+ * e.g. to hand to DMA.  The data stays in place until the driver reports
+ * that it has been sent with uart_tx_buf_done.  Drivers use this instead
+ * of uart_tx_char when both are given; uart_hal feeds the HAL a byte at a
+ * time from the block.
+ * Driver must call this with interrupts disabled.
+ *
+ * @param arg		This is uc_cb_arg passed in uart_conf in
+ *			os_dev_open().
+ * @param buf		Set to point to the data.
+ *
+ * @return		Number of bytes at *buf; 0 if no more data to send.
+ */
+typedef int (*uart_tx_buf)(void *arg, const uint8_t **buf);
+
+/*
+ * Function prototype for UART driver to report that data returned by
+ * uart_tx_buf has been sent, and that its space can be reused.
+ * Driver must call this with interrupts disabled.
+ *
+ * @param arg		This is uc_cb_arg passed in uart_conf in
+ *			os_dev_open().
+ * @param len		Number of bytes sent, from the start of the block.
+ */
+typedef void (*uart_tx_buf_done)(void *arg, int len);
+
 struct uart_driver_funcs {
     void (*uf_start_tx)(struct uart_dev *);
     void (*uf_start_rx)(struct uart_dev *);
@@ -101,6 +128,8 @@ struct uart_conf {
     uart_tx_char uc_tx_char;
     uart_rx_char uc_rx_char;
     uart_tx_done uc_tx_done;
+    uart_tx_buf uc_tx_buf;              /* optional */
+    uart_tx_buf_done uc_tx_buf_done;    /* optional */
     void *uc_cb_arg;
 };
 
@@ -29,10 +29,73 @@
 
 #include "uart_hal/uart_hal.h"
 
+/*
+ * When the user hands out data in blocks, at most this many bytes are
+ * held before the driver reports them sent.
+ */
+#define UART_HAL_TX_HOLD        16
+
 struct uart_hal_priv {
     int unit;
+
+    /* Block transmit state, used if uc_tx_buf is given. */
+    uart_tx_buf tx_buf;
+    uart_tx_buf_done tx_buf_done;
+    uart_tx_done tx_done;
+    uart_rx_char rx_char;
+    void *cb_arg;
+    const uint8_t *tx_data;
+    int tx_len;
+    int tx_off;
 };
 
+/*
+ * HAL sends a byte at a time; feed it from the block handed out by
+ * uc_tx_buf, and report progress with uc_tx_buf_done.
+ */
+static int
+uart_hal_tx_buf_char(void *arg)
+{
+    struct uart_hal_priv *priv = arg;
+    int len;
+    int ch;
+
+    if (priv->tx_off == priv->tx_len) {
+        priv->tx_off = 0;
+        priv->tx_len = priv->tx_buf(priv->cb_arg, &priv->tx_data);
+        if (priv->tx_len <= 0) {
+            priv->tx_len = 0;
+            return -1;
+        }
+    }
+    ch = priv->tx_data[priv->tx_off++];
+    if (priv->tx_off == priv->tx_len || priv->tx_off == UART_HAL_TX_HOLD) {
+        len = priv->tx_off;
+        priv->tx_off = 0;
+        priv->tx_len = 0;
+        priv->tx_buf_done(priv->cb_arg, len);
+    }
+    return ch;
+}
+
+static void
+uart_hal_tx_buf_done(void *arg)
+{
+    struct uart_hal_priv *priv = arg;
+
+    if (priv->tx_done) {
+        priv->tx_done(priv->cb_arg);
+    }
+}
+
+static int
+uart_hal_rx_buf_char(void *arg, uint8_t byte)
+{
+    struct uart_hal_priv *priv = arg;
+
+    return priv->rx_char(priv->cb_arg, byte);
+}
+
 static void
 uart_hal_start_tx(struct uart_dev *dev)
 {
@@ -80,8 +143,21 @@ uart_hal_open(struct os_dev *odev, uint32_t wait, void *arg)
     if (odev->od_flags & OS_DEV_F_STATUS_OPEN) {
         return OS_EBUSY;
     }
-    hal_uart_init_cbs(priv->unit, uc->uc_tx_char, uc->uc_tx_done,
-      uc->uc_rx_char, uc->uc_cb_arg);
+    if (uc->uc_tx_buf && uc->uc_tx_buf_done) {
+        priv->tx_buf = uc->uc_tx_buf;
+        priv->tx_buf_done = uc->uc_tx_buf_done;
+        priv->tx_done = uc->uc_tx_done;
+        priv->rx_char = uc->uc_rx_char;
+        priv->cb_arg = uc->uc_cb_arg;
+        priv->tx_len = 0;
+        priv->tx_off = 0;
+        hal_uart_init_cbs(priv->unit, uart_hal_tx_buf_char,
+          uart_hal_tx_buf_done, uc->uc_rx_char ? uart_hal_rx_buf_char : NULL,
+          priv);
+    } else {
+        hal_uart_init_cbs(priv->unit, uc->uc_tx_char, uc->uc_tx_done,
+          uc->uc_rx_char, uc->uc_cb_arg);
+    }
 
     rc = hal_uart_config(priv->unit, uc->uc_speed, uc->uc_databits,
       uc->uc_stopbits, uc->uc_parity, uc->uc_flow_ctl);
@@ -25,6 +25,39 @@ extern "C" {
 #endif
 
 #include <inttypes.h>
+#include "os/os_eventq.h"
+
+/*
+ * One piece of data for hal_flash_writev().  When the flash has an alignment
+ * restriction, all but the last piece must be a multiple of it in length.
+ */
+struct hal_flash_iov {
+    const void *hfi_data;
+    uint32_t hfi_len;
+};
+
+#define HAL_FLASH_OP_READ       0
+#define HAL_FLASH_OP_WRITE      1
+#define HAL_FLASH_OP_ERASE      2
+
+/*
+ * Asynchronous flash operation.  The caller fills in everything but hfr_rc,
+ * including hfr_ev.ev_cb and hfr_ev.ev_arg.  When the operation completes,
+ * hfr_rc is set and hfr_ev is posted to hfr_evq.  The request, and the data
+ * it points to, must stay untouched until then.
+ */
+struct hal_flash_req {
+    struct os_event hfr_ev;
+    struct os_eventq *hfr_evq;
+    uint8_t hfr_op;             /* HAL_FLASH_OP_xxx */
+    uint8_t hfr_flash_id;
+    uint16_t hfr_iovcnt;        /* Write: number of entries in hfr_iov */
+    uint32_t hfr_addr;
+    uint32_t hfr_len;           /* Read, erase: number of bytes */
+    void *hfr_dst;              /* Read: destination */
+    const struct hal_flash_iov *hfr_iov; /* Write: data */
+    int hfr_rc;
+};
 
 int hal_flash_read(uint8_t flash_id, uint32_t address, void *dst,
   uint32_t num_bytes);
@@ -32,6 +65,11 @@ int hal_flash_write(uint8_t flash_id, uint32_t address, const void *src,
   uint32_t num_bytes);
 int hal_flash_erase_sector(uint8_t flash_id, uint32_t sector_address);
 int hal_flash_erase(uint8_t flash_id, uint32_t address, uint32_t num_bytes);
+int hal_flash_writev(uint8_t flash_id, uint32_t address,
+  const struct hal_flash_iov *iov, int iovcnt);
+int hal_flash_submit(struct hal_flash_req *req);
+const void *hal_flash_ptr(uint8_t flash_id, uint32_t address,
+  uint32_t num_bytes);
 uint8_t hal_flash_align(uint8_t flash_id);
 int hal_flash_init(void);
 
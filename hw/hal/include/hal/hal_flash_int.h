@@ -26,8 +26,20 @@ extern "C" {
 
 #include <inttypes.h>
 
+struct hal_flash_iov;
+struct hal_flash_req;
+
 /*
  * API that flash driver has to implement.
+ *
+ * hff_writev and hff_start are optional; leave them NULL to get the generic
+ * versions built on top of the blocking calls.  hff_start begins an
+ * operation and returns without waiting for it.  The driver reports
+ * completion with hal_flash_req_done(), which may be called from an
+ * interrupt.
+ *
+ * hff_ptr is set only by drivers for memory-mapped flash; it returns the
+ * address through which the CPU can read the flash location directly.
  */
 struct hal_flash_funcs {
     int (*hff_read)(uint32_t address, void *dst, uint32_t num_bytes);
@@ -35,6 +47,10 @@ struct hal_flash_funcs {
     int (*hff_erase_sector)(uint32_t sector_address);
     int (*hff_sector_info)(int idx, uint32_t *address, uint32_t *size);
     int (*hff_init)(void);
+    int (*hff_writev)(uint32_t address, const struct hal_flash_iov *iov,
+                      int iovcnt);
+    int (*hff_start)(struct hal_flash_req *req);
+    const void *(*hff_ptr)(uint32_t address);
 };
 
 struct hal_flash {
@@ -50,6 +66,11 @@ struct hal_flash {
  */
 uint32_t hal_flash_sector_size(const struct hal_flash *hf, int sec_idx);
 
+/*
+ * Called by the driver when an operation started with hff_start finishes.
+ */
+void hal_flash_req_done(struct hal_flash_req *req, int rc);
+
 
 #ifdef __cplusplus
 }
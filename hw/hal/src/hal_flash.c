@@ -124,6 +124,145 @@ hal_flash_erase_sector(uint8_t id, uint32_t sector_address)
     return hf->hf_itf->hff_erase_sector(sector_address);
 }
 
+static int
+hal_flash_writev_sync(const struct hal_flash *hf, uint32_t address,
+  const struct hal_flash_iov *iov, int iovcnt)
+{
+    int rc;
+    int i;
+
+    if (hf->hf_itf->hff_writev) {
+        return hf->hf_itf->hff_writev(address, iov, iovcnt);
+    }
+    for (i = 0; i < iovcnt; i++) {
+        rc = hf->hf_itf->hff_write(address, iov[i].hfi_data, iov[i].hfi_len);
+        if (rc) {
+            return rc;
+        }
+        address += iov[i].hfi_len;
+    }
+    return 0;
+}
+
+static uint32_t
+hal_flash_iov_len(const struct hal_flash_iov *iov, int iovcnt)
+{
+    uint32_t len;
+    int i;
+
+    len = 0;
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].hfi_len;
+    }
+    return len;
+}
+
+/*
+ * Writes the pieces of data described by iov to consecutive locations,
+ * starting at address.
+ */
+int
+hal_flash_writev(uint8_t id, uint32_t address,
+  const struct hal_flash_iov *iov, int iovcnt)
+{
+    const struct hal_flash *hf;
+
+    hf = hal_bsp_flash_dev(id);
+    if (!hf) {
+        return -1;
+    }
+    if (hal_flash_check_addr(hf, address) ||
+      hal_flash_check_addr(hf, address + hal_flash_iov_len(iov, iovcnt))) {
+        return -1;
+    }
+    return hal_flash_writev_sync(hf, address, iov, iovcnt);
+}
+
+/*
+ * Returns a pointer through which num_bytes of flash, starting at address,
+ * can be read directly.  Returns NULL if the flash is not memory-mapped;
+ * callers must then fall back to hal_flash_read().  The memory must not be
+ * written through the pointer, and its contents change when the flash is
+ * written or erased.
+ */
+const void *
+hal_flash_ptr(uint8_t id, uint32_t address, uint32_t num_bytes)
+{
+    const struct hal_flash *hf;
+
+    hf = hal_bsp_flash_dev(id);
+    if (!hf || !hf->hf_itf->hff_ptr) {
+        return NULL;
+    }
+    if (hal_flash_check_addr(hf, address) ||
+      hal_flash_check_addr(hf, address + num_bytes)) {
+        return NULL;
+    }
+    return hf->hf_itf->hff_ptr(address);
+}
+
+void
+hal_flash_req_done(struct hal_flash_req *req, int rc)
+{
+    req->hfr_rc = rc;
+    os_eventq_put(req->hfr_evq, &req->hfr_ev);
+}
+
+/*
+ * Starts an asynchronous read, write or erase.  If the driver can't do
+ * the operation in the background, it is done before this returns, but
+ * completion is still reported through the event queue.
+ *
+ * Returns 0 if the request was accepted, in which case the completion
+ * event will be posted.  Returns -1 if the request is invalid.
+ */
+int
+hal_flash_submit(struct hal_flash_req *req)
+{
+    const struct hal_flash *hf;
+    uint32_t len;
+    int rc;
+
+    hf = hal_bsp_flash_dev(req->hfr_flash_id);
+    if (!hf) {
+        return -1;
+    }
+    switch (req->hfr_op) {
+    case HAL_FLASH_OP_READ:
+    case HAL_FLASH_OP_ERASE:
+        len = req->hfr_len;
+        break;
+    case HAL_FLASH_OP_WRITE:
+        len = hal_flash_iov_len(req->hfr_iov, req->hfr_iovcnt);
+        break;
+    default:
+        return -1;
+    }
+    if (hal_flash_check_addr(hf, req->hfr_addr) ||
+      hal_flash_check_addr(hf, req->hfr_addr + len)) {
+        return -1;
+    }
+
+    if (hf->hf_itf->hff_start) {
+        return hf->hf_itf->hff_start(req);
+    }
+
+    switch (req->hfr_op) {
+    case HAL_FLASH_OP_READ:
+        rc = hf->hf_itf->hff_read(req->hfr_addr, req->hfr_dst, len);
+        break;
+    case HAL_FLASH_OP_WRITE:
+        rc = hal_flash_writev_sync(hf, req->hfr_addr, req->hfr_iov,
+          req->hfr_iovcnt);
+        break;
+    default:
+        rc = hal_flash_erase(req->hfr_flash_id, req->hfr_addr, len);
+        break;
+    }
+    hal_flash_req_done(req, rc);
+    return 0;
+}
+
 int
 hal_flash_erase(uint8_t id, uint32_t address, uint32_t num_bytes)
 {
@@ -154,6 +293,12 @@ hal_flash_erase(uint8_t id, uint32_t address, uint32_t num_bytes)
     for (i = 0; i < hf->hf_sector_cnt; i++) {
         rc = hf->hf_itf->hff_sector_info(i, &start, &size);
         assert(rc == 0);
+        if (start >= end) {
+            /*
+             * Sectors are in ascending order; the rest are past the range.
+             */
+            break;
+        }
         end_area = start + size;
         if (address < end_area && end > start) {
             /*
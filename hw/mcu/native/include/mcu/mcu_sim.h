@@ -19,6 +19,8 @@
 #ifndef __MCU_SIM_H__
 #define __MCU_SIM_H__
 
+#include <inttypes.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -30,6 +32,15 @@ extern char *native_uart_log_file;
 
 void mcu_sim_parse_args(int argc, char **argv);
 
+/*
+ * Flash simulator controls.
+ */
+uint64_t native_flash_busy_ns(void);
+uint32_t native_flash_erase_cnt(int idx);
+void native_flash_power_cut(uint32_t ops);
+int native_flash_power_is_cut(void);
+void native_flash_power_restore(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,6 +23,7 @@
 #include <string.h>
 #include <inttypes.h>
 #include <stdlib.h>
+#include "syscfg/syscfg.h"
 #include "hal/hal_flash_int.h"
 #include "mcu/mcu_sim.h"
 
@@ -36,13 +37,15 @@ static int native_flash_write(uint32_t address, const void *src,
   uint32_t length);
 static int native_flash_erase_sector(uint32_t sector_address);
 static int native_flash_sector_info(int idx, uint32_t *address, uint32_t *size);
+static const void *native_flash_ptr(uint32_t address);
 
 static const struct hal_flash_funcs native_flash_funcs = {
     .hff_read = native_flash_read,
     .hff_write = native_flash_write,
     .hff_erase_sector = native_flash_erase_sector,
     .hff_sector_info = native_flash_sector_info,
-    .hff_init = native_flash_init
+    .hff_init = native_flash_init,
+    .hff_ptr = native_flash_ptr
 };
 
 static const uint32_t native_flash_sectors[] = {
@@ -71,6 +74,20 @@ const struct hal_flash native_flash_dev = {
     .hf_align = 1
 };
 
+/*
+ * Model of real flash costs.  Time spent in flash operations is added up,
+ * and shows up as simulated time in os_cputime.  A power cut can be
+ * scheduled to happen during the Nth write or erase; that operation is
+ * only half done, and the flash fails all writes and erases until power is
+ * restored.
+ */
+static struct {
+    uint64_t busy_ns;
+    uint32_t erase_cnt[FLASH_NUM_AREAS];
+    uint32_t cut_ops;       /* Write/erase ops until power cut; 0 if none */
+    uint8_t cut;            /* Power has been cut */
+} native_flash_sim;
+
 static void
 flash_native_erase(uint32_t addr, uint32_t len)
 {
@@ -156,11 +173,40 @@ flash_native_write_internal(uint32_t address, const void *src, uint32_t length,
     return 0;
 }
 
+/*
+ * Counts a write or erase towards a scheduled power cut.  Returns nonzero
+ * if the flash is without power.  If this operation is the one interrupted,
+ * *len is cut short.
+ */
+static int
+native_flash_sim_op(uint32_t *len)
+{
+    if (native_flash_sim.cut) {
+        return -1;
+    }
+    if (native_flash_sim.cut_ops && --native_flash_sim.cut_ops == 0) {
+        native_flash_sim.cut = 1;
+        *len /= 2;
+    }
+    return 0;
+}
+
 static int
 native_flash_write(uint32_t address, const void *src, uint32_t length)
 {
+    int rc;
+
     assert(address % native_flash_dev.hf_align == 0);
-    return flash_native_write_internal(address, src, length, 0);
+    if (native_flash_sim_op(&length)) {
+        return -1;
+    }
+    native_flash_sim.busy_ns +=
+        (uint64_t)length * MYNEWT_VAL(MCU_NATIVE_FLASH_PROG_NS);
+    rc = flash_native_write_internal(address, src, length, 0);
+    if (native_flash_sim.cut) {
+        return -1;
+    }
+    return rc;
 }
 
 int
@@ -175,10 +221,23 @@ native_flash_read(uint32_t address, void *dst, uint32_t length)
 {
     flash_native_ensure_file_open();
     memcpy(dst, (char *)file_loc + address, length);
+    native_flash_sim.busy_ns +=
+        (uint64_t)length * MYNEWT_VAL(MCU_NATIVE_FLASH_READ_NS);
 
     return 0;
 }
 
+/*
+ * The backing file is mapped into memory, so the simulated flash can be
+ * read in place like internal flash on a real MCU.
+ */
+static const void *
+native_flash_ptr(uint32_t address)
+{
+    flash_native_ensure_file_open();
+    return (char *)file_loc + address;
+}
+
 static int
 find_area(uint32_t address)
 {
@@ -219,7 +278,16 @@ native_flash_erase_sector(uint32_t sector_address)
         return -1;
     }
     len = flash_sector_len(area_id);
+    if (native_flash_sim_op(&len)) {
+        return -1;
+    }
+    native_flash_sim.busy_ns +=
+        (uint64_t)MYNEWT_VAL(MCU_NATIVE_FLASH_ERASE_US) * 1000;
+    native_flash_sim.erase_cnt[area_id]++;
     flash_native_erase(sector_address, len);
+    if (native_flash_sim.cut) {
+        return -1;
+    }
     return 0;
 }
 
@@ -242,3 +310,55 @@ native_flash_init(void)
     return 0;
 }
 
+/**
+ * Returns the total simulated time spent in flash operations.
+ */
+uint64_t
+native_flash_busy_ns(void)
+{
+    return native_flash_sim.busy_ns;
+}
+
+/**
+ * Returns how many times a sector has been erased.
+ *
+ * @param idx                   Sector index.
+ */
+uint32_t
+native_flash_erase_cnt(int idx)
+{
+    assert(idx < FLASH_NUM_AREAS);
+    return native_flash_sim.erase_cnt[idx];
+}
+
+/**
+ * Schedules a power cut during a later write or erase.
+ *
+ * @param ops                   Number of the write/erase to interrupt,
+ *                                  counting from 1; 0 cancels a scheduled
+ *                                  cut.
+ */
+void
+native_flash_power_cut(uint32_t ops)
+{
+    native_flash_sim.cut_ops = ops;
+}
+
+/**
+ * Returns 1 if the flash is without power.
+ */
+int
+native_flash_power_is_cut(void)
+{
+    return native_flash_sim.cut;
+}
+
+/**
+ * Restores power after a cut; flash can be written again.
+ */
+void
+native_flash_power_restore(void)
+{
+    native_flash_sim.cut = 0;
+    native_flash_sim.cut_ops = 0;
+}
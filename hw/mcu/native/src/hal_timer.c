@@ -21,6 +21,7 @@
 #include <os/os.h>
 
 #include "hal/hal_timer.h"
+#include "mcu/mcu_sim.h"
 
 /*
  * For native cpu implementation.
@@ -184,7 +185,9 @@ hal_timer_read(int num)
     }
     OS_EXIT_CRITICAL(sr);
 
-    return (uint32_t)nt->cnt;
+    /* Time the flash simulator says was spent in flash operations. */
+    return (uint32_t)nt->cnt + (uint32_t)(native_flash_busy_ns() / 1000 *
+      nt->ticks_per_ostick * OS_TICKS_PER_SEC / 1000000);
 }
 
 /**
@@ -31,6 +31,7 @@ extern "C" {
 #define IMGMGR_NMGR_OP_FILE         2
 #define IMGMGR_NMGR_OP_CORELIST     3
 #define IMGMGR_NMGR_OP_CORELOAD     4
+#define IMGMGR_NMGR_OP_DELTA        5
 
 #define IMGMGR_NMGR_MAX_MSG         400
 #define IMGMGR_NMGR_MAX_NAME		64
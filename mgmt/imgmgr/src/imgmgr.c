@@ -70,6 +70,15 @@ static const struct mgmt_handler imgr_nmgr_handlers[] = {
 #else
         .mh_read = NULL,
         .mh_write = NULL
+#endif
+    },
+    [IMGMGR_NMGR_OP_DELTA] = {
+#if MYNEWT_VAL(IMGMGR_DELTA)
+        .mh_read = NULL,
+        .mh_write = imgr_delta_upload
+#else
+        .mh_read = NULL,
+        .mh_write = NULL
 #endif
     },
 };
@@ -86,22 +95,30 @@ static struct mgmt_group imgr_nmgr_group = {
 struct imgr_state imgr_state;
 
 /*
- * Read version and build hash from image located slot "image_slot".  Note:
- * this is a slot index, not a flash area ID.
- *
- * @param image_slot
- * @param ver (optional)
- * @param hash (optional)
- * @param flags
- *
- * Returns -1 if area is not readable.
- * Returns 0 if image in slot is ok, and version string is valid.
- * Returns 1 if there is not a full image.
- * Returns 2 if slot is empty. XXXX not there yet
+ * Image info of both slots, as last read from flash.  Every query used to
+ * open the slot and walk its TLVs; state reads ask for both slots, and
+ * find_by_ver/find_by_hash walk them again.  An entry is valid as long as
+ * its generation matches the slot's; anything writing to a slot bumps the
+ * generation with imgr_info_invalidate().
  */
-int
-imgr_read_info(int image_slot, struct image_version *ver, uint8_t *hash,
-               uint32_t *flags)
+static struct imgr_info {
+    uint32_t ii_gen;
+    uint8_t ii_valid;
+    int8_t ii_rc;
+    struct image_version ii_ver;
+    uint32_t ii_flags;
+    uint8_t ii_hash[IMGMGR_HASH_LEN];
+} imgr_info_cache[IMGMGR_MAX_IMGS];
+
+static volatile uint32_t imgr_info_gen[IMGMGR_MAX_IMGS];
+
+/*
+ * Reads version, flags and build hash of image in slot from flash.
+ * Return codes are the same as imgr_read_info().
+ */
+static int
+imgr_read_info_flash(int image_slot, struct image_version *ver, uint8_t *hash,
+                     uint32_t *flags)
 {
     struct image_header *hdr;
     struct image_tlv *tlv;
@@ -183,6 +200,78 @@ end:
     return rc;
 }
 
+/*
+ * Drops cached image info of the slot in flash area fa.  Must be called
+ * after every write or erase of an image slot.
+ */
+void
+imgr_info_invalidate(const struct flash_area *fa)
+{
+    int slot;
+
+    slot = flash_area_id_to_image_slot(fa->fa_id);
+    if (slot >= 0 && slot < IMGMGR_MAX_IMGS) {
+        imgr_info_gen[slot]++;
+    }
+}
+
+/*
+ * Read version and build hash from image located slot "image_slot".  Note:
+ * this is a slot index, not a flash area ID.
+ *
+ * @param image_slot
+ * @param ver (optional)
+ * @param hash (optional)
+ * @param flags
+ *
+ * Returns -1 if area is not readable.
+ * Returns 0 if image in slot is ok, and version string is valid.
+ * Returns 1 if there is not a full image.
+ * Returns 2 if slot is empty. XXXX not there yet
+ */
+int
+imgr_read_info(int image_slot, struct image_version *ver, uint8_t *hash,
+               uint32_t *flags)
+{
+    struct imgr_info *ii;
+    uint32_t gen;
+    int rc;
+
+    if (image_slot < 0 || image_slot >= IMGMGR_MAX_IMGS) {
+        return -1;
+    }
+    ii = &imgr_info_cache[image_slot];
+
+    gen = imgr_info_gen[image_slot];
+    if (!ii->ii_valid || ii->ii_gen != gen) {
+        rc = imgr_read_info_flash(image_slot, &ii->ii_ver, ii->ii_hash,
+                                  &ii->ii_flags);
+        if (rc < 0) {
+            ii->ii_valid = 0;
+            return rc;
+        }
+        /*
+         * If the slot was written while we were reading it, the entry is
+         * stale by the time it's stored; the generation check catches it
+         * on the next lookup.
+         */
+        ii->ii_rc = rc;
+        ii->ii_gen = gen;
+        ii->ii_valid = 1;
+    }
+
+    if (ver) {
+        memcpy(ver, &ii->ii_ver, sizeof(*ver));
+    }
+    if (flags) {
+        *flags = ii->ii_flags;
+    }
+    if (hash && ii->ii_rc == 0) {
+        memcpy(hash, ii->ii_hash, IMGMGR_HASH_LEN);
+    }
+    return ii->ii_rc;
+}
+
 int
 imgr_my_version(struct image_version *ver)
 {
@@ -231,20 +320,169 @@ imgr_find_by_hash(uint8_t *find, struct image_version *ver)
     return -1;
 }
 
+/*
+ * Picks the slot to upload a new image to.  Returns the slot number, or -1
+ * if both slots are in use.
+ */
+int
+imgr_upload_slot(void)
+{
+    struct image_version ver;
+    int best;
+    int rc;
+    int i;
+
+    best = -1;
+    for (i = 0; i < 2; i++) {
+        rc = imgr_read_info(i, &ver, NULL, NULL);
+        if (rc < 0) {
+            continue;
+        }
+        if (rc == 0) {
+            /* Image in slot is ok. */
+            if (imgmgr_state_slot_in_use(i)) {
+                /* Slot is in use; can't upload to this. */
+                continue;
+            } else {
+                /*
+                 * Not active slot, but image is ok. Use it if there are
+                 * no better candidates.
+                 */
+                best = i;
+            }
+            continue;
+        }
+        best = i;
+        break;
+    }
+    return best;
+}
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_HASH)
+static void
+imgr_upload_hash_start(struct image_header *hdr, int slot)
+{
+    mbedtls_sha256_init(&imgr_state.upload.sha);
+    mbedtls_sha256_starts(&imgr_state.upload.sha, 0);
+    imgr_state.upload.hash_sz = hdr->ih_hdr_size + hdr->ih_img_size;
+    imgr_state.upload.hash_ok = 1;
+    imgr_state.upload.slot = slot;
+}
+
+/*
+ * Feeds a chunk to the running hash.  Called once the acknowledged offset
+ * has moved past the chunk.
+ */
+static void
+imgr_upload_hash_update(uint32_t off, const struct cbor_bytes_ref *data)
+{
+    const uint8_t *ptr;
+    uint32_t len;
+    size_t cnt;
+    size_t i;
+
+    len = data->len;
+    if (!imgr_state.upload.hash_ok) {
+        return;
+    }
+    if (off + len != imgr_state.upload.off) {
+        /*
+         * Data was received out of order, and already acknowledged.  Leave
+         * it to the boot loader to hash the slot.
+         */
+        imgr_state.upload.hash_ok = 0;
+        return;
+    }
+    if (off >= imgr_state.upload.hash_sz) {
+        /* TLVs aren't covered by the hash. */
+        return;
+    }
+    if (off + len > imgr_state.upload.hash_sz) {
+        len = imgr_state.upload.hash_sz - off;
+    }
+    for (i = 0; i < len; i += cnt) {
+        ptr = cbor_bytes_ref_ptr(data, i, &cnt);
+        if (ptr == NULL) {
+            imgr_state.upload.hash_ok = 0;
+            return;
+        }
+        if (cnt > len - i) {
+            cnt = len - i;
+        }
+        mbedtls_sha256_update(&imgr_state.upload.sha, ptr, cnt);
+    }
+}
+
+/*
+ * Checks the running hash against the image's hash TLV.
+ */
+static int
+imgr_upload_hash_finish(void)
+{
+    uint8_t tlv_hash[IMGMGR_HASH_LEN];
+    uint8_t hash[IMGMGR_HASH_LEN];
+
+    if (!imgr_state.upload.hash_ok) {
+        return 0;
+    }
+    imgr_state.upload.hash_ok = 0;
+    mbedtls_sha256_finish(&imgr_state.upload.sha, hash);
+
+    if (imgr_read_info(imgr_state.upload.slot, NULL, tlv_hash, NULL) != 0) {
+        /* Image has no hash TLV; nothing to check against. */
+        return 0;
+    }
+    if (memcmp(hash, tlv_hash, sizeof(hash))) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    return 0;
+}
+#endif
+
+/**
+ * Writes a byte string from a request to flash straight out of the request
+ * buffer, a contiguous piece at a time.
+ *
+ * @param fa                    Flash area to write to.
+ * @param off                   Offset within the flash area.
+ * @param data                  Data to write.
+ *
+ * @return                      0 on success; MGMT_ERR_EINVAL on failure.
+ */
+int
+imgr_bytes_write(const struct flash_area *fa, uint32_t off,
+                 const struct cbor_bytes_ref *data)
+{
+    const uint8_t *ptr;
+    size_t len;
+    size_t i;
+    int rc;
+
+    for (i = 0; i < data->len; i += len) {
+        ptr = cbor_bytes_ref_ptr(data, i, &len);
+        if (ptr == NULL) {
+            return MGMT_ERR_EINVAL;
+        }
+        rc = flash_area_write(fa, off + i, ptr, len);
+        if (rc) {
+            return MGMT_ERR_EINVAL;
+        }
+    }
+    return 0;
+}
+
 static int
 imgr_upload(struct mgmt_cbuf *cb)
 {
-    uint8_t img_data[IMGMGR_NMGR_MAX_MSG];
+    struct cbor_bytes_ref data;
     long long unsigned int off = UINT_MAX;
     long long unsigned int size = UINT_MAX;
-    size_t data_len = 0;
     const struct cbor_attr_t off_attr[4] = {
         [0] = {
             .attribute = "data",
-            .type = CborAttrByteStringType,
-            .addr.bytestring.data = img_data,
-            .addr.bytestring.len = &data_len,
-            .len = sizeof(img_data)
+            .type = CborAttrByteStringRefType,
+            .addr.bytesref = &data
         },
         [1] = {
             .attribute = "len",
@@ -260,12 +498,13 @@ imgr_upload(struct mgmt_cbuf *cb)
         },
         [3] = { 0 },
     };
-    struct image_version ver;
-    struct image_header *hdr;
+    struct image_header hdr;
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0 && MYNEWT_VAL(IMGMGR_UPLOAD_HASH)
+    uint32_t prev_off;
+#endif
     int area_id;
     int best;
     int rc;
-    int i;
     CborEncoder *penc = &cb->encoder;
     CborEncoder rsp;
     CborError g_err = CborNoError;
@@ -277,15 +516,14 @@ imgr_upload(struct mgmt_cbuf *cb)
     }
 
     if (off == 0) {
-        if (data_len < sizeof(struct image_header)) {
-            /*
-             * Image header is the first thing in the image.
-             */
+        /*
+         * Image header is the first thing in the image.
+         */
+        if (cbor_bytes_ref_copy(&data, 0, &hdr, sizeof(hdr))) {
             rc = MGMT_ERR_EINVAL;
             goto err;
         }
-        hdr = (struct image_header *)img_data;
-        if (hdr->ih_magic != IMAGE_MAGIC) {
+        if (hdr.ih_magic != IMAGE_MAGIC) {
             rc = MGMT_ERR_EINVAL;
             goto err;
         }
@@ -293,32 +531,15 @@ imgr_upload(struct mgmt_cbuf *cb)
         /*
          * New upload.
          */
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+        /* Writes of a previous upload may still be pending. */
+        imgr_upload_win_drain();
+        imgr_upload_win_start();
+#endif
         imgr_state.upload.off = 0;
         imgr_state.upload.size = size;
-        best = -1;
 
-        for (i = 0; i < 2; i++) {
-            rc = imgr_read_info(i, &ver, NULL, NULL);
-            if (rc < 0) {
-                continue;
-            }
-            if (rc == 0) {
-                /* Image in slot is ok. */
-                if (imgmgr_state_slot_in_use(i)) {
-                    /* Slot is in use; can't upload to this. */
-                    continue;
-                } else {
-                    /*
-                     * Not active slot, but image is ok. Use it if there are
-                     * no better candidates.
-                     */
-                    best = i;
-                }
-                continue;
-            }
-            best = i;
-            break;
-        }
+        best = imgr_upload_slot();
         if (best >= 0) {
             area_id = flash_area_id_from_image_slot(best);
             if (imgr_state.upload.fa) {
@@ -330,7 +551,7 @@ imgr_upload(struct mgmt_cbuf *cb)
                 rc = MGMT_ERR_EINVAL;
                 goto err;
             }
-            if (IMAGE_SIZE(hdr) > imgr_state.upload.fa->fa_size) {
+            if (IMAGE_SIZE(&hdr) > imgr_state.upload.fa->fa_size) {
                 rc = MGMT_ERR_EINVAL;
                 goto err;
             }
@@ -339,6 +560,10 @@ imgr_upload(struct mgmt_cbuf *cb)
              */
             rc = flash_area_erase(imgr_state.upload.fa, 0,
               imgr_state.upload.fa->fa_size);
+            imgr_info_invalidate(imgr_state.upload.fa);
+#if MYNEWT_VAL(IMGMGR_UPLOAD_HASH)
+            imgr_upload_hash_start(&hdr, best);
+#endif
         } else {
             /*
              * No slot where to upload!
@@ -349,35 +574,97 @@ imgr_upload(struct mgmt_cbuf *cb)
     } else if (off != imgr_state.upload.off) {
         /*
          * Invalid offset. Drop the data, and respond with the offset we're
-         * expecting data for.
+         * expecting data for.  With windowed uploads, out of order chunks
+         * are accepted as long as they fall within the window.
          */
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+        if (!imgr_state.upload.fa || !data.len) {
+            goto out;
+        }
+#else
         goto out;
+#endif
     }
 
     if (!imgr_state.upload.fa) {
         rc = MGMT_ERR_EINVAL;
         goto err;
     }
-    if (data_len) {
-        rc = flash_area_write(imgr_state.upload.fa, imgr_state.upload.off,
-          img_data, data_len);
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    if (off != 0 && data.len) {
+        /*
+         * The first chunk is written synchronously, the rest is queued to
+         * the writer task.
+         */
+#if MYNEWT_VAL(IMGMGR_UPLOAD_HASH)
+        prev_off = imgr_state.upload.off;
+#endif
+        rc = imgr_upload_win_rx(off, &data);
         if (rc) {
-            rc = MGMT_ERR_EINVAL;
             goto err_close;
         }
-        imgr_state.upload.off += data_len;
+#if MYNEWT_VAL(IMGMGR_UPLOAD_HASH)
+        if (imgr_state.upload.off != prev_off) {
+            imgr_upload_hash_update(off, &data);
+        }
+#endif
+        goto done;
+    }
+#endif
+    if (data.len) {
+        rc = imgr_bytes_write(imgr_state.upload.fa, imgr_state.upload.off,
+          &data);
+        imgr_info_invalidate(imgr_state.upload.fa);
+        if (rc) {
+            goto err_close;
+        }
+        imgr_state.upload.off += data.len;
+#if MYNEWT_VAL(IMGMGR_UPLOAD_HASH)
+        imgr_upload_hash_update(off, &data);
+#endif
         if (imgr_state.upload.size == imgr_state.upload.off) {
             /* Done */
+#if MYNEWT_VAL(IMGMGR_UPLOAD_HASH)
+            rc = imgr_upload_hash_finish();
+            if (rc) {
+                goto err_close;
+            }
+#endif
             flash_area_close(imgr_state.upload.fa);
             imgr_state.upload.fa = NULL;
         }
     }
+    goto out;
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+done:
+    if (imgr_state.upload.size == imgr_state.upload.off) {
+        /* Only ack the last chunk once everything is in flash. */
+        rc = imgr_upload_win_drain();
+        if (rc) {
+            goto err_close;
+        }
+#if MYNEWT_VAL(IMGMGR_UPLOAD_HASH)
+        rc = imgr_upload_hash_finish();
+        if (rc) {
+            goto err_close;
+        }
+#endif
+        flash_area_close(imgr_state.upload.fa);
+        imgr_state.upload.fa = NULL;
+    }
+#endif
 out:
     g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
     g_err |= cbor_encode_text_stringz(&rsp, "rc");
     g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
     g_err |= cbor_encode_text_stringz(&rsp, "off");
     g_err |= cbor_encode_int(&rsp, imgr_state.upload.off);
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    /* Tells the client how many chunks it may have in flight. */
+    g_err |= cbor_encode_text_stringz(&rsp, "win");
+    g_err |= cbor_encode_uint(&rsp, MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW));
+#endif
     g_err |= cbor_encoder_close_container(penc, &rsp);
 
     if (g_err) {
@@ -400,6 +687,11 @@ imgmgr_module_init(void)
     rc = mgmt_group_register(&imgr_nmgr_group);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    rc = imgr_upload_win_init();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
 #if MYNEWT_VAL(IMGMGR_CLI)
     rc = imgr_cli_register();
     SYSINIT_PANIC_ASSERT(rc == 0);
@@ -157,6 +157,8 @@ imgr_core_erase(struct mgmt_cbuf *cb)
     if (rc == 0 &&
       (hdr.ch_magic == COREDUMP_MAGIC || hdr.ch_magic == 0xffffffff)) {
         rc = flash_area_erase(fa, 0, fa->fa_size);
+        /* The core area may double as an image slot. */
+        imgr_info_invalidate(fa);
         if (rc) {
             rc = MGMT_ERR_EINVAL;
         }
@@ -0,0 +1,523 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+
+#include <limits.h>
+#include <string.h>
+
+#include "os/os.h"
+#include "sysflash/sysflash.h"
+#include "flash_map/flash_map.h"
+#include "cborattr/cborattr.h"
+#include "bootutil/image.h"
+#include "mgmt/mgmt.h"
+
+#include "imgmgr/imgmgr.h"
+#include "imgmgr_priv.h"
+
+/*
+ * Delta image upload.
+ *
+ * The client sends a patch which turns an image already on the device (the
+ * base, identified by its hash) into the new image.  The patch is a
+ * sequence of commands, each starting with an opcode byte followed by
+ * LEB128 encoded arguments:
+ *
+ *     COPY <len> <src>             Copy len bytes from the base image.
+ *     DATA <len> <bytes...>        Insert len literal bytes.
+ *     ADD  <len> <src> <bytes...>  Copy len bytes from the base image,
+ *                                  adding each patch byte to each base
+ *                                  byte (modulo 256).
+ *
+ * <src> is zigzag encoded, relative to where the previous COPY or ADD
+ * stopped reading the base image.  The new image is built sequentially
+ * in the upload slot as the patch arrives, through a buffer of
+ * IMGMGR_DELTA_BUF_SIZE bytes, so patches of any size can be applied.
+ * The result is a normal image; it gets validated by the boot loader like
+ * any other.
+ */
+
+#define IMGR_DELTA_OP_COPY      0
+#define IMGR_DELTA_OP_DATA      1
+#define IMGR_DELTA_OP_ADD       2
+
+#define IMGR_DELTA_ST_OP        0
+#define IMGR_DELTA_ST_LEN       1
+#define IMGR_DELTA_ST_SRC       2
+#define IMGR_DELTA_ST_BODY      3
+
+static struct {
+    const struct flash_area *base;
+
+    /* Offset in the upload slot of the start of wbuf. */
+    uint32_t out_off;
+
+    /* Next offset to read from the base image. */
+    uint32_t src_off;
+
+    /* Bytes left in the current command. */
+    uint32_t cmd_len;
+
+    /* LEB128 argument being decoded. */
+    uint32_t arg;
+    uint8_t arg_shift;
+
+    uint8_t state;
+    uint8_t op;
+
+    uint16_t wbuf_len;
+    uint8_t wbuf[MYNEWT_VAL(IMGMGR_DELTA_BUF_SIZE)];
+} imgr_delta;
+
+/**
+ * Closes the base image and the upload slot of a delta upload.
+ */
+void
+imgr_delta_close(void)
+{
+    if (imgr_delta.base) {
+        flash_area_close(imgr_delta.base);
+        imgr_delta.base = NULL;
+    }
+    if (imgr_state.upload.fa) {
+        flash_area_close(imgr_state.upload.fa);
+        imgr_state.upload.fa = NULL;
+    }
+}
+
+static int
+imgr_delta_flush(void)
+{
+    int rc;
+
+    if (imgr_delta.out_off + imgr_delta.wbuf_len >
+      imgr_state.upload.fa->fa_size) {
+        return MGMT_ERR_EINVAL;
+    }
+    rc = flash_area_write(imgr_state.upload.fa, imgr_delta.out_off,
+      imgr_delta.wbuf, imgr_delta.wbuf_len);
+    imgr_info_invalidate(imgr_state.upload.fa);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+    imgr_delta.out_off += imgr_delta.wbuf_len;
+    imgr_delta.wbuf_len = 0;
+    return 0;
+}
+
+/*
+ * Reads len bytes of the base image to the end of wbuf.
+ */
+static int
+imgr_delta_read_base(uint32_t len)
+{
+    int rc;
+
+    if (imgr_delta.src_off > imgr_delta.base->fa_size ||
+      len > imgr_delta.base->fa_size - imgr_delta.src_off) {
+        return MGMT_ERR_EINVAL;
+    }
+    rc = flash_area_read(imgr_delta.base, imgr_delta.src_off,
+      imgr_delta.wbuf + imgr_delta.wbuf_len, len);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+    imgr_delta.src_off += len;
+    return 0;
+}
+
+/*
+ * Decodes one LEB128 byte.  Returns 1 when the argument is complete,
+ * 0 if more bytes are needed, and -1 if it does not fit in 32 bits.
+ */
+static int
+imgr_delta_arg(uint8_t byte)
+{
+    if (imgr_delta.arg_shift == 28 && (byte & 0xf0)) {
+        /* Fifth byte; only 4 bits are left, and no more bytes may follow. */
+        return -1;
+    }
+    imgr_delta.arg |= (uint32_t)(byte & 0x7f) << imgr_delta.arg_shift;
+    imgr_delta.arg_shift += 7;
+    if (byte & 0x80) {
+        return 0;
+    }
+    imgr_delta.arg_shift = 0;
+    return 1;
+}
+
+/*
+ * Runs the command in progress as far as the input allows.  Returns the
+ * number of patch bytes consumed, or -1 on error.
+ */
+static int
+imgr_delta_body(const uint8_t *data, uint32_t len)
+{
+    uint32_t space;
+    uint32_t cnt;
+    uint32_t used;
+    uint32_t i;
+    uint8_t *dst;
+
+    used = 0;
+    while (imgr_delta.cmd_len) {
+        if (imgr_delta.wbuf_len == sizeof(imgr_delta.wbuf)) {
+            if (imgr_delta_flush()) {
+                return -1;
+            }
+        }
+        space = sizeof(imgr_delta.wbuf) - imgr_delta.wbuf_len;
+        cnt = min(space, imgr_delta.cmd_len);
+        if (imgr_delta.op != IMGR_DELTA_OP_COPY) {
+            cnt = min(cnt, len - used);
+            if (!cnt) {
+                break;
+            }
+        }
+        dst = imgr_delta.wbuf + imgr_delta.wbuf_len;
+
+        switch (imgr_delta.op) {
+        case IMGR_DELTA_OP_COPY:
+            if (imgr_delta_read_base(cnt)) {
+                return -1;
+            }
+            break;
+        case IMGR_DELTA_OP_DATA:
+            memcpy(dst, data + used, cnt);
+            used += cnt;
+            break;
+        case IMGR_DELTA_OP_ADD:
+            if (imgr_delta_read_base(cnt)) {
+                return -1;
+            }
+            for (i = 0; i < cnt; i++) {
+                dst[i] += data[used + i];
+            }
+            used += cnt;
+            break;
+        }
+        imgr_delta.wbuf_len += cnt;
+        imgr_delta.cmd_len -= cnt;
+    }
+    if (!imgr_delta.cmd_len) {
+        imgr_delta.state = IMGR_DELTA_ST_OP;
+    }
+    return used;
+}
+
+/**
+ * Applies a chunk of the patch.
+ *
+ * @return                      0 on success; MGMT_ERR_EINVAL if the patch is
+ *                                  malformed or can't be applied.
+ */
+int
+imgr_delta_apply(const uint8_t *data, uint32_t len)
+{
+    uint32_t off;
+    int32_t rel;
+    int rc;
+
+    off = 0;
+    while (off < len || imgr_delta.state == IMGR_DELTA_ST_BODY) {
+        switch (imgr_delta.state) {
+        case IMGR_DELTA_ST_OP:
+            imgr_delta.op = data[off++];
+            if (imgr_delta.op > IMGR_DELTA_OP_ADD) {
+                return MGMT_ERR_EINVAL;
+            }
+            imgr_delta.arg = 0;
+            imgr_delta.state = IMGR_DELTA_ST_LEN;
+            break;
+        case IMGR_DELTA_ST_LEN:
+        case IMGR_DELTA_ST_SRC:
+            rc = imgr_delta_arg(data[off++]);
+            if (rc < 0) {
+                return MGMT_ERR_EINVAL;
+            }
+            if (rc == 0) {
+                break;
+            }
+            if (imgr_delta.state == IMGR_DELTA_ST_LEN) {
+                imgr_delta.cmd_len = imgr_delta.arg;
+                imgr_delta.arg = 0;
+                if (imgr_delta.op == IMGR_DELTA_OP_DATA) {
+                    imgr_delta.state = IMGR_DELTA_ST_BODY;
+                } else {
+                    imgr_delta.state = IMGR_DELTA_ST_SRC;
+                }
+            } else {
+                /* Zigzag decode. */
+                rel = (int32_t)(imgr_delta.arg >> 1) ^
+                  -(int32_t)(imgr_delta.arg & 1);
+                imgr_delta.src_off += rel;
+                imgr_delta.state = IMGR_DELTA_ST_BODY;
+            }
+            break;
+        case IMGR_DELTA_ST_BODY:
+            rc = imgr_delta_body(data + off, len - off);
+            if (rc < 0) {
+                return MGMT_ERR_EINVAL;
+            }
+            off += rc;
+            if (imgr_delta.state == IMGR_DELTA_ST_BODY) {
+                /* Needs more patch data. */
+                return 0;
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Writes out the rest of the image, and checks that the result looks like
+ * an image.
+ *
+ * @return                      0 on success; MGMT_ERR_EINVAL if the patch
+ *                                  ended in the middle of a command, or
+ *                                  didn't produce an image.
+ */
+int
+imgr_delta_finish(void)
+{
+    struct image_header hdr;
+    uint8_t align;
+    int rc;
+
+    if (imgr_delta.state != IMGR_DELTA_ST_OP) {
+        /* Patch ended in the middle of a command. */
+        return MGMT_ERR_EINVAL;
+    }
+
+    align = flash_area_align(imgr_state.upload.fa);
+    while (imgr_delta.wbuf_len % align) {
+        imgr_delta.wbuf[imgr_delta.wbuf_len++] = 0xff;
+    }
+    rc = imgr_delta_flush();
+    if (rc) {
+        return rc;
+    }
+
+    rc = flash_area_read(imgr_state.upload.fa, 0, &hdr, sizeof(hdr));
+    if (rc || hdr.ih_magic != IMAGE_MAGIC ||
+      IMAGE_SIZE(&hdr) > imgr_delta.out_off) {
+        return MGMT_ERR_EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * Starts building an image in slot from the image in base_slot.
+ *
+ * @param base_slot             Slot holding the base image.
+ * @param slot                  Slot to build the new image in.
+ * @param size                  Size of the patch, in bytes.
+ *
+ * @return                      0 on success; MGMT_ERR_xxx on failure.
+ */
+int
+imgr_delta_open(int base_slot, int slot, uint32_t size)
+{
+    int rc;
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    /* Writes of an abandoned windowed upload may still be pending; they
+     * must land before the slot is erased, not on top of the new image.
+     */
+    imgr_upload_win_drain();
+    imgr_upload_win_start();
+#endif
+
+    imgr_delta_close();
+
+    if (slot == base_slot) {
+        /* Can't build the new image on top of its base. */
+        return MGMT_ERR_EINVAL;
+    }
+
+    rc = flash_area_open(flash_area_id_from_image_slot(base_slot),
+      &imgr_delta.base);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+    rc = flash_area_open(flash_area_id_from_image_slot(slot),
+      &imgr_state.upload.fa);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+    rc = flash_area_erase(imgr_state.upload.fa, 0,
+      imgr_state.upload.fa->fa_size);
+    imgr_info_invalidate(imgr_state.upload.fa);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    imgr_state.upload.off = 0;
+    imgr_state.upload.size = size;
+    imgr_delta.out_off = 0;
+    imgr_delta.src_off = 0;
+    imgr_delta.arg_shift = 0;
+    imgr_delta.state = IMGR_DELTA_ST_OP;
+    imgr_delta.wbuf_len = 0;
+
+    return 0;
+}
+
+static int
+imgr_delta_start(uint8_t *base_hash, uint32_t size)
+{
+    int base;
+    int slot;
+
+    imgr_delta_close();
+
+    base = imgr_find_by_hash(base_hash, NULL);
+    if (base < 0) {
+        return MGMT_ERR_ENOENT;
+    }
+    slot = imgr_upload_slot();
+    if (slot < 0) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    return imgr_delta_open(base, slot, size);
+}
+
+int
+imgr_delta_upload(struct mgmt_cbuf *cb)
+{
+    struct cbor_bytes_ref data;
+    uint8_t base_hash[IMGMGR_HASH_LEN];
+    long long unsigned int off = UINT_MAX;
+    long long unsigned int size = UINT_MAX;
+    const uint8_t *ptr;
+    size_t hash_len = 0;
+    size_t len;
+    size_t i;
+    const struct cbor_attr_t off_attr[5] = {
+        [0] = {
+            .attribute = "data",
+            .type = CborAttrByteStringRefType,
+            .addr.bytesref = &data
+        },
+        [1] = {
+            .attribute = "len",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &size,
+            .nodefault = true
+        },
+        [2] = {
+            .attribute = "off",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &off,
+            .nodefault = true
+        },
+        [3] = {
+            .attribute = "base",
+            .type = CborAttrByteStringType,
+            .addr.bytestring.data = base_hash,
+            .addr.bytestring.len = &hash_len,
+            .len = sizeof(base_hash)
+        },
+        [4] = { 0 },
+    };
+    CborEncoder *penc = &cb->encoder;
+    CborEncoder rsp;
+    CborError g_err = CborNoError;
+    int rc;
+
+    rc = cbor_read_object(&cb->it, off_attr);
+    if (rc || off == UINT_MAX) {
+        rc = MGMT_ERR_EINVAL;
+        goto err;
+    }
+
+    if (off == 0) {
+        if (hash_len != IMGMGR_HASH_LEN || size == UINT_MAX) {
+            rc = MGMT_ERR_EINVAL;
+            goto err;
+        }
+        rc = imgr_delta_start(base_hash, size);
+        if (rc) {
+            goto err_close;
+        }
+    } else if (off != imgr_state.upload.off) {
+        /*
+         * Patch must be applied in order.  Drop the data, and respond with
+         * the offset we're expecting.
+         */
+        goto out;
+    }
+
+    if (!imgr_state.upload.fa || !imgr_delta.base) {
+        rc = MGMT_ERR_EINVAL;
+        goto err;
+    }
+    if (data.len > imgr_state.upload.size - imgr_state.upload.off) {
+        rc = MGMT_ERR_EINVAL;
+        goto err_close;
+    }
+    if (data.len) {
+        /* The patch is applied as it sits in the request. */
+        for (i = 0; i < data.len; i += len) {
+            ptr = cbor_bytes_ref_ptr(&data, i, &len);
+            if (ptr == NULL) {
+                rc = MGMT_ERR_EINVAL;
+                goto err_close;
+            }
+            rc = imgr_delta_apply(ptr, len);
+            if (rc) {
+                goto err_close;
+            }
+        }
+        imgr_state.upload.off += data.len;
+        if (imgr_state.upload.size == imgr_state.upload.off) {
+            /* Done */
+            rc = imgr_delta_finish();
+            if (rc) {
+                goto err_close;
+            }
+            imgr_delta_close();
+        }
+    }
+
+out:
+    g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rsp, "rc");
+    g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&rsp, "off");
+    g_err |= cbor_encode_int(&rsp, imgr_state.upload.off);
+    g_err |= cbor_encoder_close_container(penc, &rsp);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+err_close:
+    imgr_delta_close();
+err:
+    mgmt_cbuf_setoerr(cb, rc);
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(IMGMGR_DELTA) */
@@ -118,12 +118,36 @@ err:
     return 0;
 }
 
+/*
+ * Appends a byte string from the request to the file being uploaded,
+ * straight out of the request buffer.
+ */
+static int
+imgr_file_write(const struct cbor_bytes_ref *data)
+{
+    const uint8_t *ptr;
+    size_t len;
+    size_t i;
+    int rc;
+
+    for (i = 0; i < data->len; i += len) {
+        ptr = cbor_bytes_ref_ptr(data, i, &len);
+        if (ptr == NULL) {
+            return MGMT_ERR_EINVAL;
+        }
+        rc = fs_write(imgr_state.upload.file, ptr, len);
+        if (rc) {
+            return MGMT_ERR_EINVAL;
+        }
+    }
+    return 0;
+}
+
 int
 imgr_file_upload(struct mgmt_cbuf *cb)
 {
-    uint8_t img_data[IMGMGR_NMGR_MAX_MSG];
+    struct cbor_bytes_ref img_data;
     char file_name[IMGMGR_NMGR_MAX_NAME + 1];
-    size_t img_len;
     long long unsigned int off = UINT_MAX;
     long long unsigned int size = UINT_MAX;
     const struct cbor_attr_t off_attr[5] = {
@@ -135,10 +159,8 @@ imgr_file_upload(struct mgmt_cbuf *cb)
         },
         [1] = {
             .attribute = "data",
-            .type = CborAttrByteStringType,
-            .addr.bytestring.data = img_data,
-            .addr.bytestring.len = &img_len,
-            .len = sizeof(img_data)
+            .type = CborAttrByteStringRefType,
+            .addr.bytesref = &img_data
         },
         [2] = {
             .attribute = "len",
@@ -198,13 +220,12 @@ imgr_file_upload(struct mgmt_cbuf *cb)
         rc = MGMT_ERR_EINVAL;
         goto err;
     }
-    if (img_len) {
-        rc = fs_write(imgr_state.upload.file, img_data, img_len);
+    if (img_data.len) {
+        rc = imgr_file_write(&img_data);
         if (rc) {
-            rc = MGMT_ERR_EINVAL;
             goto err_close;
         }
-        imgr_state.upload.off += img_len;
+        imgr_state.upload.off += img_data.len;
         if (imgr_state.upload.size == imgr_state.upload.off) {
             /* Done */
             fs_close(imgr_state.upload.file);
@@ -20,8 +20,12 @@
 #ifndef __IMGMGR_PRIV_H_
 #define __IMGMGR_PRIV_H_
 
+#include <stddef.h>
 #include <stdint.h>
 #include "syscfg/syscfg.h"
+#if MYNEWT_VAL(IMGMGR_UPLOAD_HASH)
+#include "mbedtls/sha256.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -74,6 +78,15 @@ struct imgmgr_upload_cmd {
  * }
  *
  *
+ * Request to delta image upload:
+ * {
+ *      "off":<offset within patch>,
+ *      "len":<patch_size>		inspected when off = 0
+ *      "base":<hash of base image>	inspected when off = 0
+ *      "data":<patch data>
+ * }
+ *
+ *
  * Request to image upload:
  * {
  *      "off":<offset>
@@ -86,13 +99,22 @@ struct imgmgr_upload_cmd {
 struct nmgr_hdr;
 struct os_mbuf;
 struct fs_file;
+struct flash_area;
 struct mgmt_cbuf;
+struct cbor_bytes_ref;
 
 struct imgr_state {
     struct {
         uint32_t off;
         uint32_t size;
         const struct flash_area *fa;
+#if MYNEWT_VAL(IMGMGR_UPLOAD_HASH)
+        /* Running hash of the image header and body, as received. */
+        mbedtls_sha256_context sha;
+        uint32_t hash_sz;
+        uint8_t hash_ok;
+        uint8_t slot;
+#endif
 #if MYNEWT_VAL(IMGMGR_FS)
         struct fs_file *file;
 #endif
@@ -117,6 +139,25 @@ int imgmgr_state_write(struct mgmt_cbuf *njb);
 int imgr_find_by_ver(struct image_version *find, uint8_t *hash);
 int imgr_find_by_hash(uint8_t *find, struct image_version *ver);
 int imgr_cli_register(void);
+int imgr_upload_slot(void);
+int imgr_delta_upload(struct mgmt_cbuf *);
+void imgr_info_invalidate(const struct flash_area *fa);
+int imgr_bytes_write(const struct flash_area *fa, uint32_t off,
+                     const struct cbor_bytes_ref *data);
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+int imgr_upload_win_init(void);
+void imgr_upload_win_start(void);
+int imgr_upload_win_rx(uint32_t off, const struct cbor_bytes_ref *data);
+int imgr_upload_win_drain(void);
+#endif
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+int imgr_delta_open(int base_slot, int slot, uint32_t size);
+int imgr_delta_apply(const uint8_t *data, uint32_t len);
+int imgr_delta_finish(void);
+void imgr_delta_close(void);
+#endif
 
 #ifdef __cplusplus
 }
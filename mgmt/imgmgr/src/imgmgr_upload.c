@@ -0,0 +1,295 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+
+#include <assert.h>
+#include <string.h>
+
+#include "os/os.h"
+#include "flash_map/flash_map.h"
+#include "cborattr/cborattr.h"
+#include "mgmt/mgmt.h"
+
+#include "imgmgr/imgmgr.h"
+#include "imgmgr_priv.h"
+
+/*
+ * Windowed image upload.
+ *
+ * The client may have up to IMGMGR_UPLOAD_WINDOW chunks outstanding.  Any
+ * chunk which falls within IMGR_WIN_BYTES of the acknowledged offset is
+ * accepted, marked in a bitmap of received bytes, and handed to the writer
+ * task.  The acknowledged offset (imgr_state.upload.off) is the end of the
+ * contiguous run of received data, so a single response acks all chunks
+ * received so far.  Flash writes happen in the writer task, so the newtmgr
+ * task can receive the next chunk while the previous one is programmed.
+ */
+
+#define IMGR_WIN_BYTES                                                  \
+    (MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) * IMGMGR_NMGR_MAX_MSG)
+
+struct imgr_upload_buf {
+    struct os_event iub_ev;
+    uint32_t iub_off;
+    uint16_t iub_len;
+    uint8_t iub_data[IMGMGR_NMGR_MAX_MSG];
+};
+
+static struct {
+    /* Bitmap of received bytes, indexed by offset modulo IMGR_WIN_BYTES. */
+    uint8_t bitmap[(IMGR_WIN_BYTES + 7) / 8];
+
+    /* Counts free write buffers. */
+    struct os_sem buf_sem;
+    struct os_mempool buf_pool;
+
+    /* First flash write error of the current upload. */
+    int write_rc;
+} imgr_win;
+
+static os_membuf_t imgr_win_buf_mem[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW),
+                    sizeof(struct imgr_upload_buf))
+];
+
+static struct os_eventq imgr_win_evq;
+static struct os_task imgr_win_task;
+static os_stack_t imgr_win_stack[MYNEWT_VAL(IMGMGR_UPLOAD_TASK_STACK_SIZE)];
+
+static int
+imgr_win_bit_get(uint32_t off)
+{
+    off %= IMGR_WIN_BYTES;
+    return imgr_win.bitmap[off / 8] & (1 << (off % 8));
+}
+
+static void
+imgr_win_bit_set(uint32_t off, int val)
+{
+    off %= IMGR_WIN_BYTES;
+    if (val) {
+        imgr_win.bitmap[off / 8] |= 1 << (off % 8);
+    } else {
+        imgr_win.bitmap[off / 8] &= ~(1 << (off % 8));
+    }
+}
+
+static void
+imgr_win_write_ev(struct os_event *ev)
+{
+    struct imgr_upload_buf *iub;
+    int rc;
+
+    iub = ev->ev_arg;
+
+    if (imgr_win.write_rc == 0 && imgr_state.upload.fa) {
+        rc = flash_area_write(imgr_state.upload.fa, iub->iub_off,
+                              iub->iub_data, iub->iub_len);
+        imgr_info_invalidate(imgr_state.upload.fa);
+        if (rc) {
+            imgr_win.write_rc = MGMT_ERR_EINVAL;
+        }
+    }
+
+    os_memblock_put(&imgr_win.buf_pool, iub);
+    os_sem_release(&imgr_win.buf_sem);
+}
+
+/*
+ * Runs queued writes in the calling task, for when the OS isn't running.
+ *
+ * sysinit() and the rest of main() run before os_start(), and the imgmgr
+ * handlers are plain functions which may be driven from there; the BLE host
+ * and mgmt's group lock make the same allowance.  Until os_start() the
+ * writer task doesn't run, and os_sem_pend() returns OS_NOT_STARTED without
+ * taking a token.  Without this, queued chunks would never be written, and
+ * the write buffers would run out with the semaphore still showing them
+ * free.  The unit tests also run in this state.
+ */
+static void
+imgr_win_run_queued(void)
+{
+    struct os_eventq *evq;
+    struct os_event *ev;
+
+    evq = &imgr_win_evq;
+    while ((ev = os_eventq_poll(&evq, 1, 0)) != NULL) {
+        ev->ev_cb(ev);
+    }
+}
+
+static void
+imgr_win_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&imgr_win_evq);
+    }
+}
+
+/**
+ * Waits until all queued chunks have been written to flash.
+ *
+ * @return 0 if all writes of this upload succeeded, MGMT_ERR_xxx otherwise.
+ */
+int
+imgr_upload_win_drain(void)
+{
+    int i;
+
+    if (!os_started()) {
+        imgr_win_run_queued();
+        return imgr_win.write_rc;
+    }
+
+    /* All buffers are free once every token has been returned. */
+    for (i = 0; i < MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW); i++) {
+        os_sem_pend(&imgr_win.buf_sem, OS_TIMEOUT_NEVER);
+    }
+    for (i = 0; i < MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW); i++) {
+        os_sem_release(&imgr_win.buf_sem);
+    }
+
+    return imgr_win.write_rc;
+}
+
+/**
+ * Resets window state for a new upload.  The first chunk of the new upload
+ * (offset 0) is written synchronously by the caller.
+ */
+void
+imgr_upload_win_start(void)
+{
+    memset(imgr_win.bitmap, 0, sizeof(imgr_win.bitmap));
+    imgr_win.write_rc = 0;
+}
+
+/**
+ * Accepts a chunk of the image being uploaded, and queues it to be written
+ * to flash.  Advances imgr_state.upload.off over contiguous data.
+ *
+ * @param off                   Offset of the chunk within the image.
+ * @param data                  Chunk contents, in the request.
+ *
+ * @return                      0 if the chunk was accepted, or was a
+ *                                  duplicate/out of window and dropped;
+ *                                  MGMT_ERR_xxx on failure.
+ */
+int
+imgr_upload_win_rx(uint32_t off, const struct cbor_bytes_ref *data)
+{
+    struct imgr_upload_buf *iub;
+    size_t len;
+    uint32_t i;
+    int dup;
+
+    if (imgr_win.write_rc) {
+        return imgr_win.write_rc;
+    }
+
+    /* The request is gone by the time the chunk is written; copy it. */
+    len = data->len;
+    if (len > sizeof(iub->iub_data)) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    if (off < imgr_state.upload.off ||
+        off + len > imgr_state.upload.off + IMGR_WIN_BYTES ||
+        off + len > imgr_state.upload.size) {
+        /* Already received, or not yet within the window.  Drop it; the
+         * response carries the offset we're expecting.
+         */
+        return 0;
+    }
+
+    /* Retransmitted chunks are dropped.  Flash is only programmed once. */
+    dup = 0;
+    for (i = off; i < off + len; i++) {
+        if (imgr_win_bit_get(i)) {
+            dup = 1;
+            break;
+        }
+    }
+    if (dup) {
+        return 0;
+    }
+
+    /* Before os_start() the semaphore doesn't count; see
+     * imgr_win_run_queued().
+     */
+    if (!os_started() && imgr_win.buf_pool.mp_num_free == 0) {
+        imgr_win_run_queued();
+    }
+    os_sem_pend(&imgr_win.buf_sem, OS_TIMEOUT_NEVER);
+    iub = os_memblock_get(&imgr_win.buf_pool);
+    assert(iub != NULL);
+
+    if (cbor_bytes_ref_copy(data, 0, iub->iub_data, len)) {
+        os_memblock_put(&imgr_win.buf_pool, iub);
+        os_sem_release(&imgr_win.buf_sem);
+        return MGMT_ERR_EINVAL;
+    }
+    iub->iub_off = off;
+    iub->iub_len = len;
+    /* The free list link overwrites the event; reset it before queueing. */
+    iub->iub_ev.ev_queued = 0;
+    iub->iub_ev.ev_cb = imgr_win_write_ev;
+    iub->iub_ev.ev_arg = iub;
+    os_eventq_put(&imgr_win_evq, &iub->iub_ev);
+
+    for (i = off; i < off + len; i++) {
+        imgr_win_bit_set(i, 1);
+    }
+    while (imgr_state.upload.off < imgr_state.upload.size &&
+           imgr_win_bit_get(imgr_state.upload.off)) {
+        imgr_win_bit_set(imgr_state.upload.off, 0);
+        imgr_state.upload.off++;
+    }
+
+    return 0;
+}
+
+int
+imgr_upload_win_init(void)
+{
+    int rc;
+
+    rc = os_mempool_init(&imgr_win.buf_pool, MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW),
+                         sizeof(struct imgr_upload_buf), imgr_win_buf_mem,
+                         "imgr_upload");
+    if (rc) {
+        return rc;
+    }
+
+    rc = os_sem_init(&imgr_win.buf_sem, MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW));
+    if (rc) {
+        return rc;
+    }
+
+    os_eventq_init(&imgr_win_evq);
+
+    return os_task_init(&imgr_win_task, "imgr_upload", imgr_win_task_handler,
+                        NULL, MYNEWT_VAL(IMGMGR_UPLOAD_TASK_PRIO),
+                        OS_WAIT_FOREVER, imgr_win_stack,
+                        MYNEWT_VAL(IMGMGR_UPLOAD_TASK_STACK_SIZE));
+}
+
+#endif /* MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0 */
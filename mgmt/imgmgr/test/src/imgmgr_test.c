@@ -0,0 +1,214 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cborattr/cborattr.h"
+#include "tinycbor/cbor_buf_reader.h"
+#include "imgmgr_test.h"
+
+TEST_CASE_DECL(imgmgr_upload_win_in_order)
+TEST_CASE_DECL(imgmgr_upload_win_out_of_order)
+TEST_CASE_DECL(imgmgr_upload_win_dup)
+TEST_CASE_DECL(imgmgr_upload_win_refill)
+TEST_CASE_DECL(imgmgr_upload_win_bad_data)
+TEST_CASE_DECL(imgmgr_delta_ops)
+TEST_CASE_DECL(imgmgr_delta_truncated)
+TEST_CASE_DECL(imgmgr_delta_varint)
+TEST_CASE_DECL(imgmgr_delta_after_win)
+
+/*
+ * Contents of the test image at the given offset.
+ */
+uint8_t
+imgmgr_test_byte(uint32_t off)
+{
+    return (uint8_t)(off * 7 + (off >> 8));
+}
+
+/*
+ * Starts a windowed upload of size bytes into the second image slot.
+ */
+void
+imgmgr_test_upload_start(uint32_t size)
+{
+    int rc;
+
+    rc = imgr_upload_win_drain();
+    TEST_ASSERT(rc == 0);
+    imgr_upload_win_start();
+
+    if (imgr_state.upload.fa == NULL) {
+        rc = flash_area_open(FLASH_AREA_IMAGE_1, &imgr_state.upload.fa);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = flash_area_erase(imgr_state.upload.fa, 0, size);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    imgr_state.upload.off = 0;
+    imgr_state.upload.size = size;
+}
+
+/*
+ * Hands len bytes of the test image at off to the upload window, as if
+ * they came in an upload request.
+ */
+int
+imgmgr_test_upload_chunk(uint32_t off, int len)
+{
+    uint8_t buf[IMGMGR_TEST_CHUNK];
+    struct cbor_buf_reader reader;
+    struct cbor_bytes_ref data;
+    int i;
+
+    TEST_ASSERT_FATAL(len <= sizeof(buf));
+    for (i = 0; i < len; i++) {
+        buf[i] = imgmgr_test_byte(off + i);
+    }
+
+    cbor_buf_reader_init(&reader, buf, len);
+    data.reader = &reader.r;
+    data.off = 0;
+    data.len = len;
+
+    return imgr_upload_win_rx(off, &data);
+}
+
+/*
+ * Waits for queued writes, and checks the first len bytes in flash.
+ */
+void
+imgmgr_test_upload_verify(uint32_t len)
+{
+    uint8_t buf[IMGMGR_TEST_CHUNK];
+    uint32_t off;
+    int cnt;
+    int rc;
+    int i;
+
+    rc = imgr_upload_win_drain();
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (off = 0; off < len; off += cnt) {
+        cnt = min(len - off, sizeof(buf));
+        rc = flash_area_read(imgr_state.upload.fa, off, buf, cnt);
+        TEST_ASSERT_FATAL(rc == 0);
+        for (i = 0; i < cnt; i++) {
+            TEST_ASSERT_FATAL(buf[i] == imgmgr_test_byte(off + i),
+                              "mismatch at %u", (unsigned)(off + i));
+        }
+    }
+}
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+/*
+ * Encodes val as LEB128.  Returns the number of bytes written.
+ */
+int
+imgmgr_test_leb128(uint8_t *dst, uint32_t val)
+{
+    int i;
+
+    for (i = 0; val >= 0x80; i++) {
+        dst[i] = (val & 0x7f) | 0x80;
+        val >>= 7;
+    }
+    dst[i++] = val;
+    return i;
+}
+
+/*
+ * Writes a base image made of the test pattern to the first slot, and
+ * starts building a delta image in the second one.
+ */
+void
+imgmgr_test_delta_start(uint32_t patch_len)
+{
+    const struct flash_area *fa;
+    uint8_t buf[IMGMGR_TEST_CHUNK];
+    uint32_t off;
+    int rc;
+    int i;
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fa);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_erase(fa, 0, 4 * 1024);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (off = 0; off < 4 * 1024; off += sizeof(buf)) {
+        for (i = 0; i < sizeof(buf); i++) {
+            buf[i] = imgmgr_test_byte(off + i);
+        }
+        rc = flash_area_write(fa, off, buf, sizeof(buf));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    flash_area_close(fa);
+
+    rc = imgr_delta_open(0, 1, patch_len);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/*
+ * Applies the patch chunk bytes at a time, as if it arrived in that many
+ * requests.
+ */
+int
+imgmgr_test_delta_apply(const uint8_t *patch, int len, int chunk)
+{
+    int off;
+    int rc;
+
+    for (off = 0; off < len; off += chunk) {
+        rc = imgr_delta_apply(patch + off, min(chunk, len - off));
+        if (rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+#endif
+
+TEST_SUITE(imgmgr_test_suite)
+{
+    imgmgr_upload_win_in_order();
+    imgmgr_upload_win_out_of_order();
+    imgmgr_upload_win_dup();
+    imgmgr_upload_win_refill();
+    imgmgr_upload_win_bad_data();
+    imgmgr_delta_ops();
+    imgmgr_delta_truncated();
+    imgmgr_delta_varint();
+    imgmgr_delta_after_win();
+}
+
+int
+imgmgr_test_all(void)
+{
+    imgmgr_test_suite();
+    return tu_any_failed;
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(void)
+{
+    ts_config.ts_print_results = 1;
+    tu_init();
+
+    imgmgr_test_all();
+
+    return tu_any_failed;
+}
+#endif
@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _IMGMGR_TEST_H
+#define _IMGMGR_TEST_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+#include "sysflash/sysflash.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+#include "flash_map/flash_map.h"
+#include "bootutil/image.h"
+#include "mgmt/mgmt.h"
+#include "imgmgr/imgmgr.h"
+
+#include "imgmgr_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMGMGR_TEST_CHUNK       128
+
+uint8_t imgmgr_test_byte(uint32_t off);
+void imgmgr_test_upload_start(uint32_t size);
+int imgmgr_test_upload_chunk(uint32_t off, int len);
+void imgmgr_test_upload_verify(uint32_t len);
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+#define IMGMGR_TEST_DELTA_COPY  0
+#define IMGMGR_TEST_DELTA_DATA  1
+#define IMGMGR_TEST_DELTA_ADD   2
+
+int imgmgr_test_leb128(uint8_t *dst, uint32_t val);
+void imgmgr_test_delta_start(uint32_t patch_len);
+int imgmgr_test_delta_apply(const uint8_t *patch, int len, int chunk);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IMGMGR_TEST_H */
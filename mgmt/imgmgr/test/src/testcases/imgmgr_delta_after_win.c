@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "imgmgr_test.h"
+
+TEST_CASE(imgmgr_delta_after_win)
+{
+    struct image_header hdr;
+    uint8_t patch[64];
+    uint8_t buf[400];
+    int tail;
+    int len;
+    int rc;
+    int i;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.ih_magic = IMAGE_MAGIC;
+    hdr.ih_hdr_size = sizeof(hdr);
+    hdr.ih_img_size = sizeof(buf);
+
+    /* Header, inserted; then the start of the base image. */
+    len = 0;
+    patch[len++] = IMGMGR_TEST_DELTA_DATA;
+    len += imgmgr_test_leb128(patch + len, sizeof(hdr));
+    memcpy(patch + len, &hdr, sizeof(hdr));
+    len += sizeof(hdr);
+    patch[len++] = IMGMGR_TEST_DELTA_COPY;
+    len += imgmgr_test_leb128(patch + len, sizeof(buf));
+    len += imgmgr_test_leb128(patch + len, 0);
+
+    /*
+     * A windowed upload into the same slot, abandoned with writes still
+     * queued.  They're out of order, so nothing has been acked.
+     */
+    imgmgr_test_upload_start(4 * IMGMGR_TEST_CHUNK);
+    for (i = 1; i < 4; i++) {
+        rc = imgmgr_test_upload_chunk(i * IMGMGR_TEST_CHUNK,
+                                      IMGMGR_TEST_CHUNK);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(imgr_state.upload.off == 0);
+
+    imgmgr_test_delta_start(len);
+    rc = imgmgr_test_delta_apply(patch, len, len);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = imgr_delta_finish();
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Nothing of the old upload is left to be written over the image. */
+    rc = imgr_upload_win_drain();
+    TEST_ASSERT(rc == 0);
+
+    rc = flash_area_read(imgr_state.upload.fa, sizeof(hdr), buf,
+                         sizeof(buf));
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < sizeof(buf); i++) {
+        TEST_ASSERT_FATAL(buf[i] == imgmgr_test_byte(i),
+                          "mismatch at %d", i);
+    }
+
+    /* The rest of what the upload covered is still erased. */
+    tail = 4 * IMGMGR_TEST_CHUNK - sizeof(hdr) - sizeof(buf);
+    rc = flash_area_read(imgr_state.upload.fa, sizeof(hdr) + sizeof(buf),
+                         buf, tail);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < tail; i++) {
+        TEST_ASSERT(buf[i] == 0xff);
+    }
+    imgr_delta_close();
+}
@@ -0,0 +1,87 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "imgmgr_test.h"
+
+TEST_CASE(imgmgr_delta_ops)
+{
+    const struct flash_area *fa;
+    struct image_header hdr;
+    uint8_t patch[512];
+    uint8_t buf[300];
+    int chunk;
+    int len;
+    int rc;
+    int i;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.ih_magic = IMAGE_MAGIC;
+    hdr.ih_hdr_size = sizeof(hdr);
+    hdr.ih_img_size = 300;
+
+    /*
+     * Header, inserted; 100 bytes copied from base offset 32; 50 literal
+     * bytes; 150 bytes copied from where the copy left off, plus one.
+     */
+    len = 0;
+    patch[len++] = IMGMGR_TEST_DELTA_DATA;
+    len += imgmgr_test_leb128(patch + len, sizeof(hdr));
+    memcpy(patch + len, &hdr, sizeof(hdr));
+    len += sizeof(hdr);
+
+    patch[len++] = IMGMGR_TEST_DELTA_COPY;
+    len += imgmgr_test_leb128(patch + len, 100);
+    len += imgmgr_test_leb128(patch + len, 32 << 1);
+
+    patch[len++] = IMGMGR_TEST_DELTA_DATA;
+    len += imgmgr_test_leb128(patch + len, 50);
+    for (i = 0; i < 50; i++) {
+        patch[len++] = 0xc0 + i;
+    }
+
+    patch[len++] = IMGMGR_TEST_DELTA_ADD;
+    len += imgmgr_test_leb128(patch + len, 150);
+    len += imgmgr_test_leb128(patch + len, 0);
+    for (i = 0; i < 150; i++) {
+        patch[len++] = 1;
+    }
+
+    /* Whole, and split at every possible point along the way. */
+    for (chunk = len; chunk >= 1; chunk = chunk > 7 ? 7 : chunk - 6) {
+        imgmgr_test_delta_start(len);
+        rc = imgmgr_test_delta_apply(patch, len, chunk);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = imgr_delta_finish();
+        TEST_ASSERT_FATAL(rc == 0);
+
+        fa = imgr_state.upload.fa;
+        rc = flash_area_read(fa, sizeof(hdr), buf, sizeof(buf));
+        TEST_ASSERT_FATAL(rc == 0);
+        for (i = 0; i < 100; i++) {
+            TEST_ASSERT(buf[i] == imgmgr_test_byte(32 + i));
+        }
+        for (i = 0; i < 50; i++) {
+            TEST_ASSERT(buf[100 + i] == 0xc0 + i);
+        }
+        for (i = 0; i < 150; i++) {
+            TEST_ASSERT(buf[150 + i] ==
+                        (uint8_t)(imgmgr_test_byte(132 + i) + 1));
+        }
+        imgr_delta_close();
+    }
+}
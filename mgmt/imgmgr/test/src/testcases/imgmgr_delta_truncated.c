@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "imgmgr_test.h"
+
+TEST_CASE(imgmgr_delta_truncated)
+{
+    struct image_header hdr;
+    uint8_t patch[64];
+    int len;
+    int rc;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.ih_magic = IMAGE_MAGIC;
+    hdr.ih_hdr_size = sizeof(hdr);
+
+    len = 0;
+    patch[len++] = IMGMGR_TEST_DELTA_DATA;
+    len += imgmgr_test_leb128(patch + len, sizeof(hdr));
+    memcpy(patch + len, &hdr, sizeof(hdr));
+    len += sizeof(hdr);
+    patch[len++] = IMGMGR_TEST_DELTA_COPY;
+    len += imgmgr_test_leb128(patch + len, 300);
+
+    /* Ends in the middle of literal data. */
+    imgmgr_test_delta_start(20);
+    rc = imgmgr_test_delta_apply(patch, 20, 20);
+    TEST_ASSERT(rc == 0);
+    rc = imgr_delta_finish();
+    TEST_ASSERT(rc == MGMT_ERR_EINVAL);
+    imgr_delta_close();
+
+    /* Ends in the middle of a LEB128 argument. */
+    imgmgr_test_delta_start(len - 1);
+    rc = imgmgr_test_delta_apply(patch, len - 1, 5);
+    TEST_ASSERT(rc == 0);
+    rc = imgr_delta_finish();
+    TEST_ASSERT(rc == MGMT_ERR_EINVAL);
+    imgr_delta_close();
+
+    /* Ends after a COPY length, without the source offset. */
+    imgmgr_test_delta_start(len);
+    rc = imgmgr_test_delta_apply(patch, len, len);
+    TEST_ASSERT(rc == 0);
+    rc = imgr_delta_finish();
+    TEST_ASSERT(rc == MGMT_ERR_EINVAL);
+    imgr_delta_close();
+
+    /* Complete, but too short to hold the image it describes. */
+    hdr.ih_img_size = 100;
+    memcpy(patch + 2, &hdr, sizeof(hdr));
+    imgmgr_test_delta_start(2 + sizeof(hdr));
+    rc = imgmgr_test_delta_apply(patch, 2 + sizeof(hdr), 7);
+    TEST_ASSERT(rc == 0);
+    rc = imgr_delta_finish();
+    TEST_ASSERT(rc == MGMT_ERR_EINVAL);
+    imgr_delta_close();
+}
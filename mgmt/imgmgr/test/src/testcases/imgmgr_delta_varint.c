@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "imgmgr_test.h"
+
+TEST_CASE(imgmgr_delta_varint)
+{
+    /* 5 byte encoding of 0xffffffff; the largest length that fits. */
+    static const uint8_t max_len[] = {
+        IMGMGR_TEST_DELTA_DATA, 0xff, 0xff, 0xff, 0xff, 0x0f
+    };
+    /* Non-minimal 5 byte encoding of 1, followed by the data byte. */
+    static const uint8_t padded_len[] = {
+        IMGMGR_TEST_DELTA_DATA, 0x81, 0x80, 0x80, 0x80, 0x00, 0xaa
+    };
+    /* 33 bits. */
+    static const uint8_t too_big[] = {
+        IMGMGR_TEST_DELTA_DATA, 0xff, 0xff, 0xff, 0xff, 0x1f
+    };
+    /* 6 bytes. */
+    static const uint8_t too_long[] = {
+        IMGMGR_TEST_DELTA_DATA, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00
+    };
+    int rc;
+
+    imgmgr_test_delta_start(sizeof(max_len));
+    rc = imgmgr_test_delta_apply(max_len, sizeof(max_len), 1);
+    TEST_ASSERT(rc == 0);
+    imgr_delta_close();
+
+    imgmgr_test_delta_start(sizeof(padded_len));
+    rc = imgmgr_test_delta_apply(padded_len, sizeof(padded_len), 1);
+    TEST_ASSERT(rc == 0);
+    imgr_delta_close();
+
+    imgmgr_test_delta_start(sizeof(too_big));
+    rc = imgmgr_test_delta_apply(too_big, sizeof(too_big), 1);
+    TEST_ASSERT(rc == MGMT_ERR_EINVAL);
+    imgr_delta_close();
+
+    imgmgr_test_delta_start(sizeof(too_long));
+    rc = imgmgr_test_delta_apply(too_long, sizeof(too_long),
+                                 sizeof(too_long));
+    TEST_ASSERT(rc == MGMT_ERR_EINVAL);
+    imgr_delta_close();
+}
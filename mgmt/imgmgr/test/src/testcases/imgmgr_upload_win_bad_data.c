@@ -0,0 +1,58 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cborattr/cborattr.h"
+#include "tinycbor/cbor_buf_reader.h"
+#include "imgmgr_test.h"
+
+TEST_CASE(imgmgr_upload_win_bad_data)
+{
+    uint8_t buf[IMGMGR_TEST_CHUNK];
+    struct cbor_buf_reader reader;
+    struct cbor_bytes_ref data;
+    int rc;
+    int i;
+
+    imgmgr_test_upload_start(2 * IMGMGR_TEST_CHUNK);
+
+    /*
+     * A chunk claiming more bytes than the request holds.  Rejected, and
+     * nothing of it is marked as received; more of them than there are
+     * write buffers don't leak any.
+     */
+    memset(buf, 0, sizeof(buf));
+    cbor_buf_reader_init(&reader, buf, IMGMGR_TEST_CHUNK / 2);
+    data.reader = &reader.r;
+    data.off = 0;
+    data.len = IMGMGR_TEST_CHUNK;
+    for (i = 0; i <= MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW); i++) {
+        rc = imgr_upload_win_rx(0, &data);
+        TEST_ASSERT(rc == MGMT_ERR_EINVAL);
+        TEST_ASSERT(imgr_state.upload.off == 0);
+    }
+
+    /* The real chunk isn't taken for a duplicate. */
+    rc = imgmgr_test_upload_chunk(0, IMGMGR_TEST_CHUNK);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_state.upload.off == IMGMGR_TEST_CHUNK);
+    rc = imgmgr_test_upload_chunk(IMGMGR_TEST_CHUNK, IMGMGR_TEST_CHUNK);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_state.upload.off == 2 * IMGMGR_TEST_CHUNK);
+
+    imgmgr_test_upload_verify(2 * IMGMGR_TEST_CHUNK);
+}
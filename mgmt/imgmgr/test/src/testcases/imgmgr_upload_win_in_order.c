@@ -0,0 +1,37 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "imgmgr_test.h"
+
+TEST_CASE(imgmgr_upload_win_in_order)
+{
+    uint32_t off;
+    int len;
+    int rc;
+
+    imgmgr_test_upload_start(1000);
+
+    for (off = 0; off < 1000; off += len) {
+        len = min(1000 - off, IMGMGR_TEST_CHUNK);
+        rc = imgmgr_test_upload_chunk(off, len);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(imgr_state.upload.off == off + len);
+    }
+
+    imgmgr_test_upload_verify(1000);
+}
@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "imgmgr_test.h"
+
+TEST_CASE(imgmgr_upload_win_out_of_order)
+{
+    uint32_t win_bytes;
+    int rc;
+
+    win_bytes = MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) * IMGMGR_NMGR_MAX_MSG;
+    imgmgr_test_upload_start(win_bytes + 4 * IMGMGR_TEST_CHUNK);
+
+    /* Nothing is acked until the gap at the start is filled. */
+    rc = imgmgr_test_upload_chunk(1 * IMGMGR_TEST_CHUNK, IMGMGR_TEST_CHUNK);
+    TEST_ASSERT(rc == 0);
+    rc = imgmgr_test_upload_chunk(3 * IMGMGR_TEST_CHUNK, IMGMGR_TEST_CHUNK);
+    TEST_ASSERT(rc == 0);
+    rc = imgmgr_test_upload_chunk(2 * IMGMGR_TEST_CHUNK, IMGMGR_TEST_CHUNK);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_state.upload.off == 0);
+
+    /* A chunk past the end of the window is dropped. */
+    rc = imgmgr_test_upload_chunk(win_bytes, IMGMGR_TEST_CHUNK);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_state.upload.off == 0);
+
+    /* Filling the gap acks everything received so far. */
+    rc = imgmgr_test_upload_chunk(0, IMGMGR_TEST_CHUNK);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_state.upload.off == 4 * IMGMGR_TEST_CHUNK);
+
+    imgmgr_test_upload_verify(4 * IMGMGR_TEST_CHUNK);
+}
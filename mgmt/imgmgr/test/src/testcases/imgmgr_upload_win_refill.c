@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "imgmgr_test.h"
+
+#define IMGMGR_TEST_REFILL_CHUNKS                                       \
+    (2 * MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) * IMGMGR_NMGR_MAX_MSG /       \
+     IMGMGR_TEST_CHUNK)
+
+TEST_CASE(imgmgr_upload_win_refill)
+{
+    uint32_t win_bytes;
+    uint32_t size;
+    uint32_t off;
+    int fit;
+    int rc;
+    int i;
+
+    win_bytes = MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) * IMGMGR_NMGR_MAX_MSG;
+    fit = win_bytes / IMGMGR_TEST_CHUNK;
+    size = IMGMGR_TEST_REFILL_CHUNKS * IMGMGR_TEST_CHUNK;
+    imgmgr_test_upload_start(size);
+
+    /*
+     * Everything but the first chunk, up to one chunk past the end of the
+     * window.  More chunks than there are write buffers.
+     */
+    for (i = 1; i <= fit; i++) {
+        rc = imgmgr_test_upload_chunk(i * IMGMGR_TEST_CHUNK,
+                                      IMGMGR_TEST_CHUNK);
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT(imgr_state.upload.off == 0);
+
+    /* The first chunk slides the window over all of them. */
+    rc = imgmgr_test_upload_chunk(0, IMGMGR_TEST_CHUNK);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_state.upload.off == fit * IMGMGR_TEST_CHUNK);
+
+    /* The chunk dropped earlier fits now; so does the rest of the image. */
+    for (off = fit * IMGMGR_TEST_CHUNK; off < size;
+         off += IMGMGR_TEST_CHUNK) {
+        rc = imgmgr_test_upload_chunk(off, IMGMGR_TEST_CHUNK);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(imgr_state.upload.off == off + IMGMGR_TEST_CHUNK);
+    }
+
+    imgmgr_test_upload_verify(size);
+}
@@ -33,6 +33,13 @@ extern "C" {
 #define NMGR_OP_WRITE           (2)
 #define NMGR_OP_WRITE_RSP       (3)
 
+/*
+ * Response was streamed out before its length was known (NEWTMGR_STREAM_LEN).
+ * nh_len is 0, and the payload is a single CBOR item, which may span many
+ * fragments.
+ */
+#define NMGR_F_STREAM           (0x01)
+
 struct nmgr_hdr {
     uint8_t  nh_op;             /* NMGR_OP_XXX */
     uint8_t  nh_flags;
@@ -51,6 +58,8 @@ struct nmgr_transport {
     struct os_mqueue nt_imq;
     nmgr_transport_out_func_t nt_output;
     nmgr_transport_get_mtu_func_t nt_get_mtu;
+    SLIST_ENTRY(nmgr_transport) nt_next;
+    uint8_t nt_busy;        /* A newtmgr worker is handling a request. */
 };
 
 void nmgr_event_put(struct os_event *ev);
@@ -18,12 +18,15 @@
  */
 
 #include <assert.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "syscfg/syscfg.h"
 #include "sysinit/sysinit.h"
 #include "os/os.h"
 #include "os/endian.h"
+#include "os/os_cputime.h"
+#include "stats/stats.h"
 
 #include "mgmt/mgmt.h"
 
@@ -37,15 +40,68 @@
 /* Shared queue that newtmgr uses for work items. */
 struct os_eventq *nmgr_evq;
 
+/* Time spent in request handlers, in cputime ticks. */
+STATS_HIST_SECT(nmgr_req_time, 24)
+STATS_SECT_DECL(nmgr_req_time) nmgr_req_time;
+
+STATS_RATE_SECT(nmgr_req_rate)
+STATS_SECT_DECL(nmgr_req_rate) nmgr_req_rate;
+
 /*
  * cbor buffer for newtmgr
  */
-static struct nmgr_cbuf {
+struct nmgr_cbuf {
     struct mgmt_cbuf n_b;
     struct CborMbufWriter writer;
     struct CborMbufReader reader;
     struct os_mbuf *n_out_m;
-} nmgr_task_cbuf;
+#if MYNEWT_VAL(NEWTMGR_STREAM_LEN) > 0
+    struct nmgr_transport *n_nt;
+    struct nmgr_hdr *n_hdr;     /* Header of the response being encoded. */
+    uint32_t n_flushed;         /* Bytes of the packet already sent out. */
+    uint16_t n_mtu;
+    uint8_t n_streamed;         /* n_hdr has been sent out. */
+#endif
+};
+
+#define NMGR_CBUF_FROM_WRITER(w)                                        \
+    ((struct nmgr_cbuf *)((uint8_t *)(w) - offsetof(struct nmgr_cbuf, writer)))
+
+#if MYNEWT_VAL(NEWTMGR_WORKERS) > 0
+/*
+ * Requests are handled by a pool of worker tasks, so that a slow handler
+ * doesn't hold up the others.  Requests which came in over the same
+ * transport are handled one at a time, so that their responses go out in
+ * order, and fragments of different responses don't get mixed up.
+ */
+struct nmgr_worker {
+    struct os_task nw_task;
+    struct nmgr_cbuf nw_cbuf;
+};
+
+/*
+ * Handlers of a group share state, so requests of the same group are
+ * serialized.  A worker waits for at most one group at a time, so one lock
+ * per worker is enough; a lock is bound to a group while some worker holds
+ * or waits for it.
+ */
+struct nmgr_group_lock {
+    struct os_mutex ngl_mtx;
+    uint16_t ngl_group;
+    uint8_t ngl_users;
+};
+
+static struct nmgr_worker nmgr_workers[MYNEWT_VAL(NEWTMGR_WORKERS)];
+static os_stack_t nmgr_worker_stacks[MYNEWT_VAL(NEWTMGR_WORKERS)]
+                                    [MYNEWT_VAL(NEWTMGR_WORKER_STACK_SIZE)];
+
+/* Counts requests queued on all transports. */
+static struct os_sem nmgr_work_sem;
+static SLIST_HEAD(, nmgr_transport) nmgr_transports;
+static struct nmgr_group_lock nmgr_group_locks[MYNEWT_VAL(NEWTMGR_WORKERS)];
+#else
+static struct nmgr_cbuf nmgr_task_cbuf;
+#endif
 
 struct os_eventq *
 mgmt_evq_get(void)
@@ -67,8 +123,124 @@ nmgr_cbuf_init(struct nmgr_cbuf *njb)
     return (0);
 }
 
+#if MYNEWT_VAL(NEWTMGR_WORKERS) > 0
+static struct nmgr_group_lock *
+nmgr_group_lock_find(uint16_t group)
+{
+    struct nmgr_group_lock *unused;
+    struct nmgr_group_lock *ngl;
+    int i;
+
+    unused = NULL;
+    for (i = 0; i < MYNEWT_VAL(NEWTMGR_WORKERS); i++) {
+        ngl = &nmgr_group_locks[i];
+        if (ngl->ngl_users == 0) {
+            if (!unused) {
+                unused = ngl;
+            }
+        } else if (ngl->ngl_group == group) {
+            return ngl;
+        }
+    }
+    return unused;
+}
+#endif
+
+static void
+nmgr_group_lock(uint16_t group)
+{
+#if MYNEWT_VAL(NEWTMGR_WORKERS) > 0
+    struct nmgr_group_lock *ngl;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    ngl = nmgr_group_lock_find(group);
+    assert(ngl != NULL);
+    ngl->ngl_group = group;
+    ngl->ngl_users++;
+    OS_EXIT_CRITICAL(sr);
+
+    os_mutex_pend(&ngl->ngl_mtx, OS_TIMEOUT_NEVER);
+#endif
+}
+
+static void
+nmgr_group_unlock(uint16_t group)
+{
+#if MYNEWT_VAL(NEWTMGR_WORKERS) > 0
+    struct nmgr_group_lock *ngl;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    ngl = nmgr_group_lock_find(group);
+    OS_EXIT_CRITICAL(sr);
+    assert(ngl != NULL && ngl->ngl_users > 0);
+
+    os_mutex_release(&ngl->ngl_mtx);
+
+    OS_ENTER_CRITICAL(sr);
+    ngl->ngl_users--;
+    OS_EXIT_CRITICAL(sr);
+#endif
+}
+
+static struct os_mbuf *nmgr_rsp_split(struct os_mbuf *rsp, uint16_t len);
+
+#if MYNEWT_VAL(NEWTMGR_STREAM_LEN) > 0
+/*
+ * cbor writer which sends the response out in MTU sized fragments once
+ * more than NEWTMGR_STREAM_LEN bytes are queued, so that big responses
+ * don't have to be held in RAM.  The response header was sent out before
+ * its length was known, so it gets NMGR_F_STREAM instead; the client finds
+ * the end of the response by parsing the CBOR item.
+ */
+static int
+nmgr_stream_write(struct cbor_encoder_writer *w, const char *data, int len)
+{
+    struct nmgr_cbuf *cb;
+    struct os_mbuf *rest;
+    int rc;
+
+    rc = cbor_mbuf_writer(w, data, len);
+    if (rc) {
+        return rc;
+    }
+
+    cb = NMGR_CBUF_FROM_WRITER(w);
+    if (OS_MBUF_PKTLEN(cb->writer.m) <= MYNEWT_VAL(NEWTMGR_STREAM_LEN)) {
+        return CborNoError;
+    }
+    while (OS_MBUF_PKTLEN(cb->writer.m) > cb->n_mtu) {
+        if (!cb->n_streamed) {
+            cb->n_hdr->nh_flags |= NMGR_F_STREAM;
+            cb->n_streamed = 1;
+        }
+        rest = nmgr_rsp_split(cb->writer.m, cb->n_mtu);
+        if (!rest) {
+            return CborErrorOutOfMemory;
+        }
+        cb->n_nt->nt_output(cb->n_nt, cb->writer.m);
+        cb->n_flushed += cb->n_mtu;
+        cb->writer.m = rest;
+        cb->n_out_m = rest;
+    }
+    return CborNoError;
+}
+#endif
+
+/* Offset of the end of the response within the packet being sent. */
+static uint32_t
+nmgr_rsp_off(struct nmgr_cbuf *cb, struct os_mbuf *rsp)
+{
+#if MYNEWT_VAL(NEWTMGR_STREAM_LEN) > 0
+    return cb->n_flushed + OS_MBUF_PKTLEN(rsp);
+#else
+    return OS_MBUF_PKTLEN(rsp);
+#endif
+}
+
 static struct nmgr_hdr *
-nmgr_init_rsp(struct os_mbuf *m, struct nmgr_hdr *src)
+nmgr_init_rsp(struct nmgr_cbuf *cb, struct os_mbuf *m, struct nmgr_hdr *src)
 {
     struct nmgr_hdr *hdr;
 
@@ -86,203 +258,377 @@ nmgr_init_rsp(struct os_mbuf *m, struct nmgr_hdr *src)
     hdr->nh_id = src->nh_id;
 
     /* setup state for cbor encoding */
-    cbor_mbuf_writer_init(&nmgr_task_cbuf.writer, m);
-    cbor_encoder_init(&nmgr_task_cbuf.n_b.encoder, &nmgr_task_cbuf.writer.enc, 0);
-    nmgr_task_cbuf.n_out_m = m;
+    cbor_mbuf_writer_init(&cb->writer, m);
+#if MYNEWT_VAL(NEWTMGR_STREAM_LEN) > 0
+    cb->writer.enc.write = nmgr_stream_write;
+    cb->n_hdr = hdr;
+    cb->n_streamed = 0;
+#endif
+    cbor_encoder_init(&cb->n_b.encoder, &cb->writer.enc, 0);
+    cb->n_out_m = m;
     return hdr;
 }
 
 static void
-nmgr_send_err_rsp(struct nmgr_transport *nt, struct os_mbuf *m,
-  struct nmgr_hdr *hdr, int rc)
+nmgr_send_err_rsp(struct nmgr_cbuf *cb, struct nmgr_transport *nt,
+                  struct os_mbuf *m, struct nmgr_hdr *hdr, int rc)
 {
-    hdr = nmgr_init_rsp(m, hdr);
+    hdr = nmgr_init_rsp(cb, m, hdr);
     if (!hdr) {
+        os_mbuf_free_chain(m);
         return;
     }
+#if MYNEWT_VAL(NEWTMGR_STREAM_LEN) > 0
+    /* Error responses are tiny, never stream them. */
+    cb->writer.enc.write = cbor_mbuf_writer;
+#endif
 
-    mgmt_cbuf_setoerr(&nmgr_task_cbuf.n_b, rc);
-    hdr->nh_len +=
-        cbor_encode_bytes_written(&nmgr_task_cbuf.n_b.encoder);
+    mgmt_cbuf_setoerr(&cb->n_b, rc);
+    hdr->nh_len += cbor_encode_bytes_written(&cb->n_b.encoder);
 
     hdr->nh_len = htons(hdr->nh_len);
     hdr->nh_flags = 0;
-    nt->nt_output(nt, nmgr_task_cbuf.n_out_m);
+    nt->nt_output(nt, cb->n_out_m);
 }
 
-static int
-nmgr_send_rspfrag(struct nmgr_transport *nt, struct os_mbuf *rsp,
-                  struct os_mbuf *req, uint16_t len)
+/*
+ * Splits the response after its first len bytes.  rsp keeps those, and the
+ * rest is returned as a packet of its own.  Only the part of the mbuf which
+ * straddles the split point is copied; the mbufs after it are moved over
+ * to the new packet.
+ */
+static struct os_mbuf *
+nmgr_rsp_split(struct os_mbuf *rsp, uint16_t len)
 {
-    struct os_mbuf *rspfrag;
-    int rc;
+    struct os_mbuf *rest;
+    struct os_mbuf *next;
+    struct os_mbuf *m;
+    uint16_t pktlen;
+    uint16_t off;
 
-    rspfrag = NULL;
+    pktlen = OS_MBUF_PKTLEN(rsp);
 
-    rspfrag = os_msys_get_pkthdr(len, OS_MBUF_USRHDR_LEN(req));
-    if (!rspfrag) {
-        rc = MGMT_ERR_ENOMEM;
-        goto err;
+    rest = os_msys_get_pkthdr(0, OS_MBUF_USRHDR_LEN(rsp));
+    if (!rest) {
+        return NULL;
+    }
+    memcpy(OS_MBUF_USRHDR(rest), OS_MBUF_USRHDR(rsp),
+           OS_MBUF_USRHDR_LEN(rsp));
+
+    m = rsp;
+    off = len;
+    while (off > m->om_len) {
+        off -= m->om_len;
+        m = SLIST_NEXT(m, om_next);
+    }
+    if (off < m->om_len) {
+        if (os_mbuf_append(rest, m->om_data + off, m->om_len - off)) {
+            os_mbuf_free_chain(rest);
+            return NULL;
+        }
+        m->om_len = off;
     }
 
-    /* Copy the request packet header into the response. */
-    memcpy(OS_MBUF_USRHDR(rspfrag), OS_MBUF_USRHDR(req),
-           OS_MBUF_USRHDR_LEN(req));
-
-    if (os_mbuf_appendfrom(rspfrag, rsp, 0, len)) {
-        rc = MGMT_ERR_ENOMEM;
-        goto err;
+    next = SLIST_NEXT(m, om_next);
+    SLIST_NEXT(m, om_next) = NULL;
+    if (next) {
+        os_mbuf_concat(rest, next);
     }
+    OS_MBUF_PKTHDR(rsp)->omp_len = len;
+    assert(OS_MBUF_PKTLEN(rest) == pktlen - len);
 
-    nt->nt_output(nt, rspfrag);
+    return rest;
+}
 
-    return MGMT_ERR_EOK;
-err:
-    if (rspfrag) {
-        os_mbuf_free_chain(rspfrag);
+static int
+nmgr_rsp_fragment(struct nmgr_transport *nt, struct os_mbuf *rsp,
+                  uint16_t mtu)
+{
+    struct os_mbuf *rest;
+
+    while (OS_MBUF_PKTLEN(rsp) > mtu) {
+        rest = nmgr_rsp_split(rsp, mtu);
+        if (!rest) {
+            os_mbuf_free_chain(rsp);
+            return MGMT_ERR_ENOMEM;
+        }
+        nt->nt_output(nt, rsp);
+        rsp = rest;
     }
-    return rc;
+    nt->nt_output(nt, rsp);
+
+    return MGMT_ERR_EOK;
 }
 
+/*
+ * Runs the request found at offset off of req, and appends the response
+ * to rsp.  A request which fails gets an error response in its place;
+ * only running out of buffers is reported back.
+ */
 static int
-nmgr_rsp_fragment(struct nmgr_transport *nt, struct nmgr_hdr *rsp_hdr,
-                  struct os_mbuf *rsp, struct os_mbuf *req)
+nmgr_handle_one(struct nmgr_cbuf *cb, struct os_mbuf *rsp,
+                struct os_mbuf *req, int off, struct nmgr_hdr *hdr)
 {
-    uint16_t mtu;
-    uint16_t rsplen;
-    uint16_t len ;
+    const struct mgmt_handler *handler;
+    struct nmgr_hdr *rsp_hdr;
+    uint32_t rsp_off;
+    uint16_t group;
+    uint32_t start;
+    uint32_t elapsed;
+    os_sr_t sr;
     int rc;
 
-    len = 0;
+    group = ntohs(hdr->nh_group);
+    rsp_off = nmgr_rsp_off(cb, rsp);
 
-    mtu = nt->nt_get_mtu(req);
+    /* Build response header apriori.  Then pass to the handlers
+     * to fill out the response data, and adjust length & flags.
+     */
+    rsp_hdr = nmgr_init_rsp(cb, rsp, hdr);
+    if (!rsp_hdr) {
+        return MGMT_ERR_ENOMEM;
+    }
 
-    do {
-        len = OS_MBUF_PKTLEN(rsp);
-        if (len >= mtu) {
-            rsplen = mtu;
+    handler = mgmt_find_handler(group, hdr->nh_id);
+    if (!handler) {
+        rc = MGMT_ERR_ENOENT;
+        goto err;
+    }
+
+    cbor_mbuf_reader_init(&cb->reader, req, off + sizeof(*hdr));
+    cbor_parser_init(&cb->reader.r, 0, &cb->n_b.parser, &cb->n_b.it);
+
+    nmgr_group_lock(group);
+    start = os_cputime_get32();
+    if (hdr->nh_op == NMGR_OP_READ) {
+        if (handler->mh_read) {
+            rc = handler->mh_read(&cb->n_b);
         } else {
-            rsplen = len;
+            rc = MGMT_ERR_ENOENT;
         }
-
-        rc = nmgr_send_rspfrag(nt, rsp, req, rsplen);
-        if (rc) {
-            goto err;
+    } else if (hdr->nh_op == NMGR_OP_WRITE) {
+        if (handler->mh_write) {
+            rc = handler->mh_write(&cb->n_b);
+        } else {
+            rc = MGMT_ERR_ENOENT;
         }
+    } else {
+        rc = MGMT_ERR_EINVAL;
+    }
+    elapsed = os_cputime_get32() - start;
+    nmgr_group_unlock(group);
+
+    /* Workers of other groups update the stats too. */
+    OS_ENTER_CRITICAL(sr);
+    STATS_RATE_INC(nmgr_req_rate);
+    STATS_HIST_ADD(nmgr_req_time, elapsed);
+    OS_EXIT_CRITICAL(sr);
+
+#if MYNEWT_VAL(NEWTMGR_STREAM_LEN) > 0
+    /* With streaming, the head of the response moves on. */
+    rsp = cb->n_out_m;
+    if (cb->n_streamed) {
+        if (rc == 0) {
+            return 0;
+        }
+        if (cb->n_flushed > rsp_off) {
+            /*
+             * Part of the response is gone already, there is no way to
+             * report the error.  Drop the rest of it; the client times
+             * out.  Responses before it went out with the first part.
+             */
+            os_mbuf_adj(rsp, -(int)(nmgr_rsp_off(cb, rsp) - cb->n_flushed));
+            return MGMT_ERR_EUNKNOWN;
+        }
+    }
+#endif
+    if (rc != 0) {
+        goto err;
+    }
 
-        os_mbuf_adj(rsp, rsplen);
-
-    } while (OS_MBUF_PKTLEN(rsp));
+    rsp_hdr->nh_len = htons(cbor_encode_bytes_written(&cb->n_b.encoder));
+    return 0;
 
-    return MGMT_ERR_EOK;
 err:
-    return rc;
+    /* Drop whatever the handler encoded before failing. */
+    os_mbuf_adj(rsp, -(int)(nmgr_rsp_off(cb, rsp) - rsp_off));
+    rsp_hdr = nmgr_init_rsp(cb, rsp, hdr);
+    if (!rsp_hdr) {
+        return MGMT_ERR_ENOMEM;
+    }
+    mgmt_cbuf_setoerr(&cb->n_b, rc);
+    rsp_hdr->nh_len = htons(cbor_encode_bytes_written(&cb->n_b.encoder));
+    return 0;
 }
 
+/*
+ * A packet can carry several requests back to back, each padded to a
+ * multiple of 4 bytes.  They are run in order, and all responses go out
+ * in a single response, padded the same way, which is then fragmented to
+ * the transport's MTU.
+ */
 static void
-nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
+nmgr_handle_req(struct nmgr_cbuf *cb, struct nmgr_transport *nt,
+                struct os_mbuf *req)
 {
     struct os_mbuf *rsp;
-    const struct mgmt_handler *handler;
-    struct nmgr_hdr *rsp_hdr;
     struct nmgr_hdr hdr;
-    int off;
+    uint16_t mtu;
     uint16_t len;
+    uint8_t *pad;
+    int padlen;
+    int off;
     int rc;
 
-    rsp_hdr = NULL;
+    mtu = nt->nt_get_mtu(req);
+#if MYNEWT_VAL(NEWTMGR_STREAM_LEN) > 0
+    cb->n_nt = nt;
+    cb->n_mtu = mtu;
+    cb->n_flushed = 0;
+#endif
 
     rsp = os_msys_get_pkthdr(512, OS_MBUF_USRHDR_LEN(req));
     if (!rsp) {
+        /* Reuse the request buffer to report the failure. */
         rc = os_mbuf_copydata(req, 0, sizeof(hdr), &hdr);
         if (rc < 0) {
-            goto err_norsp;
+            os_mbuf_free_chain(req);
+            return;
         }
-        rsp = req;
-        req = NULL;
-        goto err;
+        os_mbuf_adj(req, -(int)OS_MBUF_PKTLEN(req));
+        nmgr_send_err_rsp(cb, nt, req, &hdr, MGMT_ERR_ENOMEM);
+        return;
     }
 
     /* Copy the request packet header into the response. */
     memcpy(OS_MBUF_USRHDR(rsp), OS_MBUF_USRHDR(req), OS_MBUF_USRHDR_LEN(req));
 
     off = 0;
-    len = OS_MBUF_PKTHDR(req)->omp_len;
+    len = OS_MBUF_PKTLEN(req);
 
-    while (off < len) {
+    while (off + sizeof(hdr) <= len) {
         rc = os_mbuf_copydata(req, off, sizeof(hdr), &hdr);
-        if (rc < 0) {
-            rc = MGMT_ERR_EINVAL;
-            goto err_norsp;
-        }
-
+        assert(rc == 0);
         hdr.nh_len = ntohs(hdr.nh_len);
 
-        handler = mgmt_find_handler(ntohs(hdr.nh_group), hdr.nh_id);
-        if (!handler) {
-            rc = MGMT_ERR_ENOENT;
-            goto err;
+        padlen = OS_ALIGN(nmgr_rsp_off(cb, rsp), 4) - nmgr_rsp_off(cb, rsp);
+        if (padlen) {
+            pad = os_mbuf_extend(rsp, padlen);
+            if (!pad) {
+                break;
+            }
+            memset(pad, 0, padlen);
         }
 
-        /* Build response header apriori.  Then pass to the handlers
-         * to fill out the response data, and adjust length & flags.
-         */
-        rsp_hdr = nmgr_init_rsp(rsp, &hdr);
-        if (!rsp_hdr) {
-            rc = MGMT_ERR_ENOMEM;
-            goto err_norsp;
+        cb->n_out_m = rsp;
+        rc = nmgr_handle_one(cb, rsp, req, off, &hdr);
+        /* With streaming, the head of the response moves on. */
+        rsp = cb->n_out_m;
+        if (rc) {
+            /* Send the responses built so far. */
+            break;
         }
+        off += sizeof(hdr) + OS_ALIGN(hdr.nh_len, 4);
+    }
 
-        cbor_mbuf_reader_init(&nmgr_task_cbuf.reader, req, sizeof(hdr));
-        cbor_parser_init(&nmgr_task_cbuf.reader.r, 0,
-                         &nmgr_task_cbuf.n_b.parser, &nmgr_task_cbuf.n_b.it);
+    os_mbuf_free_chain(req);
 
-        if (hdr.nh_op == NMGR_OP_READ) {
-            if (handler->mh_read) {
-                rc = handler->mh_read(&nmgr_task_cbuf.n_b);
-            } else {
-                rc = MGMT_ERR_ENOENT;
-            }
-        } else if (hdr.nh_op == NMGR_OP_WRITE) {
-            if (handler->mh_write) {
-                rc = handler->mh_write(&nmgr_task_cbuf.n_b);
-            } else {
-                rc = MGMT_ERR_ENOENT;
-            }
-        } else {
-            rc = MGMT_ERR_EINVAL;
-        }
+    if (OS_MBUF_PKTLEN(rsp) == 0) {
+        os_mbuf_free_chain(rsp);
+        return;
+    }
+    nmgr_rsp_fragment(nt, rsp, mtu);
+}
 
-        if (rc != 0) {
-            goto err;
+#if MYNEWT_VAL(NEWTMGR_WORKERS) > 0
+/*
+ * Takes a request off a transport which no other worker is serving.
+ */
+static struct os_mbuf *
+nmgr_work_get(struct nmgr_transport **ntp)
+{
+    struct nmgr_transport *nt;
+    struct os_mbuf *m;
+    os_sr_t sr;
+
+    m = NULL;
+    OS_ENTER_CRITICAL(sr);
+    SLIST_FOREACH(nt, &nmgr_transports, nt_next) {
+        if (nt->nt_busy) {
+            continue;
+        }
+        m = os_mqueue_get(&nt->nt_imq);
+        if (m) {
+            nt->nt_busy = 1;
+            *ntp = nt;
+            break;
         }
+    }
+    OS_EXIT_CRITICAL(sr);
 
-        rsp_hdr->nh_len +=
-            cbor_encode_bytes_written(&nmgr_task_cbuf.n_b.encoder);
-        off += sizeof(hdr) + OS_ALIGN(hdr.nh_len, 4);
+    return m;
+}
 
-        rsp_hdr->nh_len = htons(rsp_hdr->nh_len);
-        rc = nmgr_rsp_fragment(nt, rsp_hdr, rsp, req);
-        if (rc) {
-            goto err;
+static void
+nmgr_worker_handler(void *arg)
+{
+    struct nmgr_worker *nw;
+    struct nmgr_transport *nt;
+    struct os_mbuf *m;
+    os_sr_t sr;
+
+    nw = arg;
+    while (1) {
+        os_sem_pend(&nmgr_work_sem, OS_TIMEOUT_NEVER);
+
+        /*
+         * Every token stands for a queued request.  If its transport is
+         * busy, the worker serving it picks the request up.
+         */
+        m = nmgr_work_get(&nt);
+        while (m) {
+            nmgr_handle_req(&nw->nw_cbuf, nt, m);
+
+            OS_ENTER_CRITICAL(sr);
+            m = os_mqueue_get(&nt->nt_imq);
+            if (!m) {
+                nt->nt_busy = 0;
+            }
+            OS_EXIT_CRITICAL(sr);
         }
     }
-
-    os_mbuf_free_chain(rsp);
-    os_mbuf_free_chain(req);
-    return;
-err:
-    OS_MBUF_PKTHDR(rsp)->omp_len = rsp->om_len = 0;
-    nmgr_send_err_rsp(nt, rsp, &hdr, rc);
-    os_mbuf_free_chain(req);
-    return;
-err_norsp:
-    os_mbuf_free_chain(rsp);
-    os_mbuf_free_chain(req);
-    return;
 }
 
+static int
+nmgr_workers_init(void)
+{
+    int rc;
+    int i;
 
+    rc = os_sem_init(&nmgr_work_sem, 0);
+    if (rc != 0) {
+        return rc;
+    }
+    for (i = 0; i < MYNEWT_VAL(NEWTMGR_WORKERS); i++) {
+        rc = os_mutex_init(&nmgr_group_locks[i].ngl_mtx);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    for (i = 0; i < MYNEWT_VAL(NEWTMGR_WORKERS); i++) {
+        nmgr_cbuf_init(&nmgr_workers[i].nw_cbuf);
+        rc = os_task_init(&nmgr_workers[i].nw_task, "newtmgr",
+                          nmgr_worker_handler, &nmgr_workers[i],
+                          MYNEWT_VAL(NEWTMGR_WORKER_PRIO), OS_WAIT_FOREVER,
+                          nmgr_worker_stacks[i],
+                          MYNEWT_VAL(NEWTMGR_WORKER_STACK_SIZE));
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    return 0;
+}
+#else
 static void
 nmgr_process(struct nmgr_transport *nt)
 {
@@ -294,7 +640,7 @@ nmgr_process(struct nmgr_transport *nt)
             break;
         }
 
-        nmgr_handle_req(nt, m);
+        nmgr_handle_req(&nmgr_task_cbuf, nt, m);
     }
 }
 
@@ -303,21 +649,36 @@ nmgr_event_data_in(struct os_event *ev)
 {
     nmgr_process(ev->ev_arg);
 }
+#endif
 
 int
 nmgr_transport_init(struct nmgr_transport *nt,
         nmgr_transport_out_func_t output_func,
         nmgr_transport_get_mtu_func_t get_mtu_func)
 {
+#if MYNEWT_VAL(NEWTMGR_WORKERS) > 0
+    os_sr_t sr;
+#endif
     int rc;
 
     nt->nt_output = output_func;
     nt->nt_get_mtu = get_mtu_func;
 
+#if MYNEWT_VAL(NEWTMGR_WORKERS) > 0
+    rc = os_mqueue_init(&nt->nt_imq, NULL, nt);
+    if (rc != 0) {
+        goto err;
+    }
+    nt->nt_busy = 0;
+    OS_ENTER_CRITICAL(sr);
+    SLIST_INSERT_HEAD(&nmgr_transports, nt, nt_next);
+    OS_EXIT_CRITICAL(sr);
+#else
     rc = os_mqueue_init(&nt->nt_imq, nmgr_event_data_in, nt);
     if (rc != 0) {
         goto err;
     }
+#endif
 
     return (0);
 err:
@@ -340,7 +701,14 @@ nmgr_rx_req(struct nmgr_transport *nt, struct os_mbuf *req)
 {
     int rc;
 
+#if MYNEWT_VAL(NEWTMGR_WORKERS) > 0
+    rc = os_mqueue_put(&nt->nt_imq, NULL, req);
+    if (rc == 0) {
+        os_sem_release(&nmgr_work_sem);
+    }
+#else
     rc = os_mqueue_put(&nt->nt_imq, mgmt_evq_get(), req);
+#endif
     if (rc != 0) {
         os_mbuf_free_chain(req);
     }
@@ -358,7 +726,33 @@ nmgr_task_init(void)
         goto err;
     }
 
+    rc = stats_hist_init(STATS_HDR(nmgr_req_time),
+                         STATS_HIST_CNT(nmgr_req_time));
+    if (rc != 0) {
+        goto err;
+    }
+    rc = stats_register("nmgr_req_time", STATS_HDR(nmgr_req_time));
+    if (rc != 0) {
+        goto err;
+    }
+
+    rc = stats_rate_init(STATS_HDR(nmgr_req_rate));
+    if (rc != 0) {
+        goto err;
+    }
+    rc = stats_register("nmgr_req_rate", STATS_HDR(nmgr_req_rate));
+    if (rc != 0) {
+        goto err;
+    }
+
+#if MYNEWT_VAL(NEWTMGR_WORKERS) > 0
+    rc = nmgr_workers_init();
+    if (rc != 0) {
+        goto err;
+    }
+#else
     nmgr_cbuf_init(&nmgr_task_cbuf);
+#endif
 
     return (0);
 err:
@@ -0,0 +1,287 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cborattr/cborattr.h"
+#include "tinycbor/cbor_buf_writer.h"
+#include "tinycbor/cbor_buf_reader.h"
+#include "newtmgr_test.h"
+
+TEST_CASE_DECL(newtmgr_batch)
+TEST_CASE_DECL(newtmgr_batch_err)
+TEST_CASE_DECL(newtmgr_split)
+TEST_CASE_DECL(newtmgr_stream_err)
+
+uint8_t nmgr_test_out[2048];
+int nmgr_test_out_len;
+int nmgr_test_frags;
+int nmgr_test_frag_max;
+uint16_t nmgr_test_mtu;
+
+static struct os_eventq nmgr_test_evq;
+static struct nmgr_transport nmgr_test_nt;
+
+static int
+nmgr_test_echo(struct mgmt_cbuf *cb)
+{
+    char str[NMGR_TEST_STR_MAX];
+    CborEncoder map;
+    CborError g_err;
+    const struct cbor_attr_t attrs[] = {
+        {
+            .attribute = "d",
+            .type = CborAttrTextStringType,
+            .addr.string = str,
+            .len = sizeof(str)
+        },
+        { 0 }
+    };
+    int rc;
+
+    str[0] = '\0';
+    rc = cbor_read_object(&cb->it, attrs);
+    if (rc != 0) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    g_err = cbor_encoder_create_map(&cb->encoder, &map,
+                                    CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&map, "r");
+    g_err |= cbor_encode_text_stringz(&map, str);
+    g_err |= cbor_encoder_close_container(&cb->encoder, &map);
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
+static int
+nmgr_test_fail(struct mgmt_cbuf *cb)
+{
+    return MGMT_ERR_EBADSTATE;
+}
+
+static int
+nmgr_test_big_fail(struct mgmt_cbuf *cb)
+{
+    char str[NMGR_TEST_STR_MAX];
+    CborEncoder map;
+    int i;
+
+    memset(str, 'b', sizeof(str) - 1);
+    str[sizeof(str) - 1] = '\0';
+
+    cbor_encoder_create_map(&cb->encoder, &map, CborIndefiniteLength);
+    for (i = 0; i < NMGR_TEST_BIG_STRS; i++) {
+        cbor_encode_text_stringz(&map, "r");
+        cbor_encode_text_stringz(&map, str);
+    }
+    return MGMT_ERR_EBADSTATE;
+}
+
+static const struct mgmt_handler nmgr_test_handlers[] = {
+    [NMGR_TEST_ID_ECHO] = { nmgr_test_echo, nmgr_test_echo },
+    [NMGR_TEST_ID_FAIL] = { nmgr_test_fail, nmgr_test_fail },
+    [NMGR_TEST_ID_BIG_FAIL] = { nmgr_test_big_fail, nmgr_test_big_fail },
+};
+
+static struct mgmt_group nmgr_test_group = {
+    .mg_handlers = nmgr_test_handlers,
+    .mg_handlers_count = sizeof(nmgr_test_handlers) /
+                         sizeof(nmgr_test_handlers[0]),
+    .mg_group_id = NMGR_TEST_GROUP,
+};
+
+static int
+nmgr_test_output(struct nmgr_transport *nt, struct os_mbuf *m)
+{
+    struct os_mbuf *om;
+    int len;
+
+    /* Packet length must match the chain. */
+    len = 0;
+    for (om = m; om; om = SLIST_NEXT(om, om_next)) {
+        len += om->om_len;
+    }
+    TEST_ASSERT_FATAL(len == OS_MBUF_PKTLEN(m));
+
+    TEST_ASSERT_FATAL(nmgr_test_out_len + len <= sizeof(nmgr_test_out));
+    os_mbuf_copydata(m, 0, len, nmgr_test_out + nmgr_test_out_len);
+    os_mbuf_free_chain(m);
+
+    nmgr_test_out_len += len;
+    nmgr_test_frags++;
+    if (len > nmgr_test_frag_max) {
+        nmgr_test_frag_max = len;
+    }
+    return 0;
+}
+
+static uint16_t
+nmgr_test_get_mtu(struct os_mbuf *m)
+{
+    return nmgr_test_mtu;
+}
+
+/*
+ * Appends a request to req, padded to 4 bytes like batched requests are.
+ */
+void
+nmgr_test_add_req(struct os_mbuf *req, uint8_t id, uint8_t seq,
+                  const char *str)
+{
+    static const uint8_t pad[4];
+    uint8_t body[NMGR_TEST_STR_MAX + 16];
+    struct CborBufWriter writer;
+    struct nmgr_hdr hdr;
+    CborEncoder enc;
+    CborEncoder map;
+    int len;
+    int rc;
+
+    cbor_buf_writer_init(&writer, body, sizeof(body));
+    cbor_encoder_init(&enc, &writer.enc, 0);
+    rc = cbor_encoder_create_map(&enc, &map, 1);
+    rc |= cbor_encode_text_stringz(&map, "d");
+    rc |= cbor_encode_text_stringz(&map, str);
+    rc |= cbor_encoder_close_container(&enc, &map);
+    TEST_ASSERT_FATAL(rc == 0);
+    len = cbor_buf_writer_buffer_size(&writer, body);
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.nh_op = NMGR_OP_WRITE;
+    hdr.nh_len = htons(len);
+    hdr.nh_group = htons(NMGR_TEST_GROUP);
+    hdr.nh_seq = seq;
+    hdr.nh_id = id;
+
+    rc = os_mbuf_append(req, &hdr, sizeof(hdr));
+    rc |= os_mbuf_append(req, body, len);
+    if (len % 4) {
+        rc |= os_mbuf_append(req, pad, 4 - len % 4);
+    }
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/*
+ * Hands the request to newtmgr, and waits for the responses.
+ */
+void
+nmgr_test_run(struct os_mbuf *req)
+{
+    struct os_eventq *evq;
+    struct os_event *ev;
+    int rc;
+
+    nmgr_test_out_len = 0;
+    nmgr_test_frags = 0;
+    nmgr_test_frag_max = 0;
+
+    rc = nmgr_rx_req(&nmgr_test_nt, req);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    evq = &nmgr_test_evq;
+    while ((ev = os_eventq_poll(&evq, 1, 0)) != NULL) {
+        ev->ev_cb(ev);
+    }
+}
+
+/*
+ * Parses the response at offset off of what was sent.  Returns the offset
+ * of the next response.
+ */
+int
+nmgr_test_rsp(int off, struct nmgr_hdr *hdr, char *str, long long *rc)
+{
+    struct cbor_buf_reader reader;
+    struct CborParser parser;
+    struct CborValue it;
+    const struct cbor_attr_t attrs[] = {
+        {
+            .attribute = "r",
+            .type = CborAttrTextStringType,
+            .addr.string = str,
+            .len = NMGR_TEST_STR_MAX
+        },
+        {
+            .attribute = "rc",
+            .type = CborAttrIntegerType,
+            .addr.integer = rc
+        },
+        { 0 }
+    };
+
+    TEST_ASSERT_FATAL(off + sizeof(*hdr) <= nmgr_test_out_len);
+    memcpy(hdr, nmgr_test_out + off, sizeof(*hdr));
+    hdr->nh_len = ntohs(hdr->nh_len);
+    hdr->nh_group = ntohs(hdr->nh_group);
+    off += sizeof(*hdr);
+    TEST_ASSERT_FATAL(off + hdr->nh_len <= nmgr_test_out_len);
+
+    str[0] = '\0';
+    *rc = 0;
+    cbor_buf_reader_init(&reader, nmgr_test_out + off, hdr->nh_len);
+    cbor_parser_init(&reader.r, 0, &parser, &it);
+    TEST_ASSERT_FATAL(cbor_read_object(&it, attrs) == 0);
+
+    return OS_ALIGN(off + hdr->nh_len, 4);
+}
+
+static void
+nmgr_test_init(void)
+{
+    int rc;
+
+    os_eventq_init(&nmgr_test_evq);
+    mgmt_evq_set(&nmgr_test_evq);
+
+    rc = mgmt_group_register(&nmgr_test_group);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = nmgr_transport_init(&nmgr_test_nt, nmgr_test_output,
+                             nmgr_test_get_mtu);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+TEST_SUITE(newtmgr_test_suite)
+{
+    nmgr_test_init();
+
+    newtmgr_batch();
+    newtmgr_batch_err();
+    newtmgr_split();
+    newtmgr_stream_err();
+}
+
+int
+newtmgr_test_all(void)
+{
+    newtmgr_test_suite();
+    return tu_any_failed;
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(void)
+{
+    ts_config.ts_print_results = 1;
+    tu_init();
+
+    newtmgr_test_all();
+
+    return tu_any_failed;
+}
+#endif
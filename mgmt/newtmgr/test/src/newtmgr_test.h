@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _NEWTMGR_TEST_H
+#define _NEWTMGR_TEST_H
+
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "os/endian.h"
+#include "testutil/testutil.h"
+#include "mgmt/mgmt.h"
+#include "newtmgr/newtmgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NMGR_TEST_GROUP         MGMT_GROUP_ID_PERUSER
+#define NMGR_TEST_ID_ECHO       0   /* Answers {"d": s} with {"r": s} */
+#define NMGR_TEST_ID_FAIL       1   /* Always fails with MGMT_ERR_EBADSTATE */
+#define NMGR_TEST_ID_BIG_FAIL   2   /* Encodes NMGR_TEST_BIG_STRS strings of
+                                     * NMGR_TEST_STR_MAX - 1 bytes, then
+                                     * fails */
+
+#define NMGR_TEST_STR_MAX       256
+#define NMGR_TEST_BIG_STRS      4
+
+/* What the test transport has sent. */
+extern uint8_t nmgr_test_out[2048];
+extern int nmgr_test_out_len;
+extern int nmgr_test_frags;
+extern int nmgr_test_frag_max;
+extern uint16_t nmgr_test_mtu;
+
+void nmgr_test_add_req(struct os_mbuf *req, uint8_t id, uint8_t seq,
+                       const char *str);
+void nmgr_test_run(struct os_mbuf *req);
+int nmgr_test_rsp(int off, struct nmgr_hdr *hdr, char *str, long long *rc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NEWTMGR_TEST_H */
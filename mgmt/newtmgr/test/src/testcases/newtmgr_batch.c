@@ -0,0 +1,58 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "newtmgr_test.h"
+
+TEST_CASE(newtmgr_batch)
+{
+    char str[NMGR_TEST_STR_MAX];
+    struct nmgr_hdr hdr;
+    struct os_mbuf *req;
+    long long rc;
+    int off;
+
+    /*
+     * Requests back to back in one packet get their responses back to back
+     * in one packet, each padded to 4 bytes.
+     */
+    nmgr_test_mtu = 512;
+    req = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(req != NULL);
+    nmgr_test_add_req(req, NMGR_TEST_ID_ECHO, 1, "a");
+    nmgr_test_add_req(req, NMGR_TEST_ID_ECHO, 2, "bcdef");
+    nmgr_test_add_req(req, NMGR_TEST_ID_ECHO, 3, "gh");
+    nmgr_test_run(req);
+
+    TEST_ASSERT(nmgr_test_frags == 1);
+
+    off = nmgr_test_rsp(0, &hdr, str, &rc);
+    TEST_ASSERT(hdr.nh_op == NMGR_OP_WRITE_RSP);
+    TEST_ASSERT(hdr.nh_group == NMGR_TEST_GROUP);
+    TEST_ASSERT(hdr.nh_seq == 1);
+    TEST_ASSERT(strcmp(str, "a") == 0);
+
+    off = nmgr_test_rsp(off, &hdr, str, &rc);
+    TEST_ASSERT(hdr.nh_seq == 2);
+    TEST_ASSERT(strcmp(str, "bcdef") == 0);
+
+    off = nmgr_test_rsp(off, &hdr, str, &rc);
+    TEST_ASSERT(hdr.nh_seq == 3);
+    TEST_ASSERT(strcmp(str, "gh") == 0);
+
+    TEST_ASSERT(OS_ALIGN(nmgr_test_out_len, 4) == off);
+}
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "newtmgr_test.h"
+
+TEST_CASE(newtmgr_split)
+{
+    char str[NMGR_TEST_STR_MAX];
+    char big[200];
+    uint8_t whole[sizeof(nmgr_test_out)];
+    struct nmgr_hdr hdr;
+    struct os_mbuf *req;
+    long long rc;
+    int whole_len;
+    int num_free;
+    int mtu;
+    int off;
+    int i;
+
+    for (i = 0; i < sizeof(big) - 1; i++) {
+        big[i] = 'a' + i % 26;
+    }
+    big[i] = '\0';
+
+    /* The responses in one piece, for comparison. */
+    nmgr_test_mtu = sizeof(nmgr_test_out);
+    req = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(req != NULL);
+    nmgr_test_add_req(req, NMGR_TEST_ID_ECHO, 1, big);
+    nmgr_test_add_req(req, NMGR_TEST_ID_ECHO, 2, "small");
+    nmgr_test_run(req);
+    TEST_ASSERT_FATAL(nmgr_test_frags == 1);
+    whole_len = nmgr_test_out_len;
+    memcpy(whole, nmgr_test_out, whole_len);
+
+    off = nmgr_test_rsp(0, &hdr, str, &rc);
+    TEST_ASSERT(strcmp(str, big) == 0);
+    off = nmgr_test_rsp(off, &hdr, str, &rc);
+    TEST_ASSERT(strcmp(str, "small") == 0);
+
+    /*
+     * Split at various MTUs, including ones which fall on and next to mbuf
+     * boundaries.  The fragments add up to the same bytes, and no mbufs
+     * are lost.
+     */
+    num_free = os_msys_num_free();
+    for (mtu = 20; mtu < 80; mtu++) {
+        nmgr_test_mtu = mtu;
+        req = os_msys_get_pkthdr(0, 0);
+        TEST_ASSERT_FATAL(req != NULL);
+        nmgr_test_add_req(req, NMGR_TEST_ID_ECHO, 1, big);
+        nmgr_test_add_req(req, NMGR_TEST_ID_ECHO, 2, "small");
+        nmgr_test_run(req);
+
+        TEST_ASSERT(nmgr_test_frag_max <= mtu);
+        TEST_ASSERT(nmgr_test_frags == (whole_len + mtu - 1) / mtu,
+                    "mtu %d: %d fragments", mtu, nmgr_test_frags);
+        TEST_ASSERT_FATAL(nmgr_test_out_len == whole_len);
+        TEST_ASSERT(memcmp(nmgr_test_out, whole, whole_len) == 0,
+                    "mtu %d: bytes differ", mtu);
+        TEST_ASSERT(os_msys_num_free() == num_free);
+    }
+}
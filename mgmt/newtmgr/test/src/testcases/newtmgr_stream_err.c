@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "newtmgr_test.h"
+
+TEST_CASE(newtmgr_stream_err)
+{
+    char str[NMGR_TEST_STR_MAX];
+    char echo[NMGR_TEST_STR_MAX];
+    struct nmgr_hdr hdr;
+    struct os_mbuf *req;
+    long long rc;
+    int num_free;
+    int len;
+    int off;
+    int i;
+
+    /*
+     * A request which fails once its response is being streamed, behind
+     * two echo requests.  The echo responses go out intact along with the
+     * start of the failing one, whatever the split; the rest of it is
+     * dropped, and so is the rest of the batch.  The echo responses are
+     * kept short enough not to be streamed themselves.
+     */
+    nmgr_test_mtu = MYNEWT_VAL(NEWTMGR_STREAM_LEN) + 16;
+    num_free = os_msys_num_free();
+    for (len = 200; len <= 250; len++) {
+        memset(echo, 'e', len);
+        echo[len] = '\0';
+
+        req = os_msys_get_pkthdr(0, 0);
+        TEST_ASSERT_FATAL(req != NULL);
+        nmgr_test_add_req(req, NMGR_TEST_ID_ECHO, 0, echo);
+        nmgr_test_add_req(req, NMGR_TEST_ID_ECHO, 1, echo);
+        nmgr_test_add_req(req, NMGR_TEST_ID_BIG_FAIL, 2, "x");
+        nmgr_test_add_req(req, NMGR_TEST_ID_ECHO, 3, "last");
+        nmgr_test_run(req);
+
+        off = 0;
+        for (i = 0; i < 2; i++) {
+            off = nmgr_test_rsp(off, &hdr, str, &rc);
+            TEST_ASSERT_FATAL(hdr.nh_seq == i, "len %d", len);
+            TEST_ASSERT(rc == 0);
+            TEST_ASSERT(strcmp(str, echo) == 0);
+        }
+
+        memcpy(&hdr, nmgr_test_out + off, sizeof(hdr));
+        TEST_ASSERT(hdr.nh_seq == 2);
+        TEST_ASSERT(hdr.nh_flags & NMGR_F_STREAM);
+
+        /* Only the fragments sent while the handler ran. */
+        TEST_ASSERT(nmgr_test_out_len == nmgr_test_frags * nmgr_test_mtu,
+                    "len %d: %d bytes sent", len, nmgr_test_out_len);
+        TEST_ASSERT(os_msys_num_free() == num_free);
+    }
+}
@@ -206,6 +206,7 @@ nmgr_uart_tx_char(void *arg)
 static void
 nmgr_uart_rx_pkt(struct nmgr_uart_state *nus, struct os_mbuf_pkthdr *rxm)
 {
+    struct base64_decoder bd;
     struct os_mbuf *m;
     struct nmgr_ser_hdr *nsh;
     uint16_t crc;
@@ -234,22 +235,18 @@ nmgr_uart_rx_pkt(struct nmgr_uart_state *nus, struct os_mbuf_pkthdr *rxm)
         goto err;
     }
 
-    if (os_mbuf_append(m, "\0", 1)) {
-        /*
-         * Null-terminate the line for base64_decode's sake.
-         */
-        goto err;
-    }
     m = os_mbuf_pullup(m, rxm->omp_len);
     if (!m) {
         /*
-         * Make data contiguous for base64_decode's sake.
+         * Make data contiguous, to decode it in place.
          */
         goto err;
     }
     rxm = OS_MBUF_PKTHDR(m);
-    rc = base64_decode((char *)m->om_data + 2, (char *)m->om_data + 2);
-    if (rc < 0) {
+    base64_decoder_init(&bd);
+    rc = base64_decoder_data(&bd, (char *)m->om_data + 2, rxm->omp_len - 2,
+      m->om_data + 2);
+    if (rc < 0 || base64_decoder_finish(&bd)) {
         goto err;
     }
     rxm->omp_len = m->om_len = rc + 2;
@@ -20,6 +20,10 @@
 #include <stddef.h>
 #include <errno.h>
 #include "bsp/bsp.h"
+#include "syscfg/syscfg.h"
+#if MYNEWT_VAL(BLE_ATT_RX_TIME_STATS)
+#include "os/os_cputime.h"
+#endif
 #include "ble_hs_priv.h"
 
 static uint16_t ble_att_preferred_mtu_val;
@@ -66,6 +70,10 @@ static const struct ble_att_rx_dispatch_entry ble_att_rx_dispatch[] = {
     (sizeof ble_att_rx_dispatch / sizeof ble_att_rx_dispatch[0])
 
 STATS_SECT_DECL(ble_att_stats) ble_att_stats;
+#if MYNEWT_VAL(BLE_ATT_RX_TIME_STATS)
+STATS_SECT_DECL(ble_att_rx_time) ble_att_rx_time;
+#endif
+STATS_SECT_DECL(ble_att_rx_rate) ble_att_rx_rate;
 STATS_NAME_START(ble_att_stats)
     STATS_NAME(ble_att_stats, error_rsp_rx)
     STATS_NAME(ble_att_stats, error_rsp_tx)
@@ -443,6 +451,9 @@ static int
 ble_att_rx(uint16_t conn_handle, struct os_mbuf **om)
 {
     const struct ble_att_rx_dispatch_entry *entry;
+#if MYNEWT_VAL(BLE_ATT_RX_TIME_STATS)
+    uint32_t start;
+#endif
     uint8_t op;
     int rc;
 
@@ -457,8 +468,15 @@ ble_att_rx(uint16_t conn_handle, struct os_mbuf **om)
     }
 
     ble_att_inc_rx_stat(op);
+    STATS_RATE_INC(ble_att_rx_rate);
 
+#if MYNEWT_VAL(BLE_ATT_RX_TIME_STATS)
+    start = os_cputime_get32();
     rc = entry->bde_fn(conn_handle, om);
+    STATS_HIST_ADD(ble_att_rx_time, os_cputime_get32() - start);
+#else
+    rc = entry->bde_fn(conn_handle, om);
+#endif
     if (rc != 0) {
         return rc;
     }
@@ -561,5 +579,24 @@ ble_att_init(void)
         return BLE_HS_EOS;
     }
 
+#if MYNEWT_VAL(BLE_ATT_RX_TIME_STATS)
+    rc = stats_hist_init(STATS_HDR(ble_att_rx_time),
+                         STATS_HIST_CNT(ble_att_rx_time));
+    if (rc == 0) {
+        rc = stats_register("ble_att_rx_time", STATS_HDR(ble_att_rx_time));
+    }
+    if (rc != 0) {
+        return BLE_HS_EOS;
+    }
+#endif
+
+    rc = stats_rate_init(STATS_HDR(ble_att_rx_rate));
+    if (rc == 0) {
+        rc = stats_register("ble_att_rx_rate", STATS_HDR(ble_att_rx_rate));
+    }
+    if (rc != 0) {
+        return BLE_HS_EOS;
+    }
+
     return 0;
 }
@@ -104,6 +104,16 @@ STATS_SECT_START(ble_att_stats)
 STATS_SECT_END
 extern STATS_SECT_DECL(ble_att_stats) ble_att_stats;
 
+#if MYNEWT_VAL(BLE_ATT_RX_TIME_STATS)
+/* Time spent handling received ATT PDUs, in cputime ticks. */
+STATS_HIST_SECT(ble_att_rx_time, 20)
+extern STATS_SECT_DECL(ble_att_rx_time) ble_att_rx_time;
+#endif
+
+/* Rate of received ATT PDUs. */
+STATS_RATE_SECT(ble_att_rx_rate)
+extern STATS_SECT_DECL(ble_att_rx_rate) ble_att_rx_rate;
+
 struct ble_att_prep_entry {
     SLIST_ENTRY(ble_att_prep_entry) bape_next;
     uint16_t bape_handle;
@@ -20,6 +20,7 @@
 #define __CONSOLE_H__
 
 #include <stdarg.h>
+#include <inttypes.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,10 +28,25 @@ extern "C" {
 
 typedef void (*console_rx_cb)(void);
 
+/*
+ * Called from the UART receive interrupt with every received byte, ahead of
+ * line editing.  Returns 0 if the byte was consumed, nonzero to pass it on
+ * to the console.
+ */
+typedef int (*console_rx_filter_t)(void *arg, uint8_t data);
+
+/* Called from the UART receive interrupt when tab is typed. */
+typedef void (*console_tab_cb)(void);
+
 int console_init(console_rx_cb rx_cb);
 int console_is_init(void);
 void console_write(const char *str, int cnt);
+void console_write_raw(const char *str, int cnt);
+void console_rx_filter_set(console_rx_filter_t filter, void *arg);
 int console_read(char *str, int cnt, int *newline);
+void console_tab_set(console_tab_cb cb);
+int console_line_get(char *str, int cnt);
+void console_line_insert(const char *str, int cnt);
 void console_blocking_mode(void);
 void console_echo(int on);
 
@@ -38,6 +54,7 @@ void console_printf(const char *fmt, ...)
     __attribute__ ((format (printf, 1, 2)));;
 
 extern int console_is_midline;
+extern uint32_t console_tx_dropped;
 
 #ifdef __cplusplus
 }
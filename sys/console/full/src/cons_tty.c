@@ -19,6 +19,7 @@
 
 #include <inttypes.h>
 #include <assert.h>
+#include <string.h>
 #include "syscfg/syscfg.h"
 #include "sysinit/sysinit.h"
 #include "os/os.h"
@@ -31,12 +32,17 @@
 /** Indicates whether the previous line of output was completed. */
 int console_is_midline;
 
+/** Bytes of output dropped because the transmit buffer was full. */
+uint32_t console_tx_dropped;
+
 #define CONSOLE_RX_CHUNK        16
+#define CONSOLE_TX_CHUNK        64
 
 #if MYNEWT_VAL(CONSOLE_HIST_ENABLE)
 #define CONSOLE_HIST_SZ         32
 #endif
 
+#define CONSOLE_TAB             '\t'    /* completion request */
 #define CONSOLE_DEL             0x7f    /* del character */
 #define CONSOLE_ESC             0x1b    /* esc character */
 #define CONSOLE_LEFT            'D'     /* esc-[-D emitted when moving left */
@@ -51,8 +57,8 @@ typedef void (*console_write_char)(char);
 void console_print_prompt(void);
 
 struct console_ring {
-    uint8_t cr_head;
-    uint8_t cr_tail;
+    uint16_t cr_head;
+    uint16_t cr_tail;
     uint16_t cr_size;
     uint8_t *cr_buf;
 };
@@ -69,7 +75,11 @@ struct console_tty {
     uint8_t ct_rx_buf[MYNEWT_VAL(CONSOLE_RX_BUF_SIZE)];
 
     console_rx_cb ct_rx_cb; /* callback that input is ready */
+    console_rx_filter_t ct_rx_filter; /* sees input before line editing */
+    void *ct_rx_filter_arg;
+    console_tab_cb ct_tab_cb; /* called when tab is typed */
     console_write_char ct_write_char;
+    uint16_t ct_tx_held; /* bytes handed to the driver with console_tx_buf */
     uint8_t ct_echo_off:1;
     uint8_t ct_esc_seq:2;
 } console_tty;
@@ -101,6 +111,38 @@ console_pull_char(struct console_ring *cr)
     return ch;
 }
 
+static int
+console_buf_space(struct console_ring *cr)
+{
+    return (cr->cr_tail - cr->cr_head - 1) & (cr->cr_size - 1);
+}
+
+/*
+ * Copies as much of str as fits into the ring, in at most two spans.
+ * Returns the number of bytes copied.
+ */
+static int
+console_add_str(struct console_ring *cr, const char *str, int cnt)
+{
+    int space;
+    int span;
+    int i;
+
+    space = console_buf_space(cr);
+    if (cnt > space) {
+        cnt = space;
+    }
+    for (i = 0; i < cnt; i += span) {
+        span = cr->cr_size - cr->cr_head;
+        if (span > cnt - i) {
+            span = cnt - i;
+        }
+        memcpy(cr->cr_buf + cr->cr_head, str + i, span);
+        cr->cr_head = (cr->cr_head + span) & (cr->cr_size - 1);
+    }
+    return cnt;
+}
+
 static int
 console_pull_char_head(struct console_ring *cr)
 {
@@ -112,26 +154,53 @@ console_pull_char_head(struct console_ring *cr)
     }
 }
 
+/*
+ * Queues output.  If the ring fills up, the rest is either dropped (if drop
+ * is set), or queued as the ring drains.
+ */
 static void
-console_queue_char(char ch)
+console_queue_str(struct console_tty *ct, const char *str, int cnt, int drop)
 {
-    struct console_tty *ct = &console_tty;
+    int chunk;
     int sr;
+    int n;
 
     OS_ENTER_CRITICAL(sr);
-    while (CONSOLE_HEAD_INC(&ct->ct_tx) == ct->ct_tx.cr_tail) {
+    while (cnt > 0) {
+        chunk = min(cnt, CONSOLE_TX_CHUNK);
+        n = console_add_str(&ct->ct_tx, str, chunk);
+        str += n;
+        cnt -= n;
+        if (n == chunk) {
+            /*
+             * Make a break from blocking interrupts during the copy.
+             */
+            OS_EXIT_CRITICAL(sr);
+            OS_ENTER_CRITICAL(sr);
+            continue;
+        }
+
         /* TX needs to drain */
         uart_start_tx(ct->ct_dev);
+        if (drop) {
+            console_tx_dropped += cnt;
+            break;
+        }
         OS_EXIT_CRITICAL(sr);
         if (os_started()) {
             os_time_delay(1);
         }
         OS_ENTER_CRITICAL(sr);
     }
-    console_add_char(&ct->ct_tx, ch);
     OS_EXIT_CRITICAL(sr);
 }
 
+static void
+console_queue_char(char ch)
+{
+    console_queue_str(&console_tty, &ch, 1, MYNEWT_VAL(CONSOLE_TX_DROP));
+}
+
 #if MYNEWT_VAL(CONSOLE_HIST_ENABLE)
 static void
 console_hist_init(void)
@@ -149,7 +218,7 @@ console_hist_add(struct console_ring *rx)
 {
     struct console_hist *ch = &console_hist;
     uint8_t *str = ch->ch_buf[ch->ch_head];
-    uint8_t tail;
+    uint16_t tail;
     uint8_t empty = 1;
 
     tail = rx->cr_tail;
@@ -179,8 +248,13 @@ console_hist_add(struct console_ring *rx)
     }
 }
 
+/*
+ * Replaces the line being edited with the next history entry in the given
+ * direction.  *erase is set to the number of chars taken off the line.
+ */
 static int
-console_hist_move(struct console_ring *rx, uint8_t *tx_buf, uint8_t direction)
+console_hist_move(struct console_ring *rx, uint8_t *tx_buf, uint8_t direction,
+                  int *erase)
 {
     struct console_hist *ch = &console_hist;
     uint8_t *str = NULL;
@@ -188,7 +262,20 @@ console_hist_move(struct console_ring *rx, uint8_t *tx_buf, uint8_t direction)
     int i;
     uint8_t limit = direction == CONSOLE_UP ? ch->ch_tail : ch->ch_head;
 
+    *erase = 0;
+
     /* no more history to return in this direction */
+    if (ch->ch_curr == limit && direction == CONSOLE_UP) {
+        return 0;
+    }
+
+    /* consume the line being edited, but not lines waiting to be read */
+    while (rx->cr_head != rx->cr_tail &&
+           rx->cr_buf[(rx->cr_head - 1) & (rx->cr_size - 1)] != '\n') {
+        console_pull_char_head(rx);
+        (*erase)++;
+    }
+
     if (ch->ch_curr == limit) {
         return 0;
     }
@@ -199,11 +286,6 @@ console_hist_move(struct console_ring *rx, uint8_t *tx_buf, uint8_t direction)
         ch->ch_curr = (ch->ch_curr + 1) & (ch->ch_size - 1);
     }
 
-    /* consume all chars */
-    while (console_pull_char_head(rx) == 0) {
-        /* do nothing */
-    }
-
     str = ch->ch_buf[ch->ch_curr];
     for (i = 0; i < MYNEWT_VAL(CONSOLE_RX_BUF_SIZE); ++i) {
         if (str[i] == '\0') {
@@ -235,6 +317,13 @@ console_tx_flush(struct console_tty *ct, int cnt)
     int i;
     uint8_t byte;
 
+    if (ct->ct_tx_held) {
+        /*
+         * Driver is sending from the head of the queue; flushing what
+         * follows would reorder the output.
+         */
+        return;
+    }
     for (i = 0; i < cnt; i++) {
         if (ct->ct_tx.cr_head == ct->ct_tx.cr_tail) {
             /*
@@ -257,6 +346,12 @@ console_blocking_mode(void)
     if (ct->ct_write_char) {
         ct->ct_write_char = console_blocking_tx;
 
+        /*
+         * Driver won't be allowed to finish sending what it holds;
+         * send it again.
+         */
+        ct->ct_tx_held = 0;
+
         console_tx_flush(ct, MYNEWT_VAL(CONSOLE_TX_BUF_SIZE));
     }
     OS_EXIT_CRITICAL(sr);
@@ -274,16 +369,36 @@ size_t
 console_file_write(void *arg, const char *str, size_t cnt)
 {
     struct console_tty *ct = &console_tty;
-    int i;
+    const char *nl;
+    size_t len;
+    size_t i;
 
     if (!ct->ct_write_char) {
         return cnt;
     }
-    for (i = 0; i < cnt; i++) {
-        if (str[i] == '\n') {
-            ct->ct_write_char('\r');
+    if (ct->ct_write_char == console_queue_char) {
+        /* Queue the text between newlines in bulk. */
+        for (i = 0; i < cnt; i += len) {
+            nl = memchr(str + i, '\n', cnt - i);
+            if (nl == NULL) {
+                len = cnt - i;
+                console_queue_str(ct, str + i, len,
+                                  MYNEWT_VAL(CONSOLE_TX_DROP));
+            } else {
+                len = nl - (str + i);
+                console_queue_str(ct, str + i, len,
+                                  MYNEWT_VAL(CONSOLE_TX_DROP));
+                console_queue_str(ct, "\r\n", 2, MYNEWT_VAL(CONSOLE_TX_DROP));
+                len++;
+            }
+        }
+    } else {
+        for (i = 0; i < cnt; i++) {
+            if (str[i] == '\n') {
+                ct->ct_write_char('\r');
+            }
+            ct->ct_write_char(str[i]);
         }
-        ct->ct_write_char(str[i]);
     }
     if (cnt > 0) {
         console_is_midline = str[cnt - 1] != '\n';
@@ -298,6 +413,123 @@ console_write(const char *str, int cnt)
     console_file_write(NULL, str, cnt);
 }
 
+/**
+ * Writes binary data to the console, without newline translation.  The
+ * data is never dropped, even with CONSOLE_TX_DROP, as a frame cut short
+ * would be useless; this waits for room instead.
+ */
+void
+console_write_raw(const char *str, int cnt)
+{
+    struct console_tty *ct = &console_tty;
+    int i;
+
+    if (!ct->ct_write_char) {
+        return;
+    }
+    if (ct->ct_write_char == console_queue_char) {
+        console_queue_str(ct, str, cnt, 0);
+    } else {
+        for (i = 0; i < cnt; i++) {
+            ct->ct_write_char(str[i]);
+        }
+    }
+    uart_start_tx(ct->ct_dev);
+}
+
+/**
+ * Installs a filter which sees every received byte before the line editor
+ * does, e.g. to pick binary frames out of the input stream.  The filter is
+ * called with interrupts disabled.
+ */
+void
+console_rx_filter_set(console_rx_filter_t filter, void *arg)
+{
+    struct console_tty *ct = &console_tty;
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    ct->ct_rx_filter = filter;
+    ct->ct_rx_filter_arg = arg;
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Installs a callback for tab.  Instead of being added to the input, tab
+ * calls cb with interrupts disabled; cb would typically schedule work to
+ * complete the line with console_line_get() and console_line_insert().
+ */
+void
+console_tab_set(console_tab_cb cb)
+{
+    struct console_tty *ct = &console_tty;
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    ct->ct_tab_cb = cb;
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Copies the line being edited, which has not been terminated with a
+ * newline yet, into str without consuming it.
+ *
+ * @return                      Number of chars copied; str is nul-terminated.
+ */
+int
+console_line_get(char *str, int cnt)
+{
+    struct console_tty *ct = &console_tty;
+    struct console_ring *cr = &ct->ct_rx;
+    uint16_t start;
+    int sr;
+    int i;
+
+    if (cnt <= 0) {
+        return 0;
+    }
+    OS_ENTER_CRITICAL(sr);
+    start = cr->cr_head;
+    while (start != cr->cr_tail &&
+           cr->cr_buf[(start - 1) & (cr->cr_size - 1)] != '\n') {
+        start = (start - 1) & (cr->cr_size - 1);
+    }
+    for (i = 0; i < cnt - 1 && start != cr->cr_head; i++) {
+        str[i] = cr->cr_buf[start];
+        start = (start + 1) & (cr->cr_size - 1);
+    }
+    OS_EXIT_CRITICAL(sr);
+    str[i] = '\0';
+    return i;
+}
+
+/**
+ * Adds chars to the line being edited, and echoes them, as if they had been
+ * typed.
+ */
+void
+console_line_insert(const char *str, int cnt)
+{
+    struct console_tty *ct = &console_tty;
+    struct console_ring *rx = &ct->ct_rx;
+    struct console_ring *tx = &ct->ct_tx;
+    int sr;
+    int i;
+
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < cnt; i++) {
+        if (CONSOLE_HEAD_INC(rx) == rx->cr_tail) {
+            break;
+        }
+        console_add_char(rx, str[i]);
+        if (!ct->ct_echo_off && console_buf_space(tx) > 0) {
+            console_add_char(tx, str[i]);
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+    uart_start_tx(ct->ct_dev);
+}
+
 int
 console_read(char *str, int cnt, int *newline)
 {
@@ -355,13 +587,37 @@ console_tx_char(void *arg)
     return console_pull_char(cr);
 }
 
+/*
+ * Hands the driver the longest contiguous span of queued output.  It stays
+ * in the ring until console_tx_buf_done() is called.
+ */
 static int
-console_buf_space(struct console_ring *cr)
+console_tx_buf(void *arg, const uint8_t **buf)
 {
-    int space;
+    struct console_tty *ct = (struct console_tty *)arg;
+    struct console_ring *cr = &ct->ct_tx;
 
-    space = (cr->cr_tail - cr->cr_head) & (cr->cr_size - 1);
-    return space - 1;
+    *buf = cr->cr_buf + cr->cr_tail;
+    if (cr->cr_head >= cr->cr_tail) {
+        ct->ct_tx_held = cr->cr_head - cr->cr_tail;
+    } else {
+        ct->ct_tx_held = cr->cr_size - cr->cr_tail;
+    }
+    return ct->ct_tx_held;
+}
+
+static void
+console_tx_buf_done(void *arg, int len)
+{
+    struct console_tty *ct = (struct console_tty *)arg;
+    struct console_ring *cr = &ct->ct_tx;
+
+    /* console_blocking_mode() may have taken the data back */
+    if (len > ct->ct_tx_held) {
+        len = ct->ct_tx_held;
+    }
+    cr->cr_tail = (cr->cr_tail + len) & (cr->cr_size - 1);
+    ct->ct_tx_held = 0;
 }
 
 static int
@@ -373,11 +629,16 @@ console_rx_char(void *arg, uint8_t data)
     int tx_space = 0;
     int i;
 #if MYNEWT_VAL(CONSOLE_HIST_ENABLE)
+    int erase;
     uint8_t tx_buf[MYNEWT_VAL(CONSOLE_RX_BUF_SIZE)];
 #else
     uint8_t tx_buf[3];
 #endif
 
+    if (ct->ct_rx_filter && !ct->ct_rx_filter(ct->ct_rx_filter_arg, data)) {
+        return 0;
+    }
+
     if (CONSOLE_HEAD_INC(&ct->ct_rx) == ct->ct_rx.cr_tail) {
         /*
          * RX queue full. Reader must drain this.
@@ -430,7 +691,7 @@ console_rx_char(void *arg, uint8_t data)
             goto queue_char;
         }
 #if MYNEWT_VAL(CONSOLE_HIST_ENABLE)
-        tx_space = console_hist_move(rx, tx_buf, data);
+        tx_space = console_hist_move(rx, tx_buf, data, &erase);
         tx_buf[tx_space] = 0;
         ct->ct_esc_seq = 0;
         /*
@@ -441,10 +702,13 @@ console_rx_char(void *arg, uint8_t data)
             goto out;
         }
         if (!ct->ct_echo_off) {
-            /* HACK: clean line by backspacing up to maximum possible space */
-            for (i = 0; i < MYNEWT_VAL(CONSOLE_TX_BUF_SIZE); i++) {
+            /* clean the line which was replaced */
+            for (i = 0; i < erase; i++) {
                 if (console_buf_space(tx) < 3) {
                     console_tx_flush(ct, 3);
+                    if (console_buf_space(tx) < 3) {
+                        break;
+                    }
                 }
                 console_add_char(tx, '\b');
                 console_add_char(tx, ' ');
@@ -462,6 +726,19 @@ console_rx_char(void *arg, uint8_t data)
         ct->ct_esc_seq = 0;
         goto out;
 #endif
+    case CONSOLE_TAB:
+        /*
+         * Tab after a control char is data, e.g. NLIP framing; not a
+         * request for completion.
+         */
+        i = (rx->cr_head - 1) & (rx->cr_size - 1);
+        if (!ct->ct_tab_cb || ct->ct_esc_seq ||
+            (rx->cr_head != rx->cr_tail && rx->cr_buf[i] < ' ' &&
+             rx->cr_buf[i] != '\n')) {
+            goto queue_char;
+        }
+        ct->ct_tab_cb();
+        goto out;
     case CONSOLE_RIGHT:
         if (ct->ct_esc_seq == 2) {
             data = ' '; /* add space */
@@ -498,8 +775,10 @@ queue_char:
         if (console_buf_space(tx) < tx_space) {
             console_tx_flush(ct, tx_space);
         }
-        for (i = 0; i < tx_space; i++) {
-            console_add_char(tx, tx_buf[i]);
+        if (console_buf_space(tx) >= tx_space) {
+            for (i = 0; i < tx_space; i++) {
+                console_add_char(tx, tx_buf[i]);
+            }
         }
         uart_start_tx(ct->ct_dev);
     }
@@ -532,6 +811,8 @@ console_init(console_rx_cb rx_cb)
         .uc_flow_ctl = MYNEWT_VAL(CONSOLE_FLOW_CONTROL),
         .uc_tx_char = console_tx_char,
         .uc_rx_char = console_rx_char,
+        .uc_tx_buf = console_tx_buf,
+        .uc_tx_buf_done = console_tx_buf_done,
         .uc_cb_arg = ct
     };
 
@@ -553,6 +834,7 @@ console_init(console_rx_cb rx_cb)
 
     /* must be a power of 2 */
     assert(is_power_of_two(MYNEWT_VAL(CONSOLE_RX_BUF_SIZE)));
+    assert(is_power_of_two(MYNEWT_VAL(CONSOLE_TX_BUF_SIZE)));
 
 #if MYNEWT_VAL(CONSOLE_HIST_ENABLE)
     console_hist_init();
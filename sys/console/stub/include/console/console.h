@@ -20,12 +20,15 @@
 #define __CONSOLE_H__
 
 #include <stdarg.h>
+#include <inttypes.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef void (*console_rx_cb)(void);
+typedef int (*console_rx_filter_t)(void *arg, uint8_t data);
+typedef void (*console_tab_cb)(void);
 
 static int inline
 console_is_init(void)
@@ -46,6 +49,25 @@ console_read(char *str, int cnt, int *newline)
     return 0;
 }
 
+static void inline
+console_tab_set(console_tab_cb cb)
+{
+}
+
+static int inline
+console_line_get(char *str, int cnt)
+{
+    if (cnt > 0) {
+        str[0] = '\0';
+    }
+    return 0;
+}
+
+static void inline
+console_line_insert(const char *str, int cnt)
+{
+}
+
 static void inline
 console_blocking_mode(void)
 {
@@ -56,6 +78,16 @@ console_write(const char *str, int cnt)
 {
 }
 
+static void inline
+console_write_raw(const char *str, int cnt)
+{
+}
+
+static void inline
+console_rx_filter_set(console_rx_filter_t filter, void *arg)
+{
+}
+
 static void inline console_printf(const char *fmt, ...)
     __attribute__ ((format (printf, 1, 2)));
 
@@ -70,6 +102,7 @@ console_echo(int on)
 }
 
 #define console_is_midline  (0)
+#define console_tx_dropped  (0)
 
 #ifdef __cplusplus
 }
@@ -34,6 +34,15 @@ extern "C" {
 #define COREDUMP_TLV_IMAGE          1   /* SHA256 of image creating this */
 #define COREDUMP_TLV_MEM            2   /* Memory dump */
 #define COREDUMP_TLV_REGS           3   /* CPU registers */
+#define COREDUMP_TLV_MEM_LZ         4   /* Compressed memory dump */
+
+/*
+ * COREDUMP_TLV_MEM_LZ data is a sequence of tokens.  A token byte 0x00-0x7f
+ * is followed by (byte + 1) literal bytes.  A token byte 0x80-0xff is
+ * followed by a 16-bit little endian distance d, and means: copy
+ * ((byte & 0x7f) + 3) bytes, starting d bytes back in the output.  The
+ * copy may overlap the bytes it produces.
+ */
 
 struct coredump_tlv {
     uint8_t ct_type;
@@ -19,25 +19,286 @@
 
 #include <stddef.h>
 #include <limits.h>
+#include <string.h>
 #include "syscfg/syscfg.h"
 #include "sysflash/sysflash.h"
+#include "os/os.h"
 #include "hal/hal_bsp.h"
 #include "flash_map/flash_map.h"
 #include "bootutil/image.h"
 #include "imgmgr/imgmgr.h"
 #include "coredump/coredump.h"
 
+/*
+ * Largest amount of memory in one TLV.
+ */
+#define COREDUMP_MEM_CHUNK          (SHRT_MAX + 1)
+
 uint8_t coredump_disabled;
 
-static void
+/*
+ * The area is erased a sector at a time, as the dump grows into it.
+ */
+static uint32_t coredump_erased;
+
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+#define COREDUMP_LZ_HASH_SZ         256
+#define COREDUMP_LZ_MIN_MATCH       3
+#define COREDUMP_LZ_MAX_MATCH       (0x7f + COREDUMP_LZ_MIN_MATCH)
+#define COREDUMP_LZ_MAX_LIT         0x80
+
+static struct {
+    uint16_t hash[COREDUMP_LZ_HASH_SZ];
+    uint8_t out[MYNEWT_VAL(COREDUMP_COMPRESS_BUF_SIZE)];
+    uint16_t out_len;
+    uint32_t off;           /* Where out goes in flash */
+    int rc;
+} coredump_lz;
+#endif
+
+static int
+coredump_erase_to(const struct flash_area *fa, uint32_t end)
+{
+    struct flash_area sector;
+    int sec_id;
+
+    if (end > fa->fa_size) {
+        return -1;
+    }
+    sec_id = -1;
+    while (coredump_erased < end &&
+      flash_area_getnext_sector(fa->fa_id, &sec_id, &sector) == 0) {
+        if (sector.fa_off + sector.fa_size <= fa->fa_off + coredump_erased) {
+            continue;
+        }
+        if (flash_area_erase(fa, sector.fa_off - fa->fa_off,
+            sector.fa_size)) {
+            return -1;
+        }
+        coredump_erased = sector.fa_off + sector.fa_size - fa->fa_off;
+    }
+    return 0;
+}
+
+static int
+coredump_write(const struct flash_area *fa, uint32_t off, const void *data,
+  uint32_t len)
+{
+    if (coredump_erase_to(fa, off + len)) {
+        return -1;
+    }
+    return flash_area_write(fa, off, data, len);
+}
+
+static int
 dump_core_tlv(const struct flash_area *fa, uint32_t *off,
   struct coredump_tlv *tlv, void *data)
 {
-    flash_area_write(fa, *off, tlv, sizeof(*tlv));
-    *off += sizeof(*tlv);
+    if (coredump_write(fa, *off, tlv, sizeof(*tlv)) ||
+      coredump_write(fa, *off + sizeof(*tlv), data, tlv->ct_len)) {
+        return -1;
+    }
+    *off += sizeof(*tlv) + tlv->ct_len;
+    return 0;
+}
+
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+static void
+coredump_lz_flush(const struct flash_area *fa)
+{
+    if (coredump_lz.rc == 0 && coredump_lz.out_len) {
+        coredump_lz.rc = coredump_write(fa, coredump_lz.off, coredump_lz.out,
+                                        coredump_lz.out_len);
+    }
+    coredump_lz.off += coredump_lz.out_len;
+    coredump_lz.out_len = 0;
+}
+
+static void
+coredump_lz_put(const struct flash_area *fa, const uint8_t *data, int len)
+{
+    int cnt;
+
+    while (len > 0) {
+        cnt = sizeof(coredump_lz.out) - coredump_lz.out_len;
+        if (cnt > len) {
+            cnt = len;
+        }
+        memcpy(coredump_lz.out + coredump_lz.out_len, data, cnt);
+        coredump_lz.out_len += cnt;
+        data += cnt;
+        len -= cnt;
+        if (coredump_lz.out_len == sizeof(coredump_lz.out)) {
+            coredump_lz_flush(fa);
+        }
+    }
+}
+
+static void
+coredump_lz_literals(const struct flash_area *fa, const uint8_t *data,
+  int len)
+{
+    uint8_t tok;
+    int cnt;
+
+    while (len > 0) {
+        cnt = min(len, COREDUMP_LZ_MAX_LIT);
+        tok = cnt - 1;
+        coredump_lz_put(fa, &tok, 1);
+        coredump_lz_put(fa, data, cnt);
+        data += cnt;
+        len -= cnt;
+    }
+}
+
+/*
+ * Compresses one chunk of memory into a COREDUMP_TLV_MEM_LZ.  Matches are
+ * only looked for within the chunk, so each TLV can be decompressed on its
+ * own.
+ */
+static int
+dump_core_lz(const struct flash_area *fa, uint32_t *off, uint32_t addr,
+  uint32_t len)
+{
+    const uint8_t *src;
+    struct coredump_tlv tlv;
+    uint8_t tok[3];
+    uint32_t lit;
+    uint32_t cand;
+    uint32_t mlen;
+    uint32_t dist;
+    uint32_t i;
+    uint8_t h;
+
+    src = (const uint8_t *)addr;
+    memset(coredump_lz.hash, 0xff, sizeof(coredump_lz.hash));
+    coredump_lz.out_len = 0;
+    coredump_lz.off = *off + sizeof(tlv);
+    coredump_lz.rc = 0;
+
+    lit = 0;
+    i = 0;
+    while (i + COREDUMP_LZ_MIN_MATCH <= len && coredump_lz.rc == 0) {
+        h = src[i] ^ (src[i + 1] << 3) ^ (src[i + 2] << 5);
+        cand = coredump_lz.hash[h];
+        coredump_lz.hash[h] = i;
+        if (cand == 0xffff || memcmp(src + cand, src + i,
+                                     COREDUMP_LZ_MIN_MATCH)) {
+            i++;
+            continue;
+        }
+        mlen = COREDUMP_LZ_MIN_MATCH;
+        while (i + mlen < len && mlen < COREDUMP_LZ_MAX_MATCH &&
+               src[cand + mlen] == src[i + mlen]) {
+            mlen++;
+        }
+        coredump_lz_literals(fa, src + lit, i - lit);
+
+        dist = i - cand;
+        tok[0] = 0x80 | (mlen - COREDUMP_LZ_MIN_MATCH);
+        tok[1] = dist;
+        tok[2] = dist >> 8;
+        coredump_lz_put(fa, tok, sizeof(tok));
+
+        i += mlen;
+        lit = i;
+    }
+    coredump_lz_literals(fa, src + lit, len - lit);
+    coredump_lz_flush(fa);
+    if (coredump_lz.rc) {
+        return -1;
+    }
+
+    tlv.ct_type = COREDUMP_TLV_MEM_LZ;
+    tlv._pad = 0;
+    tlv.ct_len = coredump_lz.off - (*off + sizeof(tlv));
+    tlv.ct_off = addr;
+    if (coredump_write(fa, *off, &tlv, sizeof(tlv))) {
+        return -1;
+    }
+    *off = coredump_lz.off;
+    return 0;
+}
+#endif
+
+/*
+ * Dumps memory from start to end as one or more memory TLVs.
+ */
+static int
+dump_core_mem(const struct flash_area *fa, uint32_t *off, uint32_t start,
+  uint32_t end)
+{
+    struct coredump_tlv tlv;
+    int rc;
+
+    while (start < end) {
+        tlv.ct_type = COREDUMP_TLV_MEM;
+        tlv._pad = 0;
+        tlv.ct_len = min(end - start, COREDUMP_MEM_CHUNK);
+        tlv.ct_off = start;
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+        rc = dump_core_lz(fa, off, start, tlv.ct_len);
+#else
+        rc = dump_core_tlv(fa, off, &tlv, (void *)start);
+#endif
+        if (rc) {
+            return rc;
+        }
+        start += tlv.ct_len;
+    }
+    return 0;
+}
 
-    flash_area_write(fa, *off, data, tlv->ct_len);
-    *off += tlv->ct_len;
+/*
+ * Returns the part of a task's stack which has been used, and so is worth
+ * dumping.
+ */
+static uint32_t
+coredump_stack_start(struct os_task *t, struct os_task_info *oti)
+{
+#if MYNEWT_VAL(COREDUMP_SKIP_UNUSED_STACK)
+    return (uint32_t)(t->t_stacktop - oti->oti_stkusage);
+#else
+    return (uint32_t)(t->t_stacktop - t->t_stacksize);
+#endif
+}
+
+/*
+ * Finds the first range in [start, end) which should be left out when
+ * dumping RAM: the current task's stack, which is dumped before everything
+ * else, and the parts of other task stacks which have never been used.
+ *
+ * @return                      1 if a range was found, 0 otherwise.
+ */
+static int
+coredump_next_hole(struct os_task *cur, uint32_t start, uint32_t end,
+  uint32_t *hole_start, uint32_t *hole_end)
+{
+    struct os_task_info oti;
+    struct os_task *t;
+    uint32_t bottom;
+    uint32_t top;
+    int found;
+
+    found = 0;
+    for (t = os_task_info_get_next(NULL, &oti); t;
+         t = os_task_info_get_next(t, &oti)) {
+        bottom = (uint32_t)(t->t_stacktop - t->t_stacksize);
+        if (t == cur) {
+            top = (uint32_t)t->t_stacktop;
+        } else {
+            top = coredump_stack_start(t, &oti);
+        }
+        if (bottom >= top || top <= start || bottom >= end) {
+            continue;
+        }
+        if (!found || bottom < *hole_start) {
+            *hole_start = bottom;
+            *hole_end = top;
+            found = 1;
+        }
+    }
+    return found;
 }
 
 void
@@ -48,10 +309,15 @@ coredump_dump(void *regs, int regs_sz)
     const struct flash_area *fa;
     struct image_version ver;
     const struct hal_bsp_mem_dump *mem, *cur;
+    struct os_task_info oti;
+    struct os_task *t;
+    struct os_task *cur_task;
     int area_cnt, i;
     uint8_t hash[IMGMGR_HASH_LEN];
     uint32_t off;
     uint32_t area_off, area_end;
+    uint32_t hole_start, hole_end;
+    uint32_t chunk_end, next;
     int slot;
 
     if (coredump_disabled) {
@@ -81,26 +347,41 @@ coredump_dump(void *regs, int regs_sz)
         }
     }
 
-    if (flash_area_erase(fa, 0, fa->fa_size)) {
-        return;
-    }
-
     /*
-     * First put in data, followed by the header.
+     * First put in data, followed by the header.  Most important data
+     * goes first, in case the area fills up: registers, the stack of the
+     * task which crashed, and then RAM.
      */
+    coredump_erased = 0;
     tlv.ct_type = COREDUMP_TLV_REGS;
     tlv._pad = 0;
     tlv.ct_len = regs_sz;
     tlv.ct_off = 0;
 
     off = sizeof(hdr);
-    dump_core_tlv(fa, &off, &tlv, regs);
+    if (dump_core_tlv(fa, &off, &tlv, regs)) {
+        return;
+    }
 
     if (imgr_read_info(boot_current_slot, &ver, hash, NULL) == 0) {
         tlv.ct_type = COREDUMP_TLV_IMAGE;
         tlv.ct_len = IMGMGR_HASH_LEN;
 
-        dump_core_tlv(fa, &off, &tlv, hash);
+        if (dump_core_tlv(fa, &off, &tlv, hash)) {
+            goto done;
+        }
+    }
+
+    cur_task = os_sched_get_current_task();
+    for (t = os_task_info_get_next(NULL, &oti); t;
+         t = os_task_info_get_next(t, &oti)) {
+        if (t == cur_task) {
+            if (dump_core_mem(fa, &off, coredump_stack_start(t, &oti),
+                              (uint32_t)t->t_stacktop)) {
+                goto done;
+            }
+            break;
+        }
     }
 
     mem = hal_bsp_core_dump(&area_cnt);
@@ -109,17 +390,25 @@ coredump_dump(void *regs, int regs_sz)
         area_off = (uint32_t)cur->hbmd_start;
         area_end = area_off + cur->hbmd_size;
         while (area_off < area_end) {
-            tlv.ct_type = COREDUMP_TLV_MEM;
-            if (cur->hbmd_size > USHRT_MAX) {
-                tlv.ct_len = SHRT_MAX + 1;
-            } else {
-                tlv.ct_len = cur->hbmd_size;
+            chunk_end = area_end;
+            next = area_end;
+            if (coredump_next_hole(cur_task, area_off, area_end,
+                                   &hole_start, &hole_end)) {
+                if (hole_start <= area_off) {
+                    area_off = hole_end;
+                    continue;
+                }
+                chunk_end = hole_start;
+                next = hole_end;
             }
-            tlv.ct_off = area_off;
-            dump_core_tlv(fa, &off, &tlv, (void *)area_off);
-            area_off += tlv.ct_len;
+            if (dump_core_mem(fa, &off, area_off, chunk_end)) {
+                goto done;
+            }
+            area_off = next;
         }
     }
+
+done:
     hdr.ch_magic = COREDUMP_MAGIC;
     hdr.ch_size = off;
 
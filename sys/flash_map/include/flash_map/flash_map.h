@@ -76,6 +76,20 @@ int flash_area_write(const struct flash_area *, uint32_t off, const void *src,
   uint32_t len);
 int flash_area_erase(const struct flash_area *, uint32_t off, uint32_t len);
 
+/*
+ * Write several pieces of data to consecutive locations.
+ */
+struct hal_flash_iov;
+int flash_area_writev(const struct flash_area *, uint32_t off,
+  const struct hal_flash_iov *iov, int iovcnt);
+
+/*
+ * Pointer for reading len bytes at off in place, or NULL if the area is not
+ * memory-mapped.  Use flash_area_read() when NULL is returned.
+ */
+const void *flash_area_get_ptr(const struct flash_area *, uint32_t off,
+  uint32_t len);
+
 /*
  * Alignment restriction for flash writes.
  */
@@ -86,6 +100,13 @@ uint8_t flash_area_align(const struct flash_area *);
  */
 int flash_area_to_sectors(int idx, int *cnt, struct flash_area *ret);
 
+/*
+ * Returns info about the sector following sector *sec_id within the area,
+ * and updates *sec_id to point to it.  Start with *sec_id set to -1.
+ * Returns SYS_ENOENT after the last sector.  Needs no array of sectors.
+ */
+int flash_area_getnext_sector(int idx, int *sec_id, struct flash_area *ret);
+
 int flash_area_id_from_image_slot(int slot);
 int flash_area_id_to_image_slot(int area_id);
 
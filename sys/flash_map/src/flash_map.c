@@ -95,6 +95,39 @@ flash_area_to_sectors(int id, int *cnt, struct flash_area *ret)
     return 0;
 }
 
+int
+flash_area_getnext_sector(int id, int *sec_id, struct flash_area *ret)
+{
+    const struct flash_area *fa;
+    const struct hal_flash *hf;
+    uint32_t start;
+    uint32_t size;
+    int rc;
+    int i;
+
+    rc = flash_area_open(id, &fa);
+    if (rc != 0) {
+        return rc;
+    }
+    if (*sec_id < -1) {
+        return SYS_EINVAL;
+    }
+
+    hf = hal_bsp_flash_dev(fa->fa_device_id);
+    for (i = *sec_id + 1; i < hf->hf_sector_cnt; i++) {
+        hf->hf_itf->hff_sector_info(i, &start, &size);
+        if (start >= fa->fa_off && start < fa->fa_off + fa->fa_size) {
+            ret->fa_id = id;
+            ret->fa_device_id = fa->fa_device_id;
+            ret->fa_off = start;
+            ret->fa_size = size;
+            *sec_id = i;
+            return 0;
+        }
+    }
+    return SYS_ENOENT;
+}
+
 int
 flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
     uint32_t len)
@@ -116,6 +149,23 @@ flash_area_write(const struct flash_area *fa, uint32_t off, const void *src,
                            (void *)src, len);
 }
 
+int
+flash_area_writev(const struct flash_area *fa, uint32_t off,
+  const struct hal_flash_iov *iov, int iovcnt)
+{
+    uint32_t len;
+    int i;
+
+    len = 0;
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].hfi_len;
+    }
+    if (off > fa->fa_size || off + len > fa->fa_size) {
+        return -1;
+    }
+    return hal_flash_writev(fa->fa_device_id, fa->fa_off + off, iov, iovcnt);
+}
+
 int
 flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
 {
@@ -125,6 +175,15 @@ flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
     return hal_flash_erase(fa->fa_device_id, fa->fa_off + off, len);
 }
 
+const void *
+flash_area_get_ptr(const struct flash_area *fa, uint32_t off, uint32_t len)
+{
+    if (off > fa->fa_size || off + len > fa->fa_size) {
+        return NULL;
+    }
+    return hal_flash_ptr(fa->fa_device_id, fa->fa_off + off, len);
+}
+
 uint8_t
 flash_area_align(const struct flash_area *fa)
 {
@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "flash_map_test.h"
+
+static int flash_map_test_req_cnt;
+
+static void
+flash_map_test_req_cb(struct os_event *ev)
+{
+    flash_map_test_req_cnt++;
+}
+
+/*
+ * Test flash_area_writev() and hal_flash_submit()
+ */
+TEST_CASE(flash_map_test_case_3)
+{
+    const struct flash_area *fa;
+    struct hal_flash_iov iov[3];
+    struct hal_flash_req req;
+    struct os_eventq evq;
+    struct os_event *ev;
+    uint8_t wd[96];
+    uint8_t rd[96];
+    int rc;
+    int i;
+
+#if MYNEWT_VAL(SELFTEST)
+    sysinit();
+#endif
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_open() fail");
+
+    rc = flash_area_erase(fa, 0, fa->fa_size);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_erase() fail");
+
+    for (i = 0; i < sizeof(wd); i++) {
+        wd[i] = i;
+    }
+    iov[0].hfi_data = wd;
+    iov[0].hfi_len = 16;
+    iov[1].hfi_data = wd + 16;
+    iov[1].hfi_len = 0;
+    iov[2].hfi_data = wd + 16;
+    iov[2].hfi_len = sizeof(wd) - 16;
+
+    rc = flash_area_writev(fa, 0, iov, 3);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_writev() fail");
+
+    rc = flash_area_read(fa, 0, rd, sizeof(rd));
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_read() fail");
+    TEST_ASSERT(memcmp(wd, rd, sizeof(wd)) == 0, "read data != write data");
+
+    rc = flash_area_writev(fa, fa->fa_size - 16, iov, 3);
+    TEST_ASSERT(rc != 0, "flash_area_writev() past end of area");
+
+    /*
+     * Asynchronous read of the same data, then an erase.  Completion
+     * events show up on the queue whether or not the driver does them in
+     * the background.
+     */
+    os_eventq_init(&evq);
+    flash_map_test_req_cnt = 0;
+
+    memset(&req, 0, sizeof(req));
+    req.hfr_ev.ev_cb = flash_map_test_req_cb;
+    req.hfr_evq = &evq;
+    req.hfr_op = HAL_FLASH_OP_READ;
+    req.hfr_flash_id = fa->fa_device_id;
+    req.hfr_addr = fa->fa_off;
+    req.hfr_len = sizeof(rd);
+    req.hfr_dst = rd;
+    memset(rd, 0, sizeof(rd));
+
+    rc = hal_flash_submit(&req);
+    TEST_ASSERT_FATAL(rc == 0, "hal_flash_submit() fail");
+    ev = os_eventq_get(&evq);
+    TEST_ASSERT_FATAL(ev == &req.hfr_ev, "wrong event");
+    ev->ev_cb(ev);
+    TEST_ASSERT(flash_map_test_req_cnt == 1);
+    TEST_ASSERT(req.hfr_rc == 0);
+    TEST_ASSERT(memcmp(wd, rd, sizeof(wd)) == 0, "read data != write data");
+
+    req.hfr_op = HAL_FLASH_OP_ERASE;
+    req.hfr_len = fa->fa_size;
+    rc = hal_flash_submit(&req);
+    TEST_ASSERT_FATAL(rc == 0, "hal_flash_submit() fail");
+    ev = os_eventq_get(&evq);
+    TEST_ASSERT_FATAL(ev == &req.hfr_ev, "wrong event");
+    ev->ev_cb(ev);
+    TEST_ASSERT(flash_map_test_req_cnt == 2);
+    TEST_ASSERT(req.hfr_rc == 0);
+
+    rc = flash_area_read(fa, 0, rd, sizeof(rd));
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_read() fail");
+    for (i = 0; i < sizeof(rd); i++) {
+        TEST_ASSERT_FATAL(rd[i] == 0xff, "area not erased");
+    }
+
+    req.hfr_op = 0xff;
+    rc = hal_flash_submit(&req);
+    TEST_ASSERT(rc != 0, "hal_flash_submit() with bad op");
+}
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "flash_map_test.h"
+
+/*
+ * Test flash_area_get_ptr()
+ */
+TEST_CASE(flash_map_test_case_4)
+{
+    const struct flash_area *fa;
+    const uint8_t *ptr;
+    uint8_t wd[64];
+    int rc;
+    int i;
+
+#if MYNEWT_VAL(SELFTEST)
+    sysinit();
+#endif
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_1, &fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_open() fail");
+
+    rc = flash_area_erase(fa, 0, fa->fa_size);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_erase() fail");
+
+    for (i = 0; i < sizeof(wd); i++) {
+        wd[i] = i * 3;
+    }
+    rc = flash_area_write(fa, 100, wd, sizeof(wd));
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_write() fail");
+
+    ptr = flash_area_get_ptr(fa, 100, sizeof(wd));
+    if (ptr == NULL) {
+        /* Flash is not memory-mapped on this target. */
+        return;
+    }
+    TEST_ASSERT(memcmp(ptr, wd, sizeof(wd)) == 0, "ptr data != write data");
+    TEST_ASSERT(ptr[-1] == 0xff && ptr[sizeof(wd)] == 0xff);
+
+    /* Pointer tracks what is in flash. */
+    rc = flash_area_erase(fa, 0, fa->fa_size);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_erase() fail");
+    for (i = 0; i < sizeof(wd); i++) {
+        TEST_ASSERT_FATAL(ptr[i] == 0xff, "area not erased");
+    }
+
+    ptr = flash_area_get_ptr(fa, fa->fa_size - 16, 32);
+    TEST_ASSERT(ptr == NULL, "flash_area_get_ptr() past end of area");
+}
@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "defs/error.h"
+#include "flash_map_test.h"
+
+extern int flash_map_entries;
+extern struct flash_area *fa_sectors;
+
+/*
+ * Test flash_area_getnext_sector()
+ */
+TEST_CASE(flash_map_test_case_5)
+{
+    const struct flash_area *fa;
+    struct flash_area sector;
+    int sect_cnt;
+    int sec_id;
+    int i, j, rc;
+
+#if MYNEWT_VAL(SELFTEST)
+    sysinit();
+#endif
+
+    for (i = 0; i < flash_map_entries; i++) {
+        rc = flash_area_open(i, &fa);
+        if (rc) {
+            continue;
+        }
+
+        rc = flash_area_to_sectors(i, &sect_cnt, fa_sectors);
+        TEST_ASSERT_FATAL(rc == 0, "flash_area_to_sectors failed");
+
+        /* Same sectors, in the same order. */
+        sec_id = -1;
+        for (j = 0; j < sect_cnt; j++) {
+            rc = flash_area_getnext_sector(i, &sec_id, &sector);
+            TEST_ASSERT_FATAL(rc == 0, "flash_area_getnext_sector failed");
+            TEST_ASSERT(sector.fa_id == i);
+            TEST_ASSERT(sector.fa_device_id == fa->fa_device_id);
+            TEST_ASSERT(sector.fa_off == fa_sectors[j].fa_off);
+            TEST_ASSERT(sector.fa_size == fa_sectors[j].fa_size);
+        }
+        rc = flash_area_getnext_sector(i, &sec_id, &sector);
+        TEST_ASSERT(rc == SYS_ENOENT);
+    }
+}
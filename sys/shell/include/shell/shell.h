@@ -31,16 +31,37 @@ typedef int (*shell_cmd_func_t)(int argc, char **argv);
 struct shell_cmd {
     char *sc_cmd;
     shell_cmd_func_t sc_cmd_func;
-    STAILQ_ENTRY(shell_cmd) sc_next;
 };
 
 int shell_cmd_register(struct shell_cmd *sc);
+int shell_cmd_complete(const char *prefix, const char **match,
+                       int *common_len);
+int shell_exec_script(char *script);
 
 #define SHELL_NLIP_PKT_START1 (6)
 #define SHELL_NLIP_PKT_START2 (9)
 #define SHELL_NLIP_DATA_START1 (4)
 #define SHELL_NLIP_DATA_START2 (20)
 
+/*
+ * Binary NLIP framing (SHELL_NLIP_BINARY).  A frame is SLIP-escaped
+ *     END | length (uint16_t) | data | crc16 | END
+ * where length covers data and crc, both big-endian, as in the base64
+ * framing.  The shell answers in the framing of the last request received.
+ * Frames with a length over SHELL_NLIP_BIN_MAX_LEN, or with errors, are
+ * discarded up to the next END.
+ */
+#define SHELL_NLIP_BIN_END      (0xc0)
+#define SHELL_NLIP_BIN_ESC      (0xdb)
+#define SHELL_NLIP_BIN_ESC_END  (0xdc)
+#define SHELL_NLIP_BIN_ESC_ESC  (0xdd)
+
+/*
+ * Receives binary NLIP frames a byte at a time.  Installed as the console
+ * receive filter by shell_init(); returns nonzero for bytes outside frames.
+ */
+int shell_nlip_bin_rx_char(void *arg, uint8_t data);
+
 typedef int (*shell_nlip_input_func_t)(struct os_mbuf *, void *arg);
 int shell_nlip_input_register(shell_nlip_input_func_t nf, void *arg);
 int shell_nlip_output(struct os_mbuf *m);
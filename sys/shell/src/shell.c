@@ -39,12 +39,14 @@ static struct os_mqueue g_shell_nlip_mq;
 
 #define SHELL_HELP_PER_LINE     6
 #define SHELL_MAX_ARGS          20
+#define SHELL_COMPLETE_MAX_LEN  32
 
 static int shell_echo_cmd(int argc, char **argv);
 static int shell_help_cmd(int argc, char **argv);
 int shell_prompt_cmd(int argc, char **argv);
 
 static void shell_event_console_rdy(struct os_event *ev);
+static void shell_event_tab(struct os_event *ev);
 
 /* Shared queue that the shell uses for work items. */
 static struct os_eventq *shell_evq;
@@ -78,18 +80,38 @@ static struct os_event shell_console_rdy_ev = {
     .ev_cb = shell_event_console_rdy,
 };
 
+static struct os_event shell_tab_ev = {
+    .ev_cb = shell_event_tab,
+};
+
 static struct os_mutex g_shell_cmd_list_lock;
 
 static char *shell_line;
 static int shell_line_len;
-static char *argv[SHELL_MAX_ARGS];
 
-static STAILQ_HEAD(, shell_cmd) g_shell_cmd_list =
-    STAILQ_HEAD_INITIALIZER(g_shell_cmd_list);
+/* Registered commands, sorted by name. */
+static struct shell_cmd *g_shell_cmds[MYNEWT_VAL(SHELL_MAX_CMDS)];
+static int g_shell_cmd_cnt;
 
 static struct os_mbuf *g_nlip_mbuf;
 static uint16_t g_nlip_expected_len;
 
+#if MYNEWT_VAL(SHELL_NLIP_BINARY)
+static struct {
+    /* Frame being received, and the last mbuf in its chain. */
+    struct os_mbuf *rx_om;
+    struct os_mbuf *rx_last;
+
+    uint8_t rx_open:1;  /* Between frame delimiters. */
+    uint8_t rx_esc:1;   /* Previous byte was SHELL_NLIP_BIN_ESC. */
+    uint8_t rx_discard:1; /* Frame given up on; skip to the next END. */
+    uint8_t tx_bin:1;   /* Last request was binary; answer in kind. */
+} g_shell_nlip_bin;
+
+/* Complete binary frames, from the UART interrupt to the shell task. */
+static struct os_mqueue g_shell_nlip_bin_mq;
+#endif
+
 static struct os_eventq *
 shell_evq_get(void)
 {
@@ -139,9 +161,73 @@ err:
     return (rc);
 }
 
+/*
+ * Returns the index of the first command whose name, truncated to len
+ * characters, sorts at or after name.  A negative len compares whole names.
+ * Must be called with the command list locked.
+ */
+static int
+shell_cmd_lower_bound(const char *name, int len)
+{
+    int lo;
+    int hi;
+    int mid;
+    int cmp;
+
+    lo = 0;
+    hi = g_shell_cmd_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (len < 0) {
+            cmp = strcmp(g_shell_cmds[mid]->sc_cmd, name);
+        } else {
+            cmp = strncmp(g_shell_cmds[mid]->sc_cmd, name, len);
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*
+ * Finds the range [*first, *last) of commands starting with prefix.
+ * Must be called with the command list locked.
+ */
+static void
+shell_cmd_prefix_range(const char *prefix, int *first, int *last)
+{
+    int len;
+    int i;
+
+    len = strlen(prefix);
+    *first = shell_cmd_lower_bound(prefix, len);
+    for (i = *first; i < g_shell_cmd_cnt; i++) {
+        if (strncmp(g_shell_cmds[i]->sc_cmd, prefix, len)) {
+            break;
+        }
+    }
+    *last = i;
+}
+
+/**
+ * Registers a shell command.  Commands are kept sorted by name, so lookups
+ * are a binary search.
+ *
+ * @param sc                    The command to register.
+ *
+ * @return                      0 on success;
+ *                              OS_ENOMEM if SHELL_MAX_CMDS commands are
+ *                                  already registered;
+ *                              OS_EINVAL if another command with the same
+ *                                  name is registered.
+ */
 int
 shell_cmd_register(struct shell_cmd *sc)
 {
+    int idx;
     int rc;
 
     /* Add the command that is being registered. */
@@ -150,9 +236,22 @@ shell_cmd_register(struct shell_cmd *sc)
         goto err;
     }
 
-    STAILQ_INSERT_TAIL(&g_shell_cmd_list, sc, sc_next);
+    idx = shell_cmd_lower_bound(sc->sc_cmd, -1);
+    if (idx < g_shell_cmd_cnt && !strcmp(g_shell_cmds[idx]->sc_cmd,
+                                         sc->sc_cmd)) {
+        rc = g_shell_cmds[idx] == sc ? 0 : OS_EINVAL;
+    } else if (g_shell_cmd_cnt >= MYNEWT_VAL(SHELL_MAX_CMDS)) {
+        rc = OS_ENOMEM;
+    } else {
+        memmove(&g_shell_cmds[idx + 1], &g_shell_cmds[idx],
+                (g_shell_cmd_cnt - idx) * sizeof(g_shell_cmds[0]));
+        g_shell_cmds[idx] = sc;
+        g_shell_cmd_cnt++;
+    }
 
-    rc = shell_cmd_list_unlock();
+    if (shell_cmd_list_unlock() != 0 && rc == 0) {
+        rc = -1;
+    }
     if (rc != 0) {
         goto err;
     }
@@ -162,10 +261,63 @@ err:
     return (rc);
 }
 
+/**
+ * Completes a partially typed command name.
+ *
+ * @param prefix                The partial command name.
+ * @param match                 On success, points to the name of the first
+ *                                  command starting with prefix.  May be
+ *                                  NULL.
+ * @param common_len            On success, the length of the longest
+ *                                  prefix shared by all matching commands.
+ *                                  May be NULL.
+ *
+ * @return                      The number of matching commands; negative on
+ *                                  failure.
+ */
+int
+shell_cmd_complete(const char *prefix, const char **match, int *common_len)
+{
+    const char *first_name;
+    const char *last_name;
+    int first;
+    int last;
+    int rc;
+    int len;
+
+    rc = shell_cmd_list_lock();
+    if (rc != 0) {
+        return -1;
+    }
+
+    shell_cmd_prefix_range(prefix, &first, &last);
+    if (first < last) {
+        /* The names are sorted, so the prefix shared by all matches is the
+         * one shared by the first and the last.
+         */
+        first_name = g_shell_cmds[first]->sc_cmd;
+        last_name = g_shell_cmds[last - 1]->sc_cmd;
+        for (len = 0; first_name[len] && first_name[len] == last_name[len];
+             len++) {
+        }
+        if (match) {
+            *match = first_name;
+        }
+        if (common_len) {
+            *common_len = len;
+        }
+    }
+
+    shell_cmd_list_unlock();
+
+    return last - first;
+}
+
 static int
 shell_cmd(char *cmd, char **argv, int argc)
 {
     struct shell_cmd *sc;
+    int idx;
     int rc;
 
     rc = shell_cmd_list_lock();
@@ -173,10 +325,11 @@ shell_cmd(char *cmd, char **argv, int argc)
         goto err;
     }
 
-    STAILQ_FOREACH(sc, &g_shell_cmd_list, sc_next) {
-        if (!strcmp(sc->sc_cmd, cmd)) {
-            break;
-        }
+    idx = shell_cmd_lower_bound(cmd, -1);
+    if (idx < g_shell_cmd_cnt && !strcmp(g_shell_cmds[idx]->sc_cmd, cmd)) {
+        sc = g_shell_cmds[idx];
+    } else {
+        sc = NULL;
     }
 
     rc = shell_cmd_list_unlock();
@@ -196,8 +349,9 @@ err:
 }
 
 static int
-shell_process_command(char *line, int len)
+shell_exec_line(char *line)
 {
+    char *argv[SHELL_MAX_ARGS];
     char *tok;
     char *tok_ptr;
     int argc;
@@ -217,52 +371,98 @@ shell_process_command(char *line, int len)
     if (argc) {
         (void) shell_cmd(argv[0], argv, argc);
     }
-    else {
-        console_printf("\n");
+    return (argc);
+}
+
+/**
+ * Runs a newline-separated list of commands in one go, on the calling task.
+ * Each line is tokenized and dispatched in turn; empty lines and lines
+ * starting with '#' are skipped.  No prompt is printed.
+ *
+ * Console input is run the same way: all the lines which have arrived by
+ * the time the shell task gets to them are run in one event, and the
+ * prompt is printed once, after the last one.
+ *
+ * @param script                The nul-terminated commands to run.  The
+ *                                  script is tokenized in place.
+ *
+ * @return                      The number of command lines executed.
+ */
+int
+shell_exec_script(char *script)
+{
+    char *line;
+    char *nl;
+    int cnt;
+
+    cnt = 0;
+    for (line = script; line != NULL; line = nl) {
+        nl = strchr(line, '\n');
+        if (nl != NULL) {
+            if (nl > line && nl[-1] == '\r') {
+                nl[-1] = '\0';
+            }
+            *nl++ = '\0';
+        }
+        if (line[0] == '#') {
+            continue;
+        }
+        if (shell_exec_line(line) > 0) {
+            cnt++;
+        }
     }
-    console_print_prompt();
-    return (0);
+
+    return (cnt);
 }
 
 static int
 shell_nlip_process(char *data, int len)
 {
-    uint16_t copy_len;
+    struct base64_decoder bd;
+    uint8_t hdr[3];
     int rc;
     struct os_mbuf *m;
     uint16_t crc;
 
-    rc = base64_decode(data, data);
-    if (rc < 0) {
-        goto err;
-    }
-    len = rc;
+    base64_decoder_init(&bd);
 
     if (g_nlip_mbuf == NULL) {
-        if (len < 2) {
+        /* The first group holds the packet length. */
+        if (len < 4) {
+            rc = -1;
+            goto err;
+        }
+        rc = base64_decoder_data(&bd, data, 4, hdr);
+        if (rc < 2) {
             rc = -1;
             goto err;
         }
 
-        g_nlip_expected_len = ntohs(*(uint16_t *) data);
+        g_nlip_expected_len = (hdr[0] << 8) | hdr[1];
         g_nlip_mbuf = os_msys_get_pkthdr(g_nlip_expected_len, 0);
         if (!g_nlip_mbuf) {
             rc = -1;
             goto err;
         }
+        if (rc > 2 && os_mbuf_append(g_nlip_mbuf, &hdr[2], rc - 2)) {
+            rc = -1;
+            goto err;
+        }
 
-        data += sizeof(uint16_t);
-        len -= sizeof(uint16_t);
+        data += 4;
+        len -= 4;
     }
 
-    copy_len = min(g_nlip_expected_len - OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len,
-            len);
-
-    rc = os_mbuf_copyinto(g_nlip_mbuf, OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len,
-            data, copy_len);
-    if (rc != 0) {
+    /* Decoded straight into the packet. */
+    rc = base64_decoder_mbuf(&bd, data, len, g_nlip_mbuf);
+    if (rc < 0 || base64_decoder_finish(&bd)) {
+        rc = -1;
         goto err;
     }
+    if (OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len > g_nlip_expected_len) {
+        os_mbuf_adj(g_nlip_mbuf, g_nlip_expected_len -
+          OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len);
+    }
 
     if (OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len == g_nlip_expected_len) {
         if (g_shell_nlip_in_func) {
@@ -388,6 +588,246 @@ err:
     return (rc);
 }
 
+#if MYNEWT_VAL(SHELL_NLIP_BINARY)
+/*
+ * Gives up on the frame being received.  The rest of it is discarded, so
+ * that it doesn't reach the console as text.
+ */
+static void
+shell_nlip_bin_rx_abort(void)
+{
+    if (g_shell_nlip_bin.rx_om) {
+        os_mbuf_free_chain(g_shell_nlip_bin.rx_om);
+        g_shell_nlip_bin.rx_om = NULL;
+    }
+    g_shell_nlip_bin.rx_last = NULL;
+    g_shell_nlip_bin.rx_open = 0;
+    g_shell_nlip_bin.rx_esc = 0;
+    g_shell_nlip_bin.rx_discard = 1;
+}
+
+/*
+ * Adds a byte to the frame being received.  Written straight into the tail
+ * of the chain; os_mbuf_append() would walk the chain for every byte.
+ */
+static int
+shell_nlip_bin_rx_byte(uint8_t byte)
+{
+    struct os_mbuf *om;
+    uint8_t *hdr;
+    uint16_t len;
+
+    om = g_shell_nlip_bin.rx_last;
+    if (om == NULL) {
+        om = os_msys_get_pkthdr(0, 0);
+        if (om == NULL) {
+            return -1;
+        }
+        g_shell_nlip_bin.rx_om = om;
+        g_shell_nlip_bin.rx_last = om;
+    } else if (OS_MBUF_TRAILINGSPACE(om) == 0) {
+        om = os_msys_get(0, 0);
+        if (om == NULL) {
+            return -1;
+        }
+        SLIST_NEXT(g_shell_nlip_bin.rx_last, om_next) = om;
+        g_shell_nlip_bin.rx_last = om;
+    }
+    om->om_data[om->om_len++] = byte;
+    om = g_shell_nlip_bin.rx_om;
+    OS_MBUF_PKTHDR(om)->omp_len++;
+
+    /* Give up on bad lengths, and on frames running past their length. */
+    if (OS_MBUF_PKTHDR(om)->omp_len >= 2) {
+        hdr = om->om_data;
+        len = (hdr[0] << 8) | hdr[1];
+        if (len < sizeof(uint16_t) ||
+            len > MYNEWT_VAL(SHELL_NLIP_BIN_MAX_LEN) ||
+            OS_MBUF_PKTHDR(om)->omp_len > len + 2) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Console receive filter; called from the UART interrupt.  Consumes bytes
+ * between frame delimiters, and passes everything else to the console.
+ * After an error, the rest of the frame is consumed and dropped.
+ */
+int
+shell_nlip_bin_rx_char(void *arg, uint8_t data)
+{
+    if (data == SHELL_NLIP_BIN_END) {
+        if (g_shell_nlip_bin.rx_om == NULL) {
+            /*
+             * Opening delimiter, back-to-back delimiters, or the end of a
+             * frame being discarded; which may as well open the next.
+             */
+            g_shell_nlip_bin.rx_open = 1;
+            g_shell_nlip_bin.rx_discard = 0;
+        } else {
+            os_mqueue_put(&g_shell_nlip_bin_mq, shell_evq_get(),
+                          g_shell_nlip_bin.rx_om);
+            g_shell_nlip_bin.rx_om = NULL;
+            g_shell_nlip_bin.rx_open = 0;
+        }
+        g_shell_nlip_bin.rx_last = NULL;
+        g_shell_nlip_bin.rx_esc = 0;
+        return (0);
+    }
+    if (g_shell_nlip_bin.rx_discard) {
+        return (0);
+    }
+    if (!g_shell_nlip_bin.rx_open) {
+        return (-1);
+    }
+
+    if (g_shell_nlip_bin.rx_om == NULL && !g_shell_nlip_bin.rx_esc &&
+        data != SHELL_NLIP_BIN_ESC &&
+        (data << 8) > MYNEWT_VAL(SHELL_NLIP_BIN_MAX_LEN)) {
+        /*
+         * No valid length starts with this; most likely text typed after
+         * a stray END.  Leave it to the console.
+         */
+        g_shell_nlip_bin.rx_open = 0;
+        return (-1);
+    }
+
+    if (g_shell_nlip_bin.rx_esc) {
+        g_shell_nlip_bin.rx_esc = 0;
+        if (data == SHELL_NLIP_BIN_ESC_END) {
+            data = SHELL_NLIP_BIN_END;
+        } else if (data == SHELL_NLIP_BIN_ESC_ESC) {
+            data = SHELL_NLIP_BIN_ESC;
+        } else {
+            shell_nlip_bin_rx_abort();
+            return (0);
+        }
+    } else if (data == SHELL_NLIP_BIN_ESC) {
+        g_shell_nlip_bin.rx_esc = 1;
+        return (0);
+    }
+
+    if (shell_nlip_bin_rx_byte(data)) {
+        shell_nlip_bin_rx_abort();
+    }
+    return (0);
+}
+
+static void
+shell_nlip_bin_rx_ev(struct os_event *ev)
+{
+    struct os_mbuf *m;
+    struct os_mbuf *tmp;
+    uint16_t len;
+    uint16_t crc;
+
+    while (1) {
+        m = os_mqueue_get(&g_shell_nlip_bin_mq);
+        if (!m) {
+            break;
+        }
+
+        if (os_mbuf_copydata(m, 0, sizeof(len), &len)) {
+            goto drop;
+        }
+        len = ntohs(len);
+        os_mbuf_adj(m, sizeof(len));
+        if (OS_MBUF_PKTHDR(m)->omp_len != len || len < sizeof(crc)) {
+            goto drop;
+        }
+
+        crc = CRC16_INITIAL_CRC;
+        for (tmp = m; tmp; tmp = SLIST_NEXT(tmp, om_next)) {
+            crc = crc16_ccitt(crc, tmp->om_data, tmp->om_len);
+        }
+        if (crc != 0) {
+            goto drop;
+        }
+        os_mbuf_adj(m, -(int)sizeof(crc));
+
+        g_shell_nlip_bin.tx_bin = 1;
+        if (g_shell_nlip_in_func) {
+            g_shell_nlip_in_func(m, g_shell_nlip_in_arg);
+            continue;
+        }
+drop:
+        os_mbuf_free_chain(m);
+    }
+}
+
+/*
+ * Escapes src into dst, which must have room for twice as many bytes.
+ * Returns the escaped length.
+ */
+static int
+shell_nlip_bin_escape(const uint8_t *src, int len, uint8_t *dst)
+{
+    int i;
+    int j;
+
+    for (i = 0, j = 0; i < len; i++) {
+        if (src[i] == SHELL_NLIP_BIN_END) {
+            dst[j++] = SHELL_NLIP_BIN_ESC;
+            dst[j++] = SHELL_NLIP_BIN_ESC_END;
+        } else if (src[i] == SHELL_NLIP_BIN_ESC) {
+            dst[j++] = SHELL_NLIP_BIN_ESC;
+            dst[j++] = SHELL_NLIP_BIN_ESC_ESC;
+        } else {
+            dst[j++] = src[i];
+        }
+    }
+    return j;
+}
+
+static int
+shell_nlip_bin_mtx(struct os_mbuf *m)
+{
+#define SHELL_NLIP_BIN_MTX_BUF_SIZE (32)
+    uint8_t escbuf[SHELL_NLIP_BIN_MTX_BUF_SIZE * 2];
+    uint8_t hdr[2];
+    uint8_t end;
+    struct os_mbuf *tmp;
+    uint16_t crc;
+    uint16_t totlen;
+    int off;
+    int dlen;
+    int elen;
+
+    crc = CRC16_INITIAL_CRC;
+    for (tmp = m; tmp; tmp = SLIST_NEXT(tmp, om_next)) {
+        crc = crc16_ccitt(crc, tmp->om_data, tmp->om_len);
+    }
+    totlen = OS_MBUF_PKTHDR(m)->omp_len + sizeof(crc);
+
+    end = SHELL_NLIP_BIN_END;
+    console_write_raw((char *)&end, 1);
+
+    hdr[0] = totlen >> 8;
+    hdr[1] = totlen;
+    elen = shell_nlip_bin_escape(hdr, sizeof(hdr), escbuf);
+    console_write_raw((char *)escbuf, elen);
+
+    for (tmp = m; tmp; tmp = SLIST_NEXT(tmp, om_next)) {
+        for (off = 0; off < tmp->om_len; off += dlen) {
+            dlen = min(tmp->om_len - off, SHELL_NLIP_BIN_MTX_BUF_SIZE);
+            elen = shell_nlip_bin_escape(tmp->om_data + off, dlen, escbuf);
+            console_write_raw((char *)escbuf, elen);
+        }
+    }
+
+    hdr[0] = crc >> 8;
+    hdr[1] = crc;
+    elen = shell_nlip_bin_escape(hdr, sizeof(hdr), escbuf);
+    console_write_raw((char *)escbuf, elen);
+
+    console_write_raw((char *)&end, 1);
+
+    return (0);
+}
+#endif
+
 int
 shell_nlip_input_register(shell_nlip_input_func_t nf, void *arg)
 {
@@ -417,7 +857,9 @@ shell_read_console(void)
 {
     int rc;
     int full_line;
+    int prompt;
 
+    prompt = 0;
     while (1) {
         rc = console_read(shell_line + shell_line_len,
           MYNEWT_VAL(SHELL_MAX_INPUT_LEN) - shell_line_len, &full_line);
@@ -426,28 +868,35 @@ shell_read_console(void)
         }
         shell_line_len += rc;
         if (full_line) {
-            if (shell_line_len > 2) {
-                if (shell_line[0] == SHELL_NLIP_PKT_START1 &&
-                        shell_line[1] == SHELL_NLIP_PKT_START2) {
-                    if (g_nlip_mbuf) {
-                        os_mbuf_free_chain(g_nlip_mbuf);
-                        g_nlip_mbuf = NULL;
-                    }
-                    g_nlip_expected_len = 0;
-
-                    rc = shell_nlip_process(&shell_line[2], shell_line_len - 2);
-                } else if (shell_line[0] == SHELL_NLIP_DATA_START1 &&
-                        shell_line[1] == SHELL_NLIP_DATA_START2) {
-                    rc = shell_nlip_process(&shell_line[2], shell_line_len - 2);
-                } else {
-                    shell_process_command(shell_line, shell_line_len);
+            if (shell_line_len > 2 &&
+                    shell_line[0] == SHELL_NLIP_PKT_START1 &&
+                    shell_line[1] == SHELL_NLIP_PKT_START2) {
+                if (g_nlip_mbuf) {
+                    os_mbuf_free_chain(g_nlip_mbuf);
+                    g_nlip_mbuf = NULL;
                 }
+                g_nlip_expected_len = 0;
+#if MYNEWT_VAL(SHELL_NLIP_BINARY)
+                g_shell_nlip_bin.tx_bin = 0;
+#endif
+
+                rc = shell_nlip_process(&shell_line[2], shell_line_len - 2);
+            } else if (shell_line_len > 2 &&
+                    shell_line[0] == SHELL_NLIP_DATA_START1 &&
+                    shell_line[1] == SHELL_NLIP_DATA_START2) {
+                rc = shell_nlip_process(&shell_line[2], shell_line_len - 2);
             } else {
-                shell_process_command(shell_line, shell_line_len);
+                if (!shell_exec_script(shell_line)) {
+                    console_printf("\n");
+                }
+                prompt = 1;
             }
             shell_line_len = 0;
         }
     }
+    if (prompt) {
+        console_print_prompt();
+    }
 }
 
 static void
@@ -456,6 +905,54 @@ shell_event_console_rdy(struct os_event *ev)
     shell_read_console();
 }
 
+/*
+ * Completes the command name being typed on the console.  If there is
+ * nothing to add, the candidates are listed.
+ */
+static void
+shell_event_tab(struct os_event *ev)
+{
+    char prefix[SHELL_COMPLETE_MAX_LEN];
+    const char *match;
+    char *argv[2];
+    int common_len;
+    int len;
+    int cnt;
+
+    len = console_line_get(prefix, sizeof(prefix));
+    if (len == sizeof(prefix) - 1 || strchr(prefix, ' ')) {
+        /* Only command names are completed. */
+        return;
+    }
+
+    cnt = shell_cmd_complete(prefix, &match, &common_len);
+    if (cnt <= 0) {
+        return;
+    }
+    if (common_len > len) {
+        console_line_insert(match + len, common_len - len);
+        if (cnt == 1) {
+            console_line_insert(" ", 1);
+        }
+    } else if (cnt > 1) {
+        console_printf("\n");
+        argv[0] = "?";
+        argv[1] = prefix;
+        shell_help_cmd(2, argv);
+        console_print_prompt();
+        console_write(prefix, len);
+    }
+}
+
+/*
+ * Called from the console receive interrupt when tab is typed.
+ */
+static void
+shell_console_tab_cb(void)
+{
+    os_eventq_put(shell_evq_get(), &shell_tab_ev);
+}
+
 static void
 shell_event_data_in(struct os_event *ev)
 {
@@ -470,7 +967,15 @@ shell_event_data_in(struct os_event *ev)
             break;
         }
 
+#if MYNEWT_VAL(SHELL_NLIP_BINARY)
+        if (g_shell_nlip_bin.tx_bin) {
+            (void) shell_nlip_bin_mtx(m);
+        } else {
+            (void) shell_nlip_mtx(m);
+        }
+#else
         (void) shell_nlip_mtx(m);
+#endif
 
         os_mbuf_free_chain(m);
     }
@@ -504,22 +1009,25 @@ shell_echo_cmd(int argc, char **argv)
 static int
 shell_help_cmd(int argc, char **argv)
 {
+    int first;
+    int last;
     int rc;
-    int i = 0;
-    struct shell_cmd *sc;
+    int i;
 
     rc = shell_cmd_list_lock();
     if (rc != 0) {
         return -1;
     }
+    /* "? <prefix>" lists only the commands starting with prefix. */
+    shell_cmd_prefix_range(argc > 1 ? argv[1] : "", &first, &last);
     console_printf("Commands:\n");
-    STAILQ_FOREACH(sc, &g_shell_cmd_list, sc_next) {
-        console_printf("%9s ", sc->sc_cmd);
-        if (i++ % SHELL_HELP_PER_LINE == SHELL_HELP_PER_LINE - 1) {
+    for (i = first; i < last; i++) {
+        console_printf("%9s ", g_shell_cmds[i]->sc_cmd);
+        if ((i - first) % SHELL_HELP_PER_LINE == SHELL_HELP_PER_LINE - 1) {
             console_printf("\n");
         }
     }
-    if (i % SHELL_HELP_PER_LINE) {
+    if ((last - first) % SHELL_HELP_PER_LINE) {
         console_printf("\n");
     }
     shell_cmd_list_unlock();
@@ -567,4 +1075,9 @@ shell_init(void)
 
     os_mqueue_init(&g_shell_nlip_mq, shell_event_data_in, NULL);
     console_init(shell_console_rx_cb);
+    console_tab_set(shell_console_tab_cb);
+#if MYNEWT_VAL(SHELL_NLIP_BINARY)
+    os_mqueue_init(&g_shell_nlip_bin_mq, shell_nlip_bin_rx_ev, NULL);
+    console_rx_filter_set(shell_nlip_bin_rx_char, NULL);
+#endif
 }
@@ -0,0 +1,203 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "crc/crc16.h"
+#include "shell_test.h"
+
+TEST_CASE_DECL(shell_test_register)
+TEST_CASE_DECL(shell_test_complete)
+TEST_CASE_DECL(shell_test_script)
+TEST_CASE_DECL(shell_test_nlip_bin)
+TEST_CASE_DECL(shell_test_nlip_bin_err)
+
+char shell_test_log[256];
+
+uint8_t shell_test_pkt[512];
+int shell_test_pkt_len;
+int shell_test_pkt_cnt;
+
+static struct os_eventq shell_test_evq;
+
+/*
+ * Logs the command line it was run with.
+ */
+static int
+shell_test_cmd(int argc, char **argv)
+{
+    int i;
+
+    for (i = 0; i < argc; i++) {
+        if (i > 0) {
+            strcat(shell_test_log, " ");
+        }
+        strcat(shell_test_log, argv[i]);
+    }
+    TEST_ASSERT(argv[argc] == NULL);
+    strcat(shell_test_log, ";");
+    return 0;
+}
+
+static struct shell_cmd shell_test_cmds[] = {
+    { .sc_cmd = "zz_stat", .sc_cmd_func = shell_test_cmd },
+    { .sc_cmd = "zz_log", .sc_cmd_func = shell_test_cmd },
+    { .sc_cmd = "zz_stats", .sc_cmd_func = shell_test_cmd },
+    { .sc_cmd = "zz_status", .sc_cmd_func = shell_test_cmd },
+    { .sc_cmd = "zz_reset", .sc_cmd_func = shell_test_cmd },
+};
+
+static int
+shell_test_nlip_in(struct os_mbuf *m, void *arg)
+{
+    int len;
+
+    len = OS_MBUF_PKTLEN(m);
+    TEST_ASSERT_FATAL(shell_test_pkt_len + len <= sizeof(shell_test_pkt));
+    os_mbuf_copydata(m, 0, len, shell_test_pkt + shell_test_pkt_len);
+    os_mbuf_free_chain(m);
+
+    shell_test_pkt_len += len;
+    shell_test_pkt_cnt++;
+    return 0;
+}
+
+void
+shell_test_reset(void)
+{
+    shell_test_log[0] = '\0';
+    shell_test_pkt_len = 0;
+    shell_test_pkt_cnt = 0;
+}
+
+static int
+shell_test_bin_esc(const uint8_t *data, int len, uint8_t *frame)
+{
+    int i;
+    int j;
+
+    for (i = 0, j = 0; i < len; i++) {
+        if (data[i] == SHELL_NLIP_BIN_END) {
+            frame[j++] = SHELL_NLIP_BIN_ESC;
+            frame[j++] = SHELL_NLIP_BIN_ESC_END;
+        } else if (data[i] == SHELL_NLIP_BIN_ESC) {
+            frame[j++] = SHELL_NLIP_BIN_ESC;
+            frame[j++] = SHELL_NLIP_BIN_ESC_ESC;
+        } else {
+            frame[j++] = data[i];
+        }
+    }
+    return j;
+}
+
+/*
+ * Builds a binary NLIP frame holding data; returns its length.
+ */
+int
+shell_test_bin_frame(const uint8_t *data, int len, uint8_t *frame)
+{
+    uint8_t hdr[2];
+    uint16_t crc;
+    int off;
+
+    off = 0;
+    frame[off++] = SHELL_NLIP_BIN_END;
+    hdr[0] = (len + 2) >> 8;
+    hdr[1] = len + 2;
+    off += shell_test_bin_esc(hdr, sizeof(hdr), frame + off);
+    off += shell_test_bin_esc(data, len, frame + off);
+    crc = crc16_ccitt(CRC16_INITIAL_CRC, data, len);
+    hdr[0] = crc >> 8;
+    hdr[1] = crc;
+    off += shell_test_bin_esc(hdr, sizeof(hdr), frame + off);
+    frame[off++] = SHELL_NLIP_BIN_END;
+
+    return off;
+}
+
+/*
+ * Feeds data to the binary NLIP receiver, and processes the frames it
+ * queues.  Returns the number of bytes it passed on to the console.
+ */
+int
+shell_test_bin_rx(const uint8_t *data, int len)
+{
+    struct os_eventq *evq;
+    struct os_event *ev;
+    int cnt;
+    int i;
+
+    cnt = 0;
+    for (i = 0; i < len; i++) {
+        if (shell_nlip_bin_rx_char(NULL, data[i])) {
+            cnt++;
+        }
+    }
+
+    evq = &shell_test_evq;
+    while ((ev = os_eventq_poll(&evq, 1, 0)) != NULL) {
+        ev->ev_cb(ev);
+    }
+    return cnt;
+}
+
+static void
+shell_test_init(void)
+{
+    int rc;
+    int i;
+
+    os_eventq_init(&shell_test_evq);
+    shell_evq_set(&shell_test_evq);
+    shell_nlip_input_register(shell_test_nlip_in, NULL);
+
+    for (i = 0; i < sizeof(shell_test_cmds) / sizeof(shell_test_cmds[0]);
+         i++) {
+        rc = shell_cmd_register(&shell_test_cmds[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+TEST_SUITE(shell_test_suite)
+{
+    shell_test_init();
+
+    shell_test_register();
+    shell_test_complete();
+    shell_test_script();
+    shell_test_nlip_bin();
+    shell_test_nlip_bin_err();
+}
+
+int
+shell_test_all(void)
+{
+    shell_test_suite();
+    return tu_any_failed;
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(void)
+{
+    ts_config.ts_print_results = 1;
+    tu_init();
+
+    shell_test_all();
+
+    return tu_any_failed;
+}
+#endif
@@ -0,0 +1,48 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _SHELL_TEST_H
+#define _SHELL_TEST_H
+
+#include <string.h>
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+#include "shell/shell.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Commands run by the test commands, as "name arg1 arg2;..." */
+extern char shell_test_log[256];
+
+/* NLIP packets received, back to back. */
+extern uint8_t shell_test_pkt[512];
+extern int shell_test_pkt_len;
+extern int shell_test_pkt_cnt;
+
+void shell_test_reset(void);
+int shell_test_bin_frame(const uint8_t *data, int len, uint8_t *frame);
+int shell_test_bin_rx(const uint8_t *data, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SHELL_TEST_H */
@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "shell_test.h"
+
+TEST_CASE(shell_test_complete)
+{
+    const char *match;
+    int len;
+    int cnt;
+
+    /* zz_stat, zz_stats, zz_status */
+    cnt = shell_cmd_complete("zz_sta", &match, &len);
+    TEST_ASSERT(cnt == 3);
+    TEST_ASSERT(strcmp(match, "zz_stat") == 0);
+    TEST_ASSERT(len == strlen("zz_stat"));
+
+    cnt = shell_cmd_complete("zz_statu", &match, &len);
+    TEST_ASSERT(cnt == 1);
+    TEST_ASSERT(strcmp(match, "zz_status") == 0);
+    TEST_ASSERT(len == strlen("zz_status"));
+
+    /* zz_log, zz_reset, zz_stat... share just the prefix. */
+    cnt = shell_cmd_complete("zz", &match, &len);
+    TEST_ASSERT(cnt >= 5);
+    TEST_ASSERT(len == strlen("zz_"));
+
+    /* A full name matches itself. */
+    cnt = shell_cmd_complete("zz_reset", &match, &len);
+    TEST_ASSERT(cnt == 1);
+    TEST_ASSERT(strcmp(match, "zz_reset") == 0);
+
+    cnt = shell_cmd_complete("zz_x", &match, &len);
+    TEST_ASSERT(cnt == 0);
+
+    cnt = shell_cmd_complete("zz_resetx", NULL, NULL);
+    TEST_ASSERT(cnt == 0);
+}
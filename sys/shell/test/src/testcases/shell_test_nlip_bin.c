@@ -0,0 +1,56 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "shell_test.h"
+
+TEST_CASE(shell_test_nlip_bin)
+{
+    uint8_t data[150];
+    uint8_t frame[2 * sizeof(data) + 8];
+    uint8_t two[2 * sizeof(frame)];
+    int len;
+    int i;
+
+    /* Delimiters and escape chars in the data, spanning several mbufs. */
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = i % 3 ? SHELL_NLIP_BIN_END : SHELL_NLIP_BIN_ESC + i;
+    }
+    shell_test_reset();
+    len = shell_test_bin_frame(data, sizeof(data), frame);
+    TEST_ASSERT(shell_test_bin_rx(frame, len) == 0);
+    TEST_ASSERT(shell_test_pkt_cnt == 1);
+    TEST_ASSERT(shell_test_pkt_len == sizeof(data));
+    TEST_ASSERT(memcmp(shell_test_pkt, data, sizeof(data)) == 0);
+
+    /* Back to back frames. */
+    shell_test_reset();
+    len = shell_test_bin_frame(data, 10, two);
+    len += shell_test_bin_frame(data + 10, 20, two + len);
+    TEST_ASSERT(shell_test_bin_rx(two, len) == 0);
+    TEST_ASSERT(shell_test_pkt_cnt == 2);
+    TEST_ASSERT(shell_test_pkt_len == 30);
+    TEST_ASSERT(memcmp(shell_test_pkt, data, 30) == 0);
+
+    /* Text around frames goes to the console. */
+    shell_test_reset();
+    TEST_ASSERT(shell_test_bin_rx((uint8_t *)"echo\n", 5) == 5);
+    len = shell_test_bin_frame(data, 4, frame);
+    TEST_ASSERT(shell_test_bin_rx(frame, len) == 0);
+    TEST_ASSERT(shell_test_bin_rx((uint8_t *)"echo\n", 5) == 5);
+    TEST_ASSERT(shell_test_pkt_cnt == 1);
+}
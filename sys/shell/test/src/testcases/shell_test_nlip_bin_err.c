@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "shell_test.h"
+
+TEST_CASE(shell_test_nlip_bin_err)
+{
+    static const uint8_t text[] = "echo hi\n";
+    uint8_t data[MYNEWT_VAL(SHELL_NLIP_BIN_MAX_LEN)];
+    uint8_t frame[2 * sizeof(data) + 8];
+    uint8_t good[32];
+    int good_len;
+    int len;
+
+    memset(data, 0x55, sizeof(data));
+    good_len = shell_test_bin_frame(data, 8, good);
+
+    /* A stray END doesn't swallow the text after it. */
+    shell_test_reset();
+    frame[0] = SHELL_NLIP_BIN_END;
+    TEST_ASSERT(shell_test_bin_rx(frame, 1) == 0);
+    TEST_ASSERT(shell_test_bin_rx(text, sizeof(text) - 1) ==
+                sizeof(text) - 1);
+    TEST_ASSERT(shell_test_bin_rx(good, good_len) == 0);
+    TEST_ASSERT(shell_test_pkt_cnt == 1);
+
+    /* Bad CRC; dropped. */
+    shell_test_reset();
+    len = shell_test_bin_frame(data, 8, frame);
+    frame[len - 2] ^= 1;
+    TEST_ASSERT(shell_test_bin_rx(frame, len) == 0);
+    TEST_ASSERT(shell_test_pkt_cnt == 0);
+
+    /*
+     * Bad escape; the rest of the frame is dropped, not passed to the
+     * console, and the next frame is received.
+     */
+    shell_test_reset();
+    len = shell_test_bin_frame(data, 8, frame);
+    frame[4] = SHELL_NLIP_BIN_ESC;
+    frame[5] = 'x';
+    TEST_ASSERT(shell_test_bin_rx(frame, len) == 0);
+    TEST_ASSERT(shell_test_bin_rx(good, good_len) == 0);
+    TEST_ASSERT(shell_test_pkt_cnt == 1);
+
+    /* Frame longer than its length field. */
+    shell_test_reset();
+    len = shell_test_bin_frame(data, 8, frame);
+    frame[2]--;
+    TEST_ASSERT(shell_test_bin_rx(frame, len) == 0);
+    TEST_ASSERT(shell_test_bin_rx(good, good_len) == 0);
+    TEST_ASSERT(shell_test_pkt_cnt == 1);
+
+    /* Length field over SHELL_NLIP_BIN_MAX_LEN. */
+    shell_test_reset();
+    len = shell_test_bin_frame(data, sizeof(data), frame);
+    TEST_ASSERT(shell_test_bin_rx(frame, len) == 0);
+    TEST_ASSERT(shell_test_pkt_cnt == 0);
+    len = shell_test_bin_frame(data, sizeof(data) - 2, frame);
+    TEST_ASSERT(shell_test_bin_rx(frame, len) == 0);
+    TEST_ASSERT(shell_test_pkt_cnt == 1);
+    TEST_ASSERT(shell_test_pkt_len == sizeof(data) - 2);
+}
@@ -0,0 +1,43 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "shell_test.h"
+
+TEST_CASE(shell_test_register)
+{
+    static struct shell_cmd dup = { .sc_cmd = "zz_log" };
+    static struct shell_cmd again = { .sc_cmd = "zz_again" };
+    char script[] = "zz_log";
+    int rc;
+
+    /* Another command by the same name is refused. */
+    rc = shell_cmd_register(&dup);
+    TEST_ASSERT(rc == OS_EINVAL);
+
+    /* The same command twice is fine, and is kept once. */
+    rc = shell_cmd_register(&again);
+    TEST_ASSERT(rc == 0);
+    rc = shell_cmd_register(&again);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(shell_cmd_complete("zz_again", NULL, NULL) == 1);
+
+    /* Lookups still find the original. */
+    shell_test_reset();
+    TEST_ASSERT(shell_exec_script(script) == 1);
+    TEST_ASSERT(strcmp(shell_test_log, "zz_log;") == 0);
+}
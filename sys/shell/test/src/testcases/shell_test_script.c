@@ -0,0 +1,48 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "shell_test.h"
+
+TEST_CASE(shell_test_script)
+{
+    char script[] =
+        "zz_stat a b\n"
+        "\n"
+        "# zz_log\n"
+        "zz_log  c\r\n"
+        "zz_nonexistent 1\n"
+        "zz_status\n"
+        "zz_reset";
+    char empty[] = "";
+    char line[] = "zz_stats x";
+    int cnt;
+
+    shell_test_reset();
+    cnt = shell_exec_script(script);
+    TEST_ASSERT(cnt == 5);
+    TEST_ASSERT(strcmp(shell_test_log,
+                       "zz_stat a b;zz_log c;zz_status;zz_reset;") == 0);
+
+    shell_test_reset();
+    TEST_ASSERT(shell_exec_script(empty) == 0);
+    TEST_ASSERT(shell_test_log[0] == '\0');
+
+    /* A single line, as typed on the console. */
+    TEST_ASSERT(shell_exec_script(line) == 1);
+    TEST_ASSERT(strcmp(shell_test_log, "zz_stats x;") == 0);
+}
@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include "syscfg/syscfg.h"
 #include "os/queue.h"
+#include "os/os_time.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,14 +33,27 @@ struct stats_name_map {
     char *snm_name;
 } __attribute__((packed));
 
+/* The name map has one entry per statistic, in declaration order. */
+#define STATS_HDR_F_MAP_DIRECT  (0x01)
+/* The name map is sorted by ascending offset (may be partial). */
+#define STATS_HDR_F_MAP_SORTED  (0x02)
+/* The section is a log2 histogram (STATS_HIST_SECT). */
+#define STATS_HDR_F_HIST        (0x04)
+/* The section is a moving rate counter (STATS_RATE_SECT). */
+#define STATS_HDR_F_RATE        (0x08)
+
 struct stats_hdr {
     char *s_name;
     uint8_t s_size;
     uint8_t s_cnt;
-    uint16_t s_pad1;
+    uint8_t s_flags;
+    uint8_t s_pad1;
 #if MYNEWT_VAL(STATS_NAMES)
     const struct stats_name_map *s_map;
     int s_map_cnt;
+#endif
+#if MYNEWT_VAL(STATS_NEWTMGR)
+    uint32_t s_hash;
 #endif
     STAILQ_ENTRY(stats_hdr) s_next;
 };
@@ -80,6 +94,72 @@ STATS_SECT_DECL(__name) {                   \
 #define STATS_CLEAR(__sectvarname, __var)        \
     ((__sectvarname).STATS_SECT_VAR(__var) = 0)
 
+/*
+ * Histogram sections.  A histogram is a section of 32-bit buckets; a value v
+ * is counted in bucket n, where n is the number of significant bits in v
+ * (bucket 0 counts zeros, bucket 1 counts ones, bucket 2 counts 2-3, ...).
+ * Values which don't fit are counted in the last bucket.  Buckets are named
+ * by their inclusive upper bound ("le0", "le1", "le3", ..., "inf").
+ */
+#define STATS_HIST_SECT(__name, __nbuckets)                                 \
+STATS_SECT_START(__name)                                                    \
+    uint32_t s_bucket[(__nbuckets)];                                        \
+STATS_SECT_END
+
+#define STATS_HIST_CNT(__sectvarname)                                       \
+    (sizeof((__sectvarname).s_bucket) / sizeof((__sectvarname).s_bucket[0]))
+
+#define STATS_HIST_ADD(__sectvarname, __val)                                \
+    stats_hist_add((__sectvarname).s_bucket, STATS_HIST_CNT(__sectvarname), \
+                   (__val))
+
+static inline void
+stats_hist_add(uint32_t *buckets, int cnt, uint32_t val)
+{
+    int n;
+
+    n = (val == 0) ? 0 : 32 - __builtin_clz(val);
+    if (n >= cnt) {
+        n = cnt - 1;
+    }
+    buckets[n]++;
+}
+
+/*
+ * Moving rate sections.  A rate section exports two 32-bit statistics,
+ * "total" (number of events) and "rate" (events per second, smoothed over
+ * one second windows).  The window bookkeeping isn't exported.
+ */
+struct stats_rate {
+    uint32_t sr_total;
+    uint32_t sr_rate;
+    uint32_t sr_win_cnt;
+    os_time_t sr_win_end;
+};
+
+#define STATS_RATE_SECT(__name)                                             \
+STATS_SECT_START(__name)                                                    \
+    struct stats_rate s_rate;                                               \
+STATS_SECT_END
+
+#define STATS_RATE_INCN(__sectvarname, __n)                                 \
+    stats_rate_incn(&(__sectvarname).s_rate, (__n))
+
+#define STATS_RATE_INC(__sectvarname)                                       \
+    STATS_RATE_INCN(__sectvarname, 1)
+
+void stats_rate_roll(struct stats_rate *sr);
+
+static inline void
+stats_rate_incn(struct stats_rate *sr, uint32_t n)
+{
+    sr->sr_total += n;
+    sr->sr_win_cnt += n;
+    if (OS_TIME_TICK_GEQ(os_time_get(), sr->sr_win_end)) {
+        stats_rate_roll(sr);
+    }
+}
+
 #if MYNEWT_VAL(STATS_NAMES)
 
 #define STATS_NAME_MAP_NAME(__sectname) g_stats_map_ ## __sectname
@@ -115,6 +195,8 @@ int stats_init_and_reg(struct stats_hdr *shdr, uint8_t size, uint8_t cnt,
                        const struct stats_name_map *map, uint8_t map_cnt,
                        char *name);
 void stats_reset(struct stats_hdr *shdr);
+int stats_hist_init(struct stats_hdr *shdr, uint8_t cnt);
+int stats_rate_init(struct stats_hdr *shdr);
 
 typedef int (*stats_walk_func_t)(struct stats_hdr *, void *, char *,
         uint16_t);
@@ -124,6 +206,7 @@ typedef int (*stats_group_walk_func_t)(struct stats_hdr *, void *);
 int stats_group_walk(stats_group_walk_func_t, void *);
 
 struct stats_hdr *stats_group_find(char *name);
+uint32_t stats_group_hash(struct stats_hdr *hdr);
 
 /* Private */
 #if MYNEWT_VAL(STATS_NEWTMGR)
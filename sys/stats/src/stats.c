@@ -18,6 +18,7 @@
  */
 
 #include <assert.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -59,6 +60,17 @@
  *
  * - STATS_SECT_ENTRY64(): 64-bits.  Useful for storing chunks of data.
  *
+ * Two special kinds of sections are built on top of these:
+ *
+ * - STATS_HIST_SECT(): a log2 histogram of 32-bit buckets, updated with
+ *   STATS_HIST_ADD() and initialized with stats_hist_init().  Useful for
+ *   latencies and sizes.
+ *
+ * - STATS_RATE_SECT(): a moving events-per-second counter, updated with
+ *   STATS_RATE_INC() and initialized with stats_rate_init().
+ *
+ * Both are walked, displayed and exported like any other section.
+ *
  * Following the statics entry declaration is the statistic names declaration.
  * This is compiled out when STATS_NAME_ENABLE is set to 0.  This declaration
  * is const, and therefore can be located in .text, not .data.
@@ -81,6 +93,100 @@ STATS_NAME_END(stats)
 STAILQ_HEAD(, stats_hdr) g_stats_registry =
     STAILQ_HEAD_INITIALIZER(g_stats_registry);
 
+#if MYNEWT_VAL(STATS_NAMES)
+static const struct stats_name_map STATS_NAME_MAP_NAME(stats_rate)[] = {
+    { sizeof(struct stats_hdr) + offsetof(struct stats_rate, sr_total),
+      "total" },
+    { sizeof(struct stats_hdr) + offsetof(struct stats_rate, sr_rate),
+      "rate" },
+};
+#endif
+
+static void stats_rate_update(struct stats_rate *sr);
+
+
+#if MYNEWT_VAL(STATS_NAMES)
+/**
+ * Classify a statistics name map, so that stats_walk() doesn't need to
+ * search the map for every entry.  Called once, when the statistics section
+ * is initialized.
+ *
+ * @return STATS_HDR_F_MAP_xxx flags describing the map layout.
+ */
+static uint8_t
+stats_map_flags(const struct stats_name_map *map, int map_cnt, uint8_t size,
+                uint8_t cnt)
+{
+    uint8_t flags;
+    int i;
+
+    if (map == NULL || map_cnt == 0) {
+        return (0);
+    }
+
+    flags = STATS_HDR_F_MAP_SORTED;
+    if (map_cnt == cnt) {
+        flags |= STATS_HDR_F_MAP_DIRECT;
+    }
+
+    for (i = 0; i < map_cnt; i++) {
+        if (map[i].snm_off != sizeof(struct stats_hdr) + i * size) {
+            flags &= ~STATS_HDR_F_MAP_DIRECT;
+        }
+        if (i > 0 && map[i].snm_off <= map[i - 1].snm_off) {
+            flags &= ~STATS_HDR_F_MAP_SORTED;
+        }
+    }
+
+    return (flags);
+}
+
+/**
+ * Find the name of the statistic at offset cur.
+ *
+ * @param hdr The statistics section
+ * @param cur The offset of the statistic within the section
+ * @param idx Map search cursor; set to 0 before the first lookup of a walk
+ *            and preserved across calls with increasing offsets.
+ *
+ * @return the name of the statistic, NULL if it is unnamed.
+ */
+static char *
+stats_map_lookup(struct stats_hdr *hdr, uint16_t cur, int *idx)
+{
+    int i;
+
+    if (hdr->s_flags & STATS_HDR_F_MAP_DIRECT) {
+        return (hdr->s_map[(cur - sizeof(*hdr)) / hdr->s_size].snm_name);
+    }
+
+    if (hdr->s_flags & STATS_HDR_F_MAP_SORTED) {
+        /* Offsets are visited in ascending order, so the map only needs to
+         * be traversed once per walk.
+         */
+        while (*idx < hdr->s_map_cnt && hdr->s_map[*idx].snm_off < cur) {
+            (*idx)++;
+        }
+        if (*idx < hdr->s_map_cnt && hdr->s_map[*idx].snm_off == cur) {
+            return (hdr->s_map[*idx].snm_name);
+        }
+        return (NULL);
+    }
+
+    /* The stats name map contains two elements, an offset into the
+     * statistics entry structure, and the name corresponding with that
+     * offset.  This annotation allows for naming only certain statistics,
+     * and doesn't enforce ordering restrictions on the stats name map.
+     */
+    for (i = 0; i < hdr->s_map_cnt; ++i) {
+        if (hdr->s_map[i].snm_off == cur) {
+            return (hdr->s_map[i].snm_name);
+        }
+    }
+
+    return (NULL);
+}
+#endif
 
 /**
  * Walk a specific statistic entry, and call walk_func with arg for
@@ -101,16 +207,22 @@ int
 stats_walk(struct stats_hdr *hdr, stats_walk_func_t walk_func, void *arg)
 {
     char *name;
-    char name_buf[12];
+    char name_buf[16];
     uint16_t cur;
     uint16_t end;
     int ent_n;
     int len;
     int rc;
 #if MYNEWT_VAL(STATS_NAMES)
-    int i;
+    int map_idx;
+
+    map_idx = 0;
 #endif
 
+    if (hdr->s_flags & STATS_HDR_F_RATE) {
+        stats_rate_update((struct stats_rate *)(hdr + 1));
+    }
+
     cur = sizeof(*hdr);
     end = sizeof(*hdr) + (hdr->s_size * hdr->s_cnt);
 
@@ -121,17 +233,7 @@ stats_walk(struct stats_hdr *hdr, stats_walk_func_t walk_func, void *arg)
          */
         name = NULL;
 #if MYNEWT_VAL(STATS_NAMES)
-        /* The stats name map contains two elements, an offset into the
-         * statistics entry structure, and the name corresponding with that
-         * offset.  This annotation allows for naming only certain statistics,
-         * and doesn't enforce ordering restrictions on the stats name map.
-         */
-        for (i = 0; i < hdr->s_map_cnt; ++i) {
-            if (hdr->s_map[i].snm_off == cur) {
-                name = hdr->s_map[i].snm_name;
-                break;
-            }
-        }
+        name = stats_map_lookup(hdr, cur, &map_idx);
 #endif
         /* Do this check irrespective of whether MYNEWT_VALUE(STATS_NAMES)
          * is set.  Users may only partially name elements in the statistics
@@ -139,7 +241,16 @@ stats_walk(struct stats_hdr *hdr, stats_walk_func_t walk_func, void *arg)
          */
         if (name == NULL) {
             ent_n = (cur - sizeof(*hdr)) / hdr->s_size;
-            len = snprintf(name_buf, sizeof(name_buf), "s%d", ent_n);
+            if (hdr->s_flags & STATS_HDR_F_HIST) {
+                if (ent_n == hdr->s_cnt - 1) {
+                    len = snprintf(name_buf, sizeof(name_buf), "inf");
+                } else {
+                    len = snprintf(name_buf, sizeof(name_buf), "le%lu",
+                                   (1UL << ent_n) - 1);
+                }
+            } else {
+                len = snprintf(name_buf, sizeof(name_buf), "s%d", ent_n);
+            }
             name_buf[len] = '\0';
             name = name_buf;
         }
@@ -160,6 +271,150 @@ err:
     return (rc);
 }
 
+/**
+ * Closes the current window of a rate counter, and folds the number of
+ * events in that window into the smoothed rate.  Each window which has
+ * passed since halves the rate, so the result doesn't depend on how often
+ * the counter is updated or read.  Called from the update path once the
+ * window has expired.
+ *
+ * @param sr The rate counter to roll over.
+ */
+void
+stats_rate_roll(struct stats_rate *sr)
+{
+    os_time_t now;
+    uint32_t elapsed;
+    uint32_t windows;
+
+    now = os_time_get();
+    elapsed = (uint32_t)(now - sr->sr_win_end) + OS_TICKS_PER_SEC;
+    windows = elapsed / OS_TICKS_PER_SEC;
+
+    if (windows >= 32) {
+        sr->sr_rate = 0;
+    } else {
+        sr->sr_rate = ((uint64_t)sr->sr_rate + sr->sr_win_cnt) >> windows;
+    }
+    sr->sr_win_cnt = 0;
+    sr->sr_win_end += windows * OS_TICKS_PER_SEC;
+}
+
+/**
+ * Brings the rate of an idle counter up to date before it is reported.
+ */
+static void
+stats_rate_update(struct stats_rate *sr)
+{
+    if (OS_TIME_TICK_GEQ(os_time_get(), sr->sr_win_end)) {
+        stats_rate_roll(sr);
+    }
+}
+
+/**
+ * Initialize a histogram section declared with STATS_HIST_SECT().
+ *
+ * @param shdr The header of the histogram section
+ * @param cnt The number of buckets, STATS_HIST_CNT()
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+int
+stats_hist_init(struct stats_hdr *shdr, uint8_t cnt)
+{
+    int rc;
+
+    if (cnt == 0 || cnt > 32) {
+        return (OS_EINVAL);
+    }
+
+    rc = stats_init(shdr, STATS_SIZE_32, cnt, NULL, 0);
+    if (rc != 0) {
+        return (rc);
+    }
+    shdr->s_flags |= STATS_HDR_F_HIST;
+
+    return (0);
+}
+
+/**
+ * Initialize a rate section declared with STATS_RATE_SECT().
+ *
+ * @param shdr The header of the rate section
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+int
+stats_rate_init(struct stats_hdr *shdr)
+{
+    struct stats_rate *sr;
+    int rc;
+
+    rc = stats_init(shdr, STATS_SIZE_32, 2, STATS_NAME_INIT_PARMS(stats_rate));
+    if (rc != 0) {
+        return (rc);
+    }
+    shdr->s_flags |= STATS_HDR_F_RATE;
+
+    sr = (struct stats_rate *)(shdr + 1);
+    sr->sr_win_cnt = 0;
+    sr->sr_win_end = os_time_get() + OS_TICKS_PER_SEC;
+
+    return (0);
+}
+
+static uint32_t
+stats_hash_add(uint32_t hash, const void *data, int len)
+{
+    const uint8_t *p;
+    int i;
+
+    /* 32-bit FNV-1a */
+    p = data;
+    for (i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619;
+    }
+
+    return (hash);
+}
+
+static int
+stats_hash_walk(struct stats_hdr *hdr, void *arg, char *name, uint16_t off)
+{
+    uint32_t *hash;
+
+    hash = arg;
+    /* Include the terminating NUL so that the names are delimited. */
+    *hash = stats_hash_add(*hash, name, strlen(name) + 1);
+
+    return (0);
+}
+
+/**
+ * Compute the schema hash of a statistics section.  The hash covers the
+ * section name, the entry size, and the names of all entries; two sections
+ * with the same hash can be decoded with the same schema.
+ *
+ * @param hdr The statistics section to hash.
+ *
+ * @return the 32-bit schema hash.
+ */
+uint32_t
+stats_group_hash(struct stats_hdr *hdr)
+{
+    uint32_t hash;
+
+    hash = 2166136261UL;
+    if (hdr->s_name) {
+        hash = stats_hash_add(hash, hdr->s_name, strlen(hdr->s_name) + 1);
+    }
+    hash = stats_hash_add(hash, &hdr->s_size, sizeof(hdr->s_size));
+    stats_walk(hdr, stats_hash_walk, &hash);
+
+    return (hash);
+}
+
 /**
  * Initialize the stastics module.  Called before any of the statistics get
  * registered to initialize global structures, and register the default
@@ -216,9 +471,11 @@ stats_init(struct stats_hdr *shdr, uint8_t size, uint8_t cnt,
 
     shdr->s_size = size;
     shdr->s_cnt = cnt;
+    shdr->s_flags = 0;
 #if MYNEWT_VAL(STATS_NAMES)
     shdr->s_map = map;
     shdr->s_map_cnt = map_cnt;
+    shdr->s_flags |= stats_map_flags(map, map_cnt, size, cnt);
 #endif
 
     return (0);
@@ -304,6 +561,9 @@ stats_register(char *name, struct stats_hdr *shdr)
     }
 
     shdr->s_name = name;
+#if MYNEWT_VAL(STATS_NEWTMGR)
+    shdr->s_hash = stats_group_hash(shdr);
+#endif
 
     STAILQ_INSERT_TAIL(&g_stats_registry, shdr, s_next);
 
@@ -383,5 +643,9 @@ stats_reset(struct stats_hdr *hdr)
          */
         cur += hdr->s_size;
     }
+
+    if (hdr->s_flags & STATS_HDR_F_RATE) {
+        ((struct stats_rate *)(hdr + 1))->sr_win_cnt = 0;
+    }
     return;
 }
@@ -34,18 +34,24 @@
  */
 static int stats_nmgr_read(struct mgmt_cbuf *cb);
 static int stats_nmgr_list(struct mgmt_cbuf *cb);
+static int stats_nmgr_schema(struct mgmt_cbuf *cb);
+static int stats_nmgr_bulk(struct mgmt_cbuf *cb);
 
 static struct mgmt_group shell_nmgr_group;
 
 #define STATS_NMGR_ID_READ  (0)
 #define STATS_NMGR_ID_LIST  (1)
+#define STATS_NMGR_ID_SCHEMA (2)
+#define STATS_NMGR_ID_BULK  (3)
 
 /* ORDER MATTERS HERE.
  * Each element represents the command ID, referenced from newtmgr.
  */
 static struct mgmt_handler shell_nmgr_group_handlers[] = {
     [STATS_NMGR_ID_READ] = {stats_nmgr_read, stats_nmgr_read},
-    [STATS_NMGR_ID_LIST] = {stats_nmgr_list, stats_nmgr_list}
+    [STATS_NMGR_ID_LIST] = {stats_nmgr_list, stats_nmgr_list},
+    [STATS_NMGR_ID_SCHEMA] = {stats_nmgr_schema, stats_nmgr_schema},
+    [STATS_NMGR_ID_BULK] = {stats_nmgr_bulk, stats_nmgr_bulk}
 };
 
 static int
@@ -161,6 +167,118 @@ stats_nmgr_list(struct mgmt_cbuf *cb)
     return (0);
 }
 
+static int
+stats_nmgr_encode_field_name(struct stats_hdr *hdr, void *arg, char *sname,
+        uint16_t stat_off)
+{
+    CborEncoder *penc = (CborEncoder *) arg;
+
+    return cbor_encode_text_stringz(penc, sname);
+}
+
+/*
+ * Returns the names of all entries of a group, in the same order as the
+ * counter vector returned by the bulk read.  Clients cache the schema keyed
+ * by the group hash, and only need to fetch it again when the hash changes.
+ */
+static int
+stats_nmgr_schema(struct mgmt_cbuf *cb)
+{
+    struct stats_hdr *hdr;
+    char stats_name[STATS_NMGR_NAME_LEN];
+    struct cbor_attr_t attrs[] = {
+        { "name", CborAttrTextStringType, .addr.string = &stats_name[0],
+            .len = sizeof(stats_name) },
+        { NULL },
+    };
+    CborError g_err = CborNoError;
+    CborEncoder *penc = &cb->encoder;
+    CborEncoder rsp, fields;
+
+    g_err = cbor_read_object(&cb->it, attrs);
+    if (g_err != 0) {
+        g_err = MGMT_ERR_EINVAL;
+        goto err;
+    }
+
+    hdr = stats_group_find(stats_name);
+    if (!hdr) {
+        g_err = MGMT_ERR_EINVAL;
+        goto err;
+    }
+
+    g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rsp, "rc");
+    g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
+
+    g_err |= cbor_encode_text_stringz(&rsp, "name");
+    g_err |= cbor_encode_text_stringz(&rsp, stats_name);
+
+    g_err |= cbor_encode_text_stringz(&rsp, "hash");
+    g_err |= cbor_encode_uint(&rsp, hdr->s_hash);
+
+    g_err |= cbor_encode_text_stringz(&rsp, "size");
+    g_err |= cbor_encode_uint(&rsp, hdr->s_size);
+
+    g_err |= cbor_encode_text_stringz(&rsp, "fields");
+    g_err |= cbor_encoder_create_array(&rsp, &fields, CborIndefiniteLength);
+    stats_walk(hdr, stats_nmgr_encode_field_name, &fields);
+    g_err |= cbor_encoder_close_container(&rsp, &fields);
+
+    g_err |= cbor_encoder_close_container(penc, &rsp);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+err:
+    mgmt_cbuf_setoerr(cb, g_err);
+
+    return (0);
+}
+
+static int
+stats_nmgr_encode_vector(struct stats_hdr *hdr, void *arg)
+{
+    CborEncoder *penc = (CborEncoder *) arg;
+    CborError g_err = CborNoError;
+
+    /* Counters are sent in device byte order; the schema gives the size of
+     * each entry.
+     */
+    g_err |= cbor_encode_uint(penc, hdr->s_hash);
+    g_err |= cbor_encode_byte_string(penc, (uint8_t *)hdr + sizeof(*hdr),
+                                     hdr->s_size * hdr->s_cnt);
+
+    return (g_err);
+}
+
+/*
+ * Returns the raw counter vectors of all registered groups, keyed by the
+ * group hash.
+ */
+static int
+stats_nmgr_bulk(struct mgmt_cbuf *cb)
+{
+    CborError g_err = CborNoError;
+    CborEncoder *penc = &cb->encoder;
+    CborEncoder rsp, groups;
+
+    g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rsp, "rc");
+    g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&rsp, "groups");
+    g_err |= cbor_encoder_create_map(&rsp, &groups, CborIndefiniteLength);
+    g_err |= stats_group_walk(stats_nmgr_encode_vector, &groups);
+    g_err |= cbor_encoder_close_container(&rsp, &groups);
+    g_err |= cbor_encoder_close_container(penc, &rsp);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+
 /**
  * Register nmgr group handlers
  */
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdio.h>
+#include "stats_test.h"
+
+STATS_HIST_SECT(stats_test_hist, 32)
+STATS_SECT_DECL(stats_test_hist) stats_test_hist;
+
+struct stats_test_walk {
+    char names[32][16];
+    uint32_t vals[32];
+    int cnt;
+};
+
+static int
+stats_test_walk_func(struct stats_hdr *hdr, void *arg, char *name,
+                     uint16_t off)
+{
+    struct stats_test_walk *w;
+
+    w = arg;
+    TEST_ASSERT_FATAL(w->cnt < 32);
+    TEST_ASSERT(strlen(name) < sizeof(w->names[0]));
+    strncpy(w->names[w->cnt], name, sizeof(w->names[0]) - 1);
+    w->vals[w->cnt] = *(uint32_t *)((uint8_t *)hdr + off);
+    w->cnt++;
+    return 0;
+}
+
+TEST_CASE(stats_test_hist_walk)
+{
+    struct stats_test_walk w;
+    char expect[16];
+    int rc;
+    int i;
+
+    rc = stats_hist_init(STATS_HDR(stats_test_hist), 33);
+    TEST_ASSERT(rc == OS_EINVAL);
+    rc = stats_hist_init(STATS_HDR(stats_test_hist),
+                         STATS_HIST_CNT(stats_test_hist));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    STATS_HIST_ADD(stats_test_hist, 0);
+    STATS_HIST_ADD(stats_test_hist, 3);
+    STATS_HIST_ADD(stats_test_hist, (1UL << 30) - 1);
+    STATS_HIST_ADD(stats_test_hist, 1UL << 30);
+    STATS_HIST_ADD(stats_test_hist, 0xffffffff);
+
+    memset(&w, 0, sizeof(w));
+    rc = stats_walk(STATS_HDR(stats_test_hist), stats_test_walk_func, &w);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(w.cnt == 32);
+
+    /* Every bucket is named by its full upper bound. */
+    for (i = 0; i < 31; i++) {
+        snprintf(expect, sizeof(expect), "le%lu", (1UL << i) - 1);
+        TEST_ASSERT(strcmp(w.names[i], expect) == 0);
+    }
+    TEST_ASSERT(strcmp(w.names[30], "le1073741823") == 0);
+    TEST_ASSERT(strcmp(w.names[31], "inf") == 0);
+
+    TEST_ASSERT(w.vals[0] == 1);
+    TEST_ASSERT(w.vals[2] == 1);
+    TEST_ASSERT(w.vals[30] == 1);
+    TEST_ASSERT(w.vals[31] == 2);
+}
@@ -30,7 +30,11 @@ struct cbmem_entry_hdr {
     uint16_t ceh_flags;
 } __attribute__((packed));
 
+/* Set in ceh_flags once the entry's contents have been written. */
+#define CBMEM_ENTRY_F_READY     (0x0001)
+
 struct cbmem {
+    /* Held by readers.  Appends don't take it. */
     struct os_mutex c_lock;
 
     struct cbmem_entry_hdr *c_entry_start;
@@ -38,6 +42,22 @@ struct cbmem {
     uint8_t *c_buf;
     uint8_t *c_buf_end;
     uint8_t *c_buf_cur_end;
+
+    /* Reader lock nesting count. */
+    uint16_t c_readers;
+    /* Entries reserved but not yet committed. */
+    uint16_t c_pending;
+    /* Appends dropped because they would have evicted an entry in use. */
+    uint32_t c_dropped;
+    /*
+     * Oldest entry the lock holder may still be reading; entries before it
+     * can be evicted.  NULL if it isn't iterating, and then nothing is
+     * evicted while the lock is held.
+     */
+    struct cbmem_entry_hdr *c_read_pos;
+    /* cbmem_flush() waits on this for the pending entries. */
+    struct os_sem c_flush_sem;
+    uint8_t c_flush_wait;
 };
 
 struct cbmem_iter {
@@ -50,6 +70,8 @@ struct cbmem_iter {
         + ((struct cbmem_entry_hdr *) (__p))->ceh_len)
 #define CBMEM_ENTRY_NEXT(__p) ((struct cbmem_entry_hdr *) \
         ((uint8_t *) (__p) + CBMEM_ENTRY_SIZE(__p)))
+#define CBMEM_ENTRY_DATA(__p) ((uint8_t *) (__p) + \
+        sizeof(struct cbmem_entry_hdr))
 
 typedef int (*cbmem_walk_func_t)(struct cbmem *, struct cbmem_entry_hdr *, 
         void *arg);
@@ -58,12 +80,15 @@ int cbmem_lock_acquire(struct cbmem *cbmem);
 int cbmem_lock_release(struct cbmem *cbmem);
 int cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len);
 int cbmem_append(struct cbmem *cbmem, void *data, uint16_t len);
+struct cbmem_entry_hdr *cbmem_reserve(struct cbmem *cbmem, uint16_t len);
+void cbmem_commit(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr);
 void cbmem_iter_start(struct cbmem *cbmem, struct cbmem_iter *iter);
 struct cbmem_entry_hdr *cbmem_iter_next(struct cbmem *cbmem, 
         struct cbmem_iter *iter);
 int cbmem_read(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr, void *buf, 
         uint16_t off, uint16_t len);
 int cbmem_walk(struct cbmem *cbmem, cbmem_walk_func_t walk_func, void *arg);
+uint32_t cbmem_dropped(struct cbmem *cbmem);
 
 int cbmem_flush(struct cbmem *);
 
@@ -22,13 +22,26 @@
 
 #include "cbmem/cbmem.h"
 
+/*
+ * Appends don't take c_lock.  Space for an entry is reserved with
+ * interrupts disabled, which only moves pointers, and the data is copied in
+ * afterwards; the entry is marked ready when it is committed.  Appending
+ * therefore never blocks, and works from interrupt context.
+ *
+ * Readers hold c_lock.  They skip entries which haven't been committed.
+ * Uncommitted entries are never evicted, and neither is the entry a reader
+ * iterating with the lock held is at, or any entry after it; an append
+ * which would need to is dropped instead.  Entries the reader has gone past
+ * are evicted as usual.
+ */
 
 int
 cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len)
 {
+    memset(cbmem, 0, sizeof(*cbmem));
     os_mutex_init(&cbmem->c_lock);
+    os_sem_init(&cbmem->c_flush_sem, 0);
 
-    memset(cbmem, 0, sizeof(*cbmem));
     cbmem->c_buf = buf;
     cbmem->c_buf_end = buf + buf_len;
 
@@ -38,16 +51,19 @@ cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len)
 int
 cbmem_lock_acquire(struct cbmem *cbmem)
 {
+    os_sr_t sr;
     int rc;
 
-    if (!os_started()) {
-        return (0);
+    if (os_started()) {
+        rc = os_mutex_pend(&cbmem->c_lock, OS_WAIT_FOREVER);
+        if (rc != 0) {
+            goto err;
+        }
     }
 
-    rc = os_mutex_pend(&cbmem->c_lock, OS_WAIT_FOREVER);
-    if (rc != 0) {
-        goto err;
-    }
+    OS_ENTER_CRITICAL(sr);
+    cbmem->c_readers++;
+    OS_EXIT_CRITICAL(sr);
 
     return (0);
 err:
@@ -57,15 +73,20 @@ err:
 int
 cbmem_lock_release(struct cbmem *cbmem)
 {
+    os_sr_t sr;
     int rc;
 
-    if (!os_started()) {
-        return (0);
+    OS_ENTER_CRITICAL(sr);
+    if (--cbmem->c_readers == 0) {
+        cbmem->c_read_pos = NULL;
     }
+    OS_EXIT_CRITICAL(sr);
 
-    rc = os_mutex_release(&cbmem->c_lock);
-    if (rc != 0) {
-        goto err;
+    if (os_started()) {
+        rc = os_mutex_release(&cbmem->c_lock);
+        if (rc != 0) {
+            goto err;
+        }
     }
 
     return (0);
@@ -73,86 +94,190 @@ err:
     return (rc);
 }
 
+/*
+ * Entries are evicted oldest first, so stopping at the reader's position
+ * keeps it and everything after it.
+ */
+static int
+cbmem_evictable(struct cbmem *cbmem, uint8_t *entry)
+{
+    struct cbmem_entry_hdr *hdr;
+
+    hdr = (struct cbmem_entry_hdr *) entry;
+    if (!(hdr->ceh_flags & CBMEM_ENTRY_F_READY)) {
+        return 0;
+    }
+    if (cbmem->c_readers == 0) {
+        return 1;
+    }
+    return cbmem->c_read_pos != NULL && hdr != cbmem->c_read_pos;
+}
 
-int
-cbmem_append(struct cbmem *cbmem, void *data, uint16_t len)
+/**
+ * Reserves space for an entry, evicting the oldest entries if needed.  The
+ * caller fills in CBMEM_ENTRY_DATA(hdr) and then calls cbmem_commit().  May
+ * be called from interrupt context.
+ *
+ * @param cbmem                 The buffer to append to.
+ * @param len                   Length of the entry's data.
+ *
+ * @return                      The new entry's header; NULL if the entry
+ *                                  doesn't fit, or if making room would
+ *                                  evict an entry which is in use.
+ */
+struct cbmem_entry_hdr *
+cbmem_reserve(struct cbmem *cbmem, uint16_t len)
 {
     struct cbmem_entry_hdr *dst;
+    uint8_t *cur_end;
     uint8_t *start;
     uint8_t *end;
-    int rc;
+    uint8_t *p;
+    os_sr_t sr;
 
-    rc = cbmem_lock_acquire(cbmem);
-    if (rc != 0) {
-        goto err;
+    if (sizeof(*dst) + len > cbmem->c_buf_end - cbmem->c_buf) {
+        return (NULL);
     }
 
+    OS_ENTER_CRITICAL(sr);
+
     if (cbmem->c_entry_end) {
         dst = CBMEM_ENTRY_NEXT(cbmem->c_entry_end);
     } else {
         dst = (struct cbmem_entry_hdr *) cbmem->c_buf;
     }
     end = (uint8_t *) dst + len + sizeof(*dst);
+    start = (uint8_t *) cbmem->c_entry_start;
+    cur_end = cbmem->c_buf_cur_end;
 
     /* If this item would take us past the end of this buffer, then adjust
-     * the item to the beginning of the buffer.
+     * the item to the beginning of the buffer.  Entries past the new end of
+     * the buffer are dropped.
      */
     if (end > cbmem->c_buf_end) {
-        cbmem->c_buf_cur_end = (uint8_t *) dst;
+        if (start && start >= (uint8_t *) dst) {
+            for (p = start; p < cur_end; p = (uint8_t *) CBMEM_ENTRY_NEXT(p)) {
+                if (!cbmem_evictable(cbmem, p)) {
+                    goto drop;
+                }
+            }
+            start = cbmem->c_buf;
+        }
+        cur_end = (uint8_t *) dst;
         dst = (struct cbmem_entry_hdr *) cbmem->c_buf;
         end = (uint8_t *) dst + len + sizeof(*dst);
-        if ((uint8_t *) cbmem->c_entry_start >= cbmem->c_buf_cur_end) {
-            cbmem->c_entry_start = (struct cbmem_entry_hdr *) cbmem->c_buf;
-        }
     }
 
     /* If the destination is prior to the start, and would overrwrite the
      * start of the buffer, move start forward until you don't overwrite it
      * anymore.
      */
-    start = (uint8_t *) cbmem->c_entry_start;
     if (start && (uint8_t *) dst < start + CBMEM_ENTRY_SIZE(start) &&
             end > start) {
         while (start < end) {
+            if (!cbmem_evictable(cbmem, start)) {
+                goto drop;
+            }
             start = (uint8_t *) CBMEM_ENTRY_NEXT(start);
-            if (start == cbmem->c_buf_cur_end) {
+            if (start == cur_end) {
                 start = cbmem->c_buf;
                 break;
             }
         }
-        cbmem->c_entry_start = (struct cbmem_entry_hdr *) start;
     }
 
-    /* Copy the entry into the log
-     */
     dst->ceh_len = len;
-    memcpy((uint8_t *) dst + sizeof(*dst), data, len);
+    dst->ceh_flags = 0;
 
+    cbmem->c_buf_cur_end = cur_end;
     cbmem->c_entry_end = dst;
-    if (!cbmem->c_entry_start) {
+    if (start) {
+        cbmem->c_entry_start = (struct cbmem_entry_hdr *) start;
+    } else {
         cbmem->c_entry_start = dst;
     }
+    cbmem->c_pending++;
 
-    rc = cbmem_lock_release(cbmem);
-    if (rc != 0) {
-        goto err;
+    OS_EXIT_CRITICAL(sr);
+
+    return (dst);
+
+drop:
+    cbmem->c_dropped++;
+    OS_EXIT_CRITICAL(sr);
+
+    return (NULL);
+}
+
+/**
+ * Marks an entry returned by cbmem_reserve() as written, making it visible
+ * to readers.
+ */
+void
+cbmem_commit(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr)
+{
+    os_sr_t sr;
+
+    int wake;
+
+    OS_ENTER_CRITICAL(sr);
+    hdr->ceh_flags |= CBMEM_ENTRY_F_READY;
+    cbmem->c_pending--;
+    wake = cbmem->c_pending == 0 && cbmem->c_flush_wait;
+    if (wake) {
+        cbmem->c_flush_wait = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (wake) {
+        os_sem_release(&cbmem->c_flush_sem);
+    }
+}
+
+/**
+ * Returns the number of appends dropped because making room would have
+ * evicted an entry in use.
+ */
+uint32_t
+cbmem_dropped(struct cbmem *cbmem)
+{
+    return cbmem->c_dropped;
+}
+
+
+int
+cbmem_append(struct cbmem *cbmem, void *data, uint16_t len)
+{
+    struct cbmem_entry_hdr *dst;
+
+    dst = cbmem_reserve(cbmem, len);
+    if (dst == NULL) {
+        return (-1);
     }
 
+    memcpy(CBMEM_ENTRY_DATA(dst), data, len);
+    cbmem_commit(cbmem, dst);
+
     return (0);
-err:
-    return (-1);
 }
 
 void
 cbmem_iter_start(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
     iter->ci_start = cbmem->c_entry_start;
     iter->ci_cur = cbmem->c_entry_start;
     iter->ci_end = cbmem->c_entry_end;
+    if (cbmem->c_readers) {
+        cbmem->c_read_pos = cbmem->c_entry_start;
+    }
+    OS_EXIT_CRITICAL(sr);
 }
 
-struct cbmem_entry_hdr *
-cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
+static struct cbmem_entry_hdr *
+cbmem_iter_next_any(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
     struct cbmem_entry_hdr *hdr;
 
@@ -181,9 +306,28 @@ err:
     return (hdr);
 }
 
+struct cbmem_entry_hdr *
+cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
+{
+    struct cbmem_entry_hdr *hdr;
+
+    /* Skip entries which are still being written. */
+    do {
+        hdr = cbmem_iter_next_any(cbmem, iter);
+    } while (hdr != NULL && !(hdr->ceh_flags & CBMEM_ENTRY_F_READY));
+
+    /* Entries before this one may now be evicted. */
+    if (hdr != NULL && cbmem->c_readers) {
+        cbmem->c_read_pos = hdr;
+    }
+
+    return (hdr);
+}
+
 int
 cbmem_flush(struct cbmem *cbmem)
 {
+    os_sr_t sr;
     int rc;
 
     rc = cbmem_lock_acquire(cbmem);
@@ -191,9 +335,27 @@ cbmem_flush(struct cbmem *cbmem)
         goto err;
     }
 
+    /* Space which is still being written to can't be reused; let those
+     * writers finish first.  The last one to commit wakes us up.  Before
+     * the OS runs, only interrupts can be writing; spin until they're done.
+     */
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        if (cbmem->c_pending == 0) {
+            break;
+        }
+        cbmem->c_flush_wait = os_started();
+        OS_EXIT_CRITICAL(sr);
+        if (os_started()) {
+            os_sem_pend(&cbmem->c_flush_sem, OS_TIMEOUT_NEVER);
+        }
+    }
+
     cbmem->c_entry_start = NULL;
     cbmem->c_entry_end = NULL;
     cbmem->c_buf_cur_end = NULL;
+    cbmem->c_read_pos = NULL;
+    OS_EXIT_CRITICAL(sr);
 
     rc = cbmem_lock_release(cbmem);
     if (rc != 0) {
@@ -0,0 +1,113 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cbmem_test.h"
+
+#define CBMEM2_BUF_SIZE     64
+#define CBMEM2_ENTRY_SIZE   12
+
+static struct cbmem cbmem2;
+static uint8_t cbmem2_buf[CBMEM2_BUF_SIZE];
+
+static int
+cbmem_test_case_4_append(uint8_t id)
+{
+    uint8_t entry[CBMEM2_ENTRY_SIZE];
+
+    memset(entry, id, sizeof(entry));
+    return cbmem_append(&cbmem2, entry, sizeof(entry));
+}
+
+static void
+cbmem_test_case_4_check(const uint8_t *ids, int cnt)
+{
+    struct cbmem_entry_hdr *hdr;
+    struct cbmem_iter iter;
+    int i;
+
+    i = 0;
+    cbmem_iter_start(&cbmem2, &iter);
+    while ((hdr = cbmem_iter_next(&cbmem2, &iter)) != NULL) {
+        TEST_ASSERT_FATAL(i < cnt);
+        TEST_ASSERT(hdr->ceh_len == CBMEM2_ENTRY_SIZE);
+        TEST_ASSERT(CBMEM_ENTRY_DATA(hdr)[0] == ids[i]);
+        i++;
+    }
+    TEST_ASSERT(i == cnt);
+}
+
+TEST_CASE(cbmem_test_case_4)
+{
+    struct cbmem_entry_hdr *a;
+    struct cbmem_entry_hdr *b;
+    uint8_t big[CBMEM2_BUF_SIZE];
+    int rc;
+
+    /* The buffer holds exactly four entries. */
+    rc = cbmem_init(&cbmem2, cbmem2_buf, sizeof(cbmem2_buf));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Entries which are still being written are skipped by readers. */
+    a = cbmem_reserve(&cbmem2, CBMEM2_ENTRY_SIZE);
+    TEST_ASSERT_FATAL(a != NULL);
+    memset(CBMEM_ENTRY_DATA(a), 0, CBMEM2_ENTRY_SIZE);
+    TEST_ASSERT(cbmem_test_case_4_append(1) == 0);
+    TEST_ASSERT(cbmem_test_case_4_append(2) == 0);
+    cbmem_test_case_4_check((uint8_t[]){ 1, 2 }, 2);
+
+    cbmem_commit(&cbmem2, a);
+    cbmem_test_case_4_check((uint8_t[]){ 0, 1, 2 }, 3);
+
+    /* Wrap around, leaving an uncommitted entry at the start. */
+    TEST_ASSERT(cbmem_test_case_4_append(3) == 0);
+    b = cbmem_reserve(&cbmem2, CBMEM2_ENTRY_SIZE);
+    TEST_ASSERT_FATAL(b == (struct cbmem_entry_hdr *) cbmem2_buf);
+    memset(CBMEM_ENTRY_DATA(b), 4, CBMEM2_ENTRY_SIZE);
+    TEST_ASSERT(cbmem_test_case_4_append(5) == 0);
+    TEST_ASSERT(cbmem_test_case_4_append(6) == 0);
+    TEST_ASSERT(cbmem_test_case_4_append(7) == 0);
+    cbmem_test_case_4_check((uint8_t[]){ 5, 6, 7 }, 3);
+
+    /* It isn't evicted until committed. */
+    TEST_ASSERT(cbmem_test_case_4_append(8) != 0);
+    TEST_ASSERT(cbmem_dropped(&cbmem2) == 1);
+    cbmem_commit(&cbmem2, b);
+    cbmem_test_case_4_check((uint8_t[]){ 4, 5, 6, 7 }, 4);
+    TEST_ASSERT(cbmem_test_case_4_append(8) == 0);
+    cbmem_test_case_4_check((uint8_t[]){ 5, 6, 7, 8 }, 4);
+
+    /* Nothing is evicted while a reader holds the lock, not iterating. */
+    rc = cbmem_lock_acquire(&cbmem2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(cbmem_test_case_4_append(9) != 0);
+    TEST_ASSERT(cbmem_dropped(&cbmem2) == 2);
+    rc = cbmem_lock_release(&cbmem2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(cbmem_test_case_4_append(9) == 0);
+    cbmem_test_case_4_check((uint8_t[]){ 6, 7, 8, 9 }, 4);
+
+    /* An entry bigger than the buffer is refused. */
+    TEST_ASSERT(cbmem_append(&cbmem2, big, sizeof(big)) != 0);
+    cbmem_test_case_4_check((uint8_t[]){ 6, 7, 8, 9 }, 4);
+
+    rc = cbmem_flush(&cbmem2);
+    TEST_ASSERT(rc == 0);
+    cbmem_test_case_4_check(NULL, 0);
+    TEST_ASSERT(cbmem2.c_readers == 0);
+    TEST_ASSERT(cbmem2.c_pending == 0);
+}
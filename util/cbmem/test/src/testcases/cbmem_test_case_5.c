@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cbmem_test.h"
+
+#define CBMEM3_BUF_SIZE     64
+#define CBMEM3_ENTRY_SIZE   12
+
+static struct cbmem cbmem3;
+static uint8_t cbmem3_buf[CBMEM3_BUF_SIZE];
+
+static int
+cbmem_test_case_5_append(uint8_t id)
+{
+    uint8_t entry[CBMEM3_ENTRY_SIZE];
+
+    memset(entry, id, sizeof(entry));
+    return cbmem_append(&cbmem3, entry, sizeof(entry));
+}
+
+static uint8_t
+cbmem_test_case_5_next(struct cbmem_iter *iter)
+{
+    struct cbmem_entry_hdr *hdr;
+    uint8_t id;
+    int rc;
+
+    hdr = cbmem_iter_next(&cbmem3, iter);
+    TEST_ASSERT_FATAL(hdr != NULL);
+    rc = cbmem_read(&cbmem3, hdr, &id, CBMEM3_ENTRY_SIZE - 1, sizeof(id));
+    TEST_ASSERT_FATAL(rc == sizeof(id));
+    return id;
+}
+
+TEST_CASE(cbmem_test_case_5)
+{
+    struct cbmem_iter iter;
+    uint32_t dropped;
+    int rc;
+    int i;
+
+    /* The buffer holds exactly four entries. */
+    rc = cbmem_init(&cbmem3, cbmem3_buf, sizeof(cbmem3_buf));
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 1; i <= 4; i++) {
+        TEST_ASSERT_FATAL(cbmem_test_case_5_append(i) == 0);
+    }
+    dropped = cbmem_dropped(&cbmem3);
+
+    /*
+     * While a reader iterates, entries it has gone past are evicted; the
+     * one it is at, and those after it, are not.
+     */
+    rc = cbmem_lock_acquire(&cbmem3);
+    TEST_ASSERT_FATAL(rc == 0);
+    cbmem_iter_start(&cbmem3, &iter);
+
+    TEST_ASSERT(cbmem_test_case_5_append(5) != 0);
+    TEST_ASSERT(cbmem_dropped(&cbmem3) == dropped + 1);
+
+    TEST_ASSERT(cbmem_test_case_5_next(&iter) == 1);
+    TEST_ASSERT(cbmem_test_case_5_append(5) != 0);
+    TEST_ASSERT(cbmem_dropped(&cbmem3) == dropped + 2);
+
+    TEST_ASSERT(cbmem_test_case_5_next(&iter) == 2);
+    TEST_ASSERT(cbmem_test_case_5_append(5) == 0);
+    TEST_ASSERT(cbmem_test_case_5_append(6) != 0);
+
+    TEST_ASSERT(cbmem_test_case_5_next(&iter) == 3);
+    TEST_ASSERT(cbmem_test_case_5_append(6) == 0);
+    TEST_ASSERT(cbmem_test_case_5_next(&iter) == 4);
+    TEST_ASSERT(cbmem_iter_next(&cbmem3, &iter) == NULL);
+    TEST_ASSERT(cbmem_dropped(&cbmem3) == dropped + 3);
+
+    rc = cbmem_lock_release(&cbmem3);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Iterating without the lock doesn't hold anything back. */
+    cbmem_iter_start(&cbmem3, &iter);
+    TEST_ASSERT(cbmem_test_case_5_next(&iter) == 3);
+    TEST_ASSERT(cbmem_test_case_5_append(7) == 0);
+    TEST_ASSERT(cbmem_dropped(&cbmem3) == dropped + 3);
+
+    cbmem_iter_start(&cbmem3, &iter);
+    TEST_ASSERT(cbmem_test_case_5_next(&iter) == 4);
+    TEST_ASSERT(cbmem_test_case_5_next(&iter) == 5);
+    TEST_ASSERT(cbmem_test_case_5_next(&iter) == 6);
+    TEST_ASSERT(cbmem_test_case_5_next(&iter) == 7);
+    TEST_ASSERT(cbmem_iter_next(&cbmem3, &iter) == NULL);
+}
@@ -0,0 +1,50 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _UTIL_CRC_HW_H_
+#define _UTIL_CRC_HW_H_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * CRC peripheral hooks.  With CRC_HW enabled, an MCU or BSP package can
+ * register functions which crc16_ccitt() and crc8_calc() hand buffers of
+ * CRC_HW_MIN_LEN bytes or more to.  They must give the same result as the
+ * software versions, and serialize access to the peripheral themselves.
+ * Either may be NULL if the peripheral can't do that CRC.
+ */
+struct crc_hw_funcs {
+    uint16_t (*chf_crc16_ccitt)(uint16_t initial_crc, const void *buf,
+                                int len);
+    uint8_t (*chf_crc8)(uint8_t val, const void *buf, int cnt);
+};
+
+extern const struct crc_hw_funcs *crc_hw;
+
+void crc_hw_register(const struct crc_hw_funcs *funcs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
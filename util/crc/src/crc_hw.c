@@ -0,0 +1,39 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stddef.h>
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(CRC_HW)
+
+#include "crc/crc_hw.h"
+
+const struct crc_hw_funcs *crc_hw;
+
+/**
+ * Registers CRC peripheral functions.  Call at init time, before the CRC
+ * functions are in use; NULL goes back to software.
+ */
+void
+crc_hw_register(const struct crc_hw_funcs *funcs)
+{
+    crc_hw = funcs;
+}
+
+#endif